@@ -0,0 +1,471 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "myjson.h"
+
+// Benchmark over synthetic corpora generated from a fixed seed, so that two
+// builds always measure the same bytes.
+//
+//   myjson_bench [--iterations N] [--scale F] [--json FILE] [--csv FILE]
+//
+// Every operation is timed once per iteration; the report gives the median
+// throughput and the p50/p90/p99 latency of one iteration, plus the malloc
+// calls and bytes requested per iteration when the build can count them.
+
+#if defined(BENCH_COUNT_ALLOCS)
+// Linked with -Wl,--wrap for malloc, calloc and realloc, see CMakeLists.txt.
+// Workers of json_parse_ndjson() allocate concurrently.
+static size_t alloc_calls, alloc_bytes;
+
+#define COUNT_ALLOC(size) \
+    do { \
+        __atomic_fetch_add(&alloc_calls, 1, __ATOMIC_RELAXED); \
+        __atomic_fetch_add(&alloc_bytes, (size), __ATOMIC_RELAXED); \
+    } while(0)
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    COUNT_ALLOC(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    COUNT_ALLOC(n * size);
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+    COUNT_ALLOC(size);
+    return __real_realloc(p, size);
+}
+#else
+static size_t alloc_calls, alloc_bytes;
+#endif
+
+// Objects up to this many keys are scanned, not hashed. Kept in step with
+// the default of the same macro in myjson.c.
+#ifndef JSON_OBJECT_INDEX_THRESHOLD
+#define JSON_OBJECT_INDEX_THRESHOLD 16
+#endif
+
+// Corpus Begin
+typedef struct {
+    char* s;
+    size_t len, cap;
+} buffer;
+
+static void put(buffer* b, const char* fmt, ...) {
+    va_list ap;
+    int n;
+    if (b->cap - b->len < 256) {
+        b->cap = b->cap == 0 ? 1 << 16 : b->cap * 2;
+        b->s = (char*)realloc(b->s, b->cap);
+    }
+    va_start(ap, fmt);
+    n = vsnprintf(b->s + b->len, b->cap - b->len, fmt, ap);
+    va_end(ap);
+    if ((size_t)n >= b->cap - b->len) {
+        while ((size_t)n >= b->cap - b->len)
+            b->cap *= 2;
+        b->s = (char*)realloc(b->s, b->cap);
+        va_start(ap, fmt);
+        vsnprintf(b->s + b->len, b->cap - b->len, fmt, ap);
+        va_end(ap);
+    }
+    b->len += n;
+}
+
+// Park-Miller, the same sequence on every platform.
+static unsigned long seed;
+
+static unsigned long next_random(void) {
+    seed = seed * 48271 % 2147483647;
+    return seed;
+}
+
+static double random_unit(void) {
+    return (double)next_random() / 2147483647.0;
+}
+
+// Number heavy, shaped like canada.json: polygons of coordinate pairs.
+static void gen_numbers(buffer* b, double scale) {
+    size_t i, j, rings = (size_t)(40 * scale) + 1;
+    put(b, "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\","
+        "\"properties\":{\"name\":\"Canada\"},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[");
+    for (i = 0; i < rings; i++) {
+        put(b, "%s[", i ? "," : "");
+        for (j = 0; j < 1000; j++)
+            put(b, "%s[%.15g,%.15g]", j ? "," : "", -141.0 + 88.0 * random_unit(), 41.0 + 42.0 * random_unit());
+        put(b, "]");
+    }
+    put(b, "]}}]}");
+}
+
+// String heavy with multi-byte UTF-8 and escapes, shaped like twitter.json.
+static void gen_strings(buffer* b, double scale) {
+    static const char* words[] = {
+        "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog",
+        "caf\xC3\xA9", "na\xC3\xAFve", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E", "\xF0\x9F\x98\x80",
+        "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82", "line\\nbreak", "tab\\tbed", "\\u00e9t\\u00e9"
+    };
+    size_t i, j, w, n = (size_t)(2000 * scale) + 1;
+    put(b, "{\"statuses\":[");
+    for (i = 0; i < n; i++) {
+        put(b, "%s{\"id\":%lu,\"id_str\":\"%lu\",\"text\":\"", i ? "," : "",
+            (unsigned long)(500000000 + i), (unsigned long)(500000000 + i));
+        for (j = 0, w = 8 + next_random() % 20; j < w; j++)
+            put(b, "%s%s", j ? " " : "", words[next_random() % 16]);
+        put(b, "\",\"user\":{\"id\":%lu,\"screen_name\":\"user_%lu\",\"lang\":\"ja\","
+            "\"description\":\"%s %s %s\",\"followers_count\":%lu,\"verified\":%s},"
+            "\"retweet_count\":%lu,\"favorited\":false,\"entities\":{\"hashtags\":[],\"urls\":[]},"
+            "\"in_reply_to_status_id\":null}",
+            next_random() % 100000, next_random() % 100000,
+            words[next_random() % 16], words[next_random() % 16], words[next_random() % 16],
+            next_random() % 10000, next_random() % 2 ? "true" : "false", next_random() % 500);
+    }
+    put(b, "]}");
+}
+
+// Many small, deeply nested documents in one array.
+static void gen_nested(buffer* b, double scale) {
+    size_t i, j, n = (size_t)(3000 * scale) + 1, depth = 64;
+    put(b, "[");
+    for (i = 0; i < n; i++) {
+        put(b, "%s", i ? "," : "");
+        for (j = 0; j < depth; j++)
+            put(b, j % 2 ? "[" : "{\"k%u\":", (unsigned)j);
+        put(b, "%lu", next_random());
+        for (j = depth; j-- > 0;)
+            put(b, j % 2 ? "]" : "}");
+    }
+    put(b, "]");
+}
+
+// One object with a lot of keys.
+static void gen_wide(buffer* b, double scale) {
+    size_t i, n = (size_t)(50000 * scale) + 1;
+    put(b, "{");
+    for (i = 0; i < n; i++)
+        put(b, "%s\"field_%lu_%lu\":%lu", i ? "," : "", (unsigned long)i, next_random() % 1000, next_random() % 100000);
+    put(b, "}");
+}
+
+// Newline-delimited records.
+static void gen_ndjson(buffer* b, double scale) {
+    size_t i, n = (size_t)(50000 * scale) + 1;
+    for (i = 0; i < n; i++)
+        put(b, "{\"id\":%lu,\"event\":\"click\",\"ts\":%lu.%03lu,\"tags\":[\"a\",\"b\"],\"ok\":%s}\n",
+            (unsigned long)i, 1700000000 + next_random() % 1000000, next_random() % 1000,
+            next_random() % 2 ? "true" : "false");
+}
+// Corpus End
+
+// Timing Begin
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+typedef struct {
+    const char* corpus;
+    const char* op;
+    size_t bytes, docs;   // Per iteration
+    int iterations;
+    double mb_s, ns_doc;  // From the median, mb_s < 0 when undefined
+    double p50, p90, p99; // Microseconds per iteration
+    double mallocs, malloc_bytes;
+} result;
+
+static result results[64];
+static size_t result_count;
+
+static double percentile(const double* sorted, int n, double p) {
+    int i = (int)(p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+static void record(const char* corpus, const char* op, size_t bytes, size_t docs, double* t, int n,
+    size_t calls, size_t abytes) {
+    result* r = &results[result_count++];
+    qsort(t, n, sizeof(double), compare_double);
+    r->corpus = corpus;
+    r->op = op;
+    r->bytes = bytes;
+    r->docs = docs;
+    r->iterations = n;
+    r->p50 = percentile(t, n, 0.50) * 1e6;
+    r->p90 = percentile(t, n, 0.90) * 1e6;
+    r->p99 = percentile(t, n, 0.99) * 1e6;
+    // No bytes go through some ops, and a median under the clock's
+    // resolution has no rate either
+    r->mb_s = bytes != 0 && r->p50 > 0 ? bytes / (r->p50 * 1e-6) / 1e6 : -1.0;
+    r->ns_doc = r->p50 * 1e3 / docs;
+    r->mallocs = (double)calls / n;
+    r->malloc_bytes = (double)abytes / n;
+    if (r->mb_s >= 0)
+        printf("%-8s %-18s %10.1f MB/s", r->corpus, r->op, r->mb_s);
+    else
+        printf("%-8s %-18s %10s MB/s", r->corpus, r->op, "-");
+    printf(" %12.0f ns/doc  p50 %10.1f us  p90 %10.1f us  p99 %10.1f us  %12.0f mallocs %14.0f bytes\n",
+        r->ns_doc, r->p50, r->p90, r->p99, r->mallocs, r->malloc_bytes);
+}
+// Timing End
+
+// Operations Begin
+static int ndjson_check(void* user, size_t line, int ret, json_value* v) {
+    (void)line;
+    (void)v;
+    if (ret != JSON_PARSE_OK)
+        ++*(size_t*)user;
+    return 0;
+}
+
+static int ndjson_ignore(void* user, size_t line, int ret, json_value* v) {
+    (void)user;
+    (void)line;
+    (void)ret;
+    (void)v;
+    return 0;
+}
+
+static void bench_document(const char* name, const buffer* b, int iterations) {
+    double* t = (double*)malloc(sizeof(double) * iterations);
+    json_value v;
+    char* out = NULL;
+    char* pretty = NULL;
+    size_t size = 0, len = 0, calls, abytes, docs = 1, i, pretty_size = 0, pretty_len;
+    int k;
+
+    if (json_parse_n(&v, b->s, b->len) != JSON_PARSE_OK) {
+        fprintf(stderr, "%s: corpus does not parse\n", name);
+        exit(1);
+    }
+    if (json_get_type(&v) == JSON_ARRAY)
+        docs = json_get_array_size(&v);
+    pretty_len = json_stringify_to(&v, &pretty, &pretty_size, JSON_STRINGIFY_PRETTY);
+    json_free(&v);
+
+    calls = alloc_calls;
+    abytes = alloc_bytes;
+    for (k = 0; k < iterations; k++) {
+        double s = now();
+        json_parse_n(&v, b->s, b->len);
+        t[k] = now() - s;
+        json_free(&v);
+    }
+    record(name, "parse", b->len, docs, t, iterations, alloc_calls - calls, alloc_bytes - abytes);
+
+    // The same tree from indented text, MB/s against the indented size
+    calls = alloc_calls;
+    abytes = alloc_bytes;
+    for (k = 0; k < iterations; k++) {
+        double s = now();
+        json_parse_n(&v, pretty, pretty_len);
+        t[k] = now() - s;
+        json_free(&v);
+    }
+    record(name, "parse_pretty", pretty_len, docs, t, iterations, alloc_calls - calls, alloc_bytes - abytes);
+    free(pretty);
+
+    for (k = 0; k < iterations; k++) {
+        double s;
+        json_parse_n(&v, b->s, b->len);
+        s = now();
+        json_free(&v);
+        t[k] = now() - s;
+    }
+    record(name, "free", b->len, docs, t, iterations, 0, 0);
+
+    json_parse_n(&v, b->s, b->len);
+    calls = alloc_calls;
+    abytes = alloc_bytes;
+    for (k = 0; k < iterations; k++) {
+        double s = now();
+        len = json_stringify_to(&v, &out, &size, 0);
+        t[k] = now() - s;
+    }
+    record(name, "stringify", len, docs, t, iterations, alloc_calls - calls, alloc_bytes - abytes);
+
+    // MB/s of the CBOR rows are against the text size, to compare with parse
+    calls = alloc_calls;
+    abytes = alloc_bytes;
+    for (k = 0; k < iterations; k++) {
+        double s = now();
+        len = json_cbor_encode_to(&v, &out, &size);
+        t[k] = now() - s;
+    }
+    record(name, "cbor_encode", b->len, docs, t, iterations, alloc_calls - calls, alloc_bytes - abytes);
+    json_free(&v);
+    calls = alloc_calls;
+    abytes = alloc_bytes;
+    for (k = 0; k < iterations; k++) {
+        double s = now();
+        json_cbor_decode(&v, out, len);
+        t[k] = now() - s;
+        if (k + 1 < iterations)
+            json_free(&v);
+    }
+    record(name, "cbor_decode", b->len, docs, t, iterations, alloc_calls - calls, alloc_bytes - abytes);
+    printf("%-8s %-18s %10zu bytes as text, %zu as CBOR\n", name, "size", b->len, len);
+
+    // Look every key of the root object up once, the first pass builds the
+    // index. Only a root wide enough to be hashed says anything. The keys are
+    // copies, the object's own pointers would match without hashing.
+    if (json_get_type(&v) == JSON_OBJECT && json_get_object_size(&v) > JSON_OBJECT_INDEX_THRESHOLD) {
+        size_t n = json_get_object_size(&v), found = 0, total = 0;
+        size_t* offsets = (size_t*)malloc(sizeof(size_t) * (n + 1));
+        char* keys;
+        for (i = 0; i < n; i++) {
+            offsets[i] = total;
+            total += json_get_object_key_length(&v, i);
+        }
+        offsets[n] = total;
+        keys = (char*)malloc(total + 1);
+        for (i = 0; i < n; i++)
+            memcpy(keys + offsets[i], json_get_object_key(&v, i), offsets[i + 1] - offsets[i]);
+        calls = alloc_calls;
+        abytes = alloc_bytes;
+        for (k = 0; k < iterations; k++) {
+            double s = now();
+            for (i = 0; i < n; i++)
+                found += json_find_object_index(&v, keys + offsets[i], offsets[i + 1] - offsets[i]) == i;
+            t[k] = now() - s;
+        }
+        if (found != n * iterations)
+            fprintf(stderr, "%s: lookup mismatch\n", name);
+        record(name, "lookup", 0, n, t, iterations, alloc_calls - calls, alloc_bytes - abytes);
+        free(keys);
+        free(offsets);
+    }
+    json_free(&v);
+    free(out);
+    free(t);
+}
+
+static void bench_ndjson(const char* name, const buffer* b, int iterations) {
+    double* t = (double*)malloc(sizeof(double) * iterations);
+    size_t calls = alloc_calls, abytes = alloc_bytes, errors = 0, lines = 0, i;
+    int k;
+    for (i = 0; i < b->len; i++)
+        lines += b->s[i] == '\n';
+    // Checked once on one thread, the timed runs use every CPU
+    json_parse_ndjson(b->s, b->len, 1, ndjson_check, &errors);
+    if (errors != 0)
+        fprintf(stderr, "%s: %lu lines failed\n", name, (unsigned long)errors);
+    calls = alloc_calls;
+    abytes = alloc_bytes;
+    for (k = 0; k < iterations; k++) {
+        double s = now();
+        json_parse_ndjson(b->s, b->len, 0, ndjson_ignore, NULL);
+        t[k] = now() - s;
+    }
+    record(name, "parse_ndjson", b->len, lines, t, iterations, alloc_calls - calls, alloc_bytes - abytes);
+    free(t);
+}
+// Operations End
+
+// Report Begin
+static void write_json(const char* path) {
+    FILE* f = fopen(path, "w");
+    size_t i;
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "[\n");
+    for (i = 0; i < result_count; i++) {
+        const result* r = &results[i];
+        fprintf(f, "  {\"corpus\":\"%s\",\"op\":\"%s\",\"bytes\":%lu,\"docs\":%lu,\"iterations\":%d,",
+            r->corpus, r->op, (unsigned long)r->bytes, (unsigned long)r->docs, r->iterations);
+        if (r->mb_s >= 0)
+            fprintf(f, "\"mb_s\":%.3f,", r->mb_s);
+        else
+            fprintf(f, "\"mb_s\":null,");
+        fprintf(f, "\"ns_doc\":%.1f,\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,"
+            "\"mallocs\":%.1f,\"malloc_bytes\":%.1f}%s\n",
+            r->ns_doc, r->p50, r->p90, r->p99, r->mallocs, r->malloc_bytes,
+            i + 1 < result_count ? "," : "");
+    }
+    fprintf(f, "]\n");
+    fclose(f);
+}
+
+static void write_csv(const char* path) {
+    FILE* f = fopen(path, "w");
+    size_t i;
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "corpus,op,bytes,docs,iterations,mb_s,ns_doc,p50_us,p90_us,p99_us,mallocs,malloc_bytes\n");
+    for (i = 0; i < result_count; i++) {
+        const result* r = &results[i];
+        fprintf(f, "%s,%s,%lu,%lu,%d,", r->corpus, r->op, (unsigned long)r->bytes, (unsigned long)r->docs, r->iterations);
+        if (r->mb_s >= 0) // Left empty when undefined
+            fprintf(f, "%.3f", r->mb_s);
+        fprintf(f, ",%.1f,%.3f,%.3f,%.3f,%.1f,%.1f\n",
+            r->ns_doc, r->p50, r->p90, r->p99, r->mallocs, r->malloc_bytes);
+    }
+    fclose(f);
+}
+// Report End
+
+int main(int argc, char** argv) {
+    static void (*const generators[])(buffer*, double) = { gen_numbers, gen_strings, gen_nested, gen_wide };
+    static const char* names[] = { "numbers", "strings", "nested", "wide" };
+    const char* json_path = NULL;
+    const char* csv_path = NULL;
+    double scale = 1.0;
+    int iterations = 20, i;
+    buffer b;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+            scale = atof(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            json_path = argv[++i];
+        else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csv_path = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--iterations N] [--scale F] [--json FILE] [--csv FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1)
+        iterations = 1;
+
+    for (i = 0; i < 4; i++) {
+        memset(&b, 0, sizeof(b));
+        seed = 20240601 + i;
+        generators[i](&b, scale);
+        bench_document(names[i], &b, iterations);
+        free(b.s);
+    }
+    memset(&b, 0, sizeof(b));
+    seed = 20240605;
+    gen_ndjson(&b, scale);
+    bench_ndjson("ndjson", &b, iterations);
+    free(b.s);
+
+#if !defined(BENCH_COUNT_ALLOCS)
+    printf("(malloc counting is not available in this build)\n");
+#endif
+    if (json_path != NULL)
+        write_json(json_path);
+    if (csv_path != NULL)
+        write_csv(csv_path);
+    return 0;
+}
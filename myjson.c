@@ -1,12 +1,130 @@
+// mmap(), posix_madvise() and pthreads are POSIX.1-2001, ask for them before
+// any system header so strict -std=c99/c11 builds still see them.
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
 #include "myjson.h"
 #include <assert.h>  /* assert() */
 #include <stdlib.h>  /* NULL, strtod()*/
 #include <string.h>
+#include <stdint.h>  /* uint64_t */
+#include <float.h>   /* FLT_EVAL_METHOD */
+#include <locale.h>  /* localeconv() */
+#include <math.h>    /* HUGE_VAL */
+#include <stdio.h>   /* FILE */
+
+#if !defined(_WIN32)
+#include <fcntl.h>    /* open() */
+#include <sys/mman.h> /* mmap() */
+#include <sys/stat.h> /* fstat() */
+#include <unistd.h>   /* close(), sysconf() */
+#endif
+
+// Worker threads for json_parse_ndjson(), define JSON_NO_THREADS to run it
+// on the calling thread only.
+#if !defined(JSON_NO_THREADS) && !defined(_WIN32)
+#define JSON_THREADS
+#include <pthread.h>
+#endif
+
+// SIMD string scanner, SSE2 is the x86-64 baseline and AVX2 is used when the
+// compiler targets it. Define JSON_NO_SIMD to force the scalar path.
+#ifndef JSON_NO_SIMD
+#if defined(__AVX2__)
+#define JSON_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_SSE2
+#include <emmintrin.h>
+#endif
+// Byte shuffles for the UTF-8 validator, AVX2 implies them
+#if defined(JSON_AVX2) || (defined(JSON_SSE2) && defined(__SSSE3__))
+#define JSON_SSSE3
+#include <tmmintrin.h>
+#endif
+// Without them at compile time, GCC and Clang still build the validator for
+// SSSE3 and AVX2 and pick one once, by what the CPU has. Define
+// JSON_NO_DISPATCH to keep the plain SSE2 path.
+#if defined(JSON_SSE2) && !defined(JSON_SSSE3) && !defined(JSON_NO_DISPATCH) \
+    && (defined(__GNUC__) || defined(__clang__))
+#define JSON_UTF8_DISPATCH
+#include <immintrin.h>
+#define JSON_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#ifndef JSON_TARGET_SSSE3
+#define JSON_TARGET_SSSE3
+#define JSON_TARGET_AVX2
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define JSON_CTZ(x) __builtin_ctz(x)
+#define JSON_CTZ64(x) __builtin_ctzll(x)
+#define JSON_POPCOUNT64(x) __builtin_popcountll(x)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+static unsigned json_ctz(unsigned x) { unsigned long i; _BitScanForward(&i, x); return (unsigned)i; }
+static unsigned json_ctz64(uint64_t x) { unsigned long i; _BitScanForward64(&i, x); return (unsigned)i; }
+static unsigned json_popcount64(uint64_t x) {
+    x -= (x >> 1) & 0x5555555555555555ULL;
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (unsigned)((x * 0x0101010101010101ULL) >> 56);
+}
+#define JSON_CTZ(x) json_ctz(x)
+#define JSON_CTZ64(x) json_ctz64(x)
+#define JSON_POPCOUNT64(x) json_popcount64(x)
+#endif
+
+// Carry-less multiply for the in-string prefix XOR of the structural engine.
+#if !defined(JSON_NO_SIMD) && defined(__PCLMUL__)
+#define JSON_PCLMUL
+#include <wmmintrin.h>
+#endif
 
 #ifndef JSON_PARSE_STACK_INIT_SIZE
 #define JSON_PARSE_STACK_INIT_SIZE 256
 #endif
 
+// Objects up to this size are searched linearly, larger ones get a hash index.
+#ifndef JSON_OBJECT_INDEX_THRESHOLD
+#define JSON_OBJECT_INDEX_THRESHOLD 16
+#endif
+
+// First allocation of an array or object that grows from empty.
+#ifndef JSON_CONTAINER_INIT_CAPACITY
+#define JSON_CONTAINER_INIT_CAPACITY 4
+#endif
+
+// json_parse_n() takes the structural engine for inputs of at least this
+// size whose first 4 KiB are at least this percentage of whitespace.
+#ifndef JSON_STRUCTURAL_MIN_SIZE
+#define JSON_STRUCTURAL_MIN_SIZE 65536
+#endif
+#ifndef JSON_STRUCTURAL_MIN_WHITESPACE
+#define JSON_STRUCTURAL_MIN_WHITESPACE 60
+#endif
+
+// Inputs below this size are never split by json_parse_parallel().
+#ifndef JSON_PARALLEL_MIN_SIZE
+#define JSON_PARALLEL_MIN_SIZE (1 << 20)
+#endif
+
+// Bytes of input handed to a worker at a time, rounded up to a whole line.
+#ifndef JSON_NDJSON_BATCH_SIZE
+#define JSON_NDJSON_BATCH_SIZE 65536
+#endif
+
+#ifndef JSON_ARENA_CHUNK_SIZE
+#define JSON_ARENA_CHUNK_SIZE 65536
+#endif
+
+#define JSON_ARENA_ALIGN sizeof(double)
+
+// Next input character, '\0' at the end of the input.
+#define PEEK(c)             ((c)->json != (c)->end ? *(c)->json : '\0')
+
 // Check if the first character of c->json equals to ch
 // and move the pointer to the next position.
 #define EXPECT(c, ch)       do { assert((c)->json[0] == (ch)); (c)->json++; } while(0)
@@ -14,12 +132,344 @@
 // Push the value to the stack by using the returned pointer of json_context_push()
 #define PUTC(c, ch)         do { *(char*)json_context_push(c, sizeof(char)) = (ch); } while(0)
 
+// Allocator Begin
+static void* json_std_malloc(void* user, size_t size) {
+    (void)user;
+    return malloc(size);
+}
+
+static void* json_std_realloc(void* user, void* p, size_t size) {
+    (void)user;
+    return realloc(p, size);
+}
+
+static void json_std_free(void* user, void* p) {
+    (void)user;
+    free(p);
+}
+
+static const json_allocator json_std_allocator = { json_std_malloc, json_std_realloc, json_std_free, NULL };
+
+// Storage of value trees: nodes, strings, keys, stringify output.
+static const json_allocator* json_heap = &json_std_allocator;
+
+#define JSON_MALLOC(a, size)     ((a)->malloc((a)->user, (size)))
+#define JSON_REALLOC(a, p, size) ((a)->realloc((a)->user, (p), (size)))
+#define JSON_FREE(a, p)          ((a)->free((a)->user, (p)))
+
+void json_set_allocator(const json_allocator* a) {
+    json_heap = a != NULL ? a : &json_std_allocator;
+}
+
+void json_free_buffer(void* p) {
+    JSON_FREE(json_heap, p);
+}
+
+// Every block carries its size in front, so free() can account for it.
+#define JSON_COUNTING_HEADER 16
+
+static void* json_counting_realloc(void* user, void* p, size_t size) {
+    json_counting_allocator* a = (json_counting_allocator*)user;
+    const json_allocator* next = a->next != NULL ? a->next : &json_std_allocator;
+    size_t old = 0;
+    char* q;
+    if (p != NULL) {
+        p = (char*)p - JSON_COUNTING_HEADER;
+        memcpy(&old, p, sizeof(size_t));
+        a->reallocs++;
+    }
+    if ((q = (char*)JSON_REALLOC(next, p, JSON_COUNTING_HEADER + size)) == NULL)
+        return NULL;
+    memcpy(q, &size, sizeof(size_t));
+    a->count++;
+    a->bytes += size;
+    a->current += size - old;
+    if (a->current > a->peak)
+        a->peak = a->current;
+    return q + JSON_COUNTING_HEADER;
+}
+
+static void* json_counting_malloc(void* user, size_t size) {
+    return json_counting_realloc(user, NULL, size);
+}
+
+static void json_counting_free(void* user, void* p) {
+    json_counting_allocator* a = (json_counting_allocator*)user;
+    const json_allocator* next = a->next != NULL ? a->next : &json_std_allocator;
+    size_t old;
+    if (p == NULL)
+        return;
+    p = (char*)p - JSON_COUNTING_HEADER;
+    memcpy(&old, p, sizeof(size_t));
+    a->current -= old;
+    JSON_FREE(next, p);
+}
+
+void json_counting_allocator_init(json_counting_allocator* a, const json_allocator* next) {
+    assert(a != NULL);
+    a->allocator.malloc = json_counting_malloc;
+    a->allocator.realloc = json_counting_realloc;
+    a->allocator.free = json_counting_free;
+    a->allocator.user = a;
+    a->next = next;
+    a->count = a->bytes = a->current = a->peak = a->reallocs = 0;
+}
+// Allocator End
+
+// Chunk of an arena, the payload follows the header.
+typedef struct json_arena_chunk {
+    struct json_arena_chunk* next;
+    size_t size, used;
+} json_arena_chunk;
+
+// Bump allocator made of a list of chunks.
+// Reset rewinds to the first chunk and keeps every chunk for reuse.
+typedef struct {
+    json_arena_chunk* head;
+    json_arena_chunk* cur;
+    const json_allocator* alloc; // Chunks come from here
+} json_arena;
+
+// Interned key, slots with s == NULL are empty.
+typedef struct {
+    const char* s;
+    size_t len;
+    uint32_t hash;
+} json_symbol_slot;
+
+// Open addressing set of keys, the text of every key lives in strings.
+struct json_symbols {
+    json_arena strings;
+    json_symbol_slot* slots;
+    size_t mask, count;
+};
+
+struct json_document {
+    json_value root;
+    json_arena arena;
+    json_symbols symbols; // Keys of the current parse
+};
+
 typedef struct {
     const char* json;
+    const char* end;   // Input stops here, it need not be terminated
     char* stack;
     size_t size, top;
+    const json_allocator* alloc; // Storage of stack
+    json_arena* arena; // Node storage comes from here when not NULL
+    json_symbols* symbols; // Keys are interned here when not NULL
+    int insitu;        // Strings and keys are decoded in place inside json
+    size_t depth, max_depth; // Open containers and their limit
 } json_context;
 
+#define JSON_ARENA_HEADER_SIZE \
+    ((sizeof(json_arena_chunk) + JSON_ARENA_ALIGN - 1) & ~(JSON_ARENA_ALIGN - 1))
+
+static void* json_arena_alloc(json_arena* a, size_t size) {
+    json_arena_chunk* k;
+    size = (size + JSON_ARENA_ALIGN - 1) & ~(JSON_ARENA_ALIGN - 1);
+    // Skip to the first warm chunk that still has room
+    while (a->cur != NULL && a->cur->used + size > a->cur->size)
+        a->cur = a->cur->next;
+    if (a->cur == NULL) {
+        size_t cap = size > JSON_ARENA_CHUNK_SIZE ? size : JSON_ARENA_CHUNK_SIZE;
+        k = (json_arena_chunk*)JSON_MALLOC(a->alloc, JSON_ARENA_HEADER_SIZE + cap);
+        k->next = NULL;
+        k->size = cap;
+        k->used = 0;
+        // Append, so that chunks are visited in the same order after a reset
+        if (a->head == NULL)
+            a->head = k;
+        else {
+            json_arena_chunk* t = a->head;
+            while (t->next != NULL)
+                t = t->next;
+            t->next = k;
+        }
+        a->cur = k;
+    }
+    k = a->cur;
+    k->used += size;
+    return (char*)k + JSON_ARENA_HEADER_SIZE + k->used - size;
+}
+
+static void json_arena_init(json_arena* a, const json_allocator* alloc) {
+    a->head = a->cur = NULL;
+    a->alloc = alloc;
+}
+
+static void json_arena_reset(json_arena* a) {
+    json_arena_chunk* k;
+    for (k = a->head; k != NULL; k = k->next)
+        k->used = 0;
+    a->cur = a->head;
+}
+
+static void json_arena_release(json_arena* a) {
+    json_arena_chunk* k = a->head;
+    while (k != NULL) {
+        json_arena_chunk* next = k->next;
+        JSON_FREE(a->alloc, k);
+        k = next;
+    }
+    a->head = a->cur = NULL;
+}
+
+// FNV-1a
+static uint32_t json_hash_key(const char* k, size_t klen) {
+    uint32_t h = 2166136261u;
+    size_t i;
+    for (i = 0; i < klen; i++)
+        h = (h ^ (unsigned char)k[i]) * 16777619u;
+    return h;
+}
+
+static void json_symbols_init(json_symbols* y, const json_allocator* alloc) {
+    json_arena_init(&y->strings, alloc);
+    y->slots = NULL;
+    y->mask = y->count = 0;
+}
+
+static void json_symbols_clear(json_symbols* y) {
+    json_arena_reset(&y->strings);
+    if (y->slots != NULL)
+        memset(y->slots, 0, (y->mask + 1) * sizeof(json_symbol_slot));
+    y->count = 0;
+}
+
+static void json_symbols_release(json_symbols* y) {
+    json_arena_release(&y->strings);
+    JSON_FREE(y->strings.alloc, y->slots);
+    json_symbols_init(y, y->strings.alloc);
+}
+
+// Double the slot count, keys keep their storage so only slots move.
+static void json_symbols_grow(json_symbols* y) {
+    size_t n = y->slots == NULL ? 64 : (y->mask + 1) * 2, i, j;
+    json_symbol_slot* slots = (json_symbol_slot*)JSON_MALLOC(y->strings.alloc, n * sizeof(json_symbol_slot));
+    memset(slots, 0, n * sizeof(json_symbol_slot));
+    if (y->slots != NULL) {
+        for (i = 0; i <= y->mask; i++) {
+            if (y->slots[i].s == NULL)
+                continue;
+            for (j = y->slots[i].hash & (n - 1); slots[j].s != NULL; j = (j + 1) & (n - 1))
+                ;
+            slots[j] = y->slots[i];
+        }
+        JSON_FREE(y->strings.alloc, y->slots);
+    }
+    y->slots = slots;
+    y->mask = n - 1;
+}
+
+static char* json_symbols_find_or_add(json_symbols* y, const char* s, size_t len) {
+    uint32_t h = json_hash_key(s, len);
+    size_t i;
+    char* k;
+    // Keep the load factor at or below one half
+    if ((y->count + 1) * 2 > (y->slots == NULL ? 0 : y->mask + 1))
+        json_symbols_grow(y);
+    for (i = h & y->mask; y->slots[i].s != NULL; i = (i + 1) & y->mask)
+        if (y->slots[i].hash == h && y->slots[i].len == len && memcmp(y->slots[i].s, s, len) == 0)
+            return (char*)y->slots[i].s;
+    k = (char*)json_arena_alloc(&y->strings, len + 1);
+    if (len > 0)
+        memcpy(k, s, len);
+    k[len] = '\0';
+    y->slots[i].s = k;
+    y->slots[i].len = len;
+    y->slots[i].hash = h;
+    y->count++;
+    return k;
+}
+
+// Allocate node storage, from the arena when the context has one.
+static void* json_context_alloc(json_context* c, size_t size) {
+    return c->arena != NULL ? json_arena_alloc(c->arena, size) : JSON_MALLOC(json_heap, size);
+}
+
+// Elements and members carved from an arena are preceded by it, so that a
+// container marked JSON_FLAG_ARENA finds where to grow.
+typedef union {
+    json_arena* arena;
+    double align;
+} json_arena_tag;
+
+#define JSON_ITEMS_ARENA(items) ((json_arena_tag*)(items) - 1)->arena
+
+static void* json_arena_items(json_arena* a, size_t size) {
+    json_arena_tag* t = (json_arena_tag*)json_arena_alloc(a, sizeof(json_arena_tag) + size);
+    t->arena = a;
+    return t + 1;
+}
+
+// Storage for the elements or members of v, size may be 0. An arena always
+// gives a block, the tag in front of it has to be there even when empty.
+static void* json_context_items(json_context* c, json_value* v, size_t size) {
+    if (c->arena == NULL)
+        return size > 0 ? JSON_MALLOC(json_heap, size) : NULL;
+    v->flags |= JSON_FLAG_ARENA;
+    return json_arena_items(c->arena, size);
+}
+
+static json_object_index* json_object_index_create(const json_value* v, json_arena* arena); // Forward declare
+
+// Key index of an object just built. Heap objects allocate theirs on the
+// first lookup, arena objects large enough reserve one now.
+static json_object_index* json_context_index(json_context* c, const json_value* v) {
+    if (c->arena == NULL || v->u.o.size <= JSON_OBJECT_INDEX_THRESHOLD || v->u.o.size > UINT32_MAX)
+        return NULL;
+    return json_object_index_create(v, c->arena);
+}
+
+static void json_context_init(json_context* c, const char* json, size_t len) {
+    c->json = json;
+    c->end = json + len;
+    c->stack = NULL;
+    c->size = c->top = 0;
+    c->alloc = json_heap;
+    c->arena = NULL;
+    c->symbols = NULL;
+    c->insitu = 0;
+    c->depth = 0;
+    c->max_depth = (size_t)-1;
+}
+
+// Ownership flags of a container built by this context.
+#define JSON_CONTEXT_FLAGS(c) \
+    (((c)->arena != NULL ? (JSON_FLAG_BORROWED | JSON_FLAG_KEYS_BORROWED) : 0) | \
+     ((c)->insitu || (c)->symbols != NULL ? JSON_FLAG_KEYS_BORROWED : 0))
+
+// Store a string produced by json_parse_string_raw().
+// In-situ strings are already terminated inside the input and are borrowed.
+static void json_context_set_string(json_context* c, json_value* v, char* s, size_t len) {
+    if (c->insitu)
+        v->u.s.s = s;
+    else {
+        v->u.s.s = (char*)json_context_alloc(c, len + 1);
+        if (len > 0)
+            memcpy(v->u.s.s, s, len);
+        v->u.s.s[len] = '\0';
+    }
+    v->u.s.len = len;
+    v->type = JSON_STRING;
+    v->flags = c->arena != NULL || c->insitu ? JSON_FLAG_BORROWED : 0;
+}
+
+// Same as above for object keys, interned keys are shared by every object.
+static char* json_context_key(json_context* c, char* s, size_t len) {
+    char* k;
+    if (c->symbols != NULL)
+        return json_symbols_find_or_add(c->symbols, s, len);
+    if (c->insitu)
+        return s;
+    k = (char*)json_context_alloc(c, len + 1);
+    if (len > 0)
+        memcpy(k, s, len);
+    k[len] = '\0';
+    return k;
+}
+
 // Push context to dynamic stack, returns a void pointer.
 // Modify the stack data by changing the data void pointer pointed.
 static void* json_context_push(json_context* c, size_t size) {
@@ -30,7 +480,7 @@ static void* json_context_push(json_context* c, size_t size) {
             c->size = JSON_PARSE_STACK_INIT_SIZE;
         while (c->top + size >= c->size)
             c->size += c->size >> 1;  /* c->size * 1.5 */
-        c->stack = (char*)realloc(c->stack, c->size);
+        c->stack = (char*)JSON_REALLOC(c->alloc, c->stack, c->size);
     }
     ret = c->stack + c->top;
     c->top += size;
@@ -42,12 +492,515 @@ static void* json_context_pop(json_context* c, size_t size) {
     return c->stack + (c->top -= size);
 }
 
+// Return the first byte in [p, end) on which the string loop has to stop:
+// '\"', '\\' or a control character, or end when there is none.
+// Whole blocks are compared at once, the tail is scanned byte by byte.
+static const char* json_scan_string(const char* p, const char* end) {
+#if defined(JSON_AVX2)
+    const __m256i quote32 = _mm256_set1_epi8('\"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i space32 = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)p);
+        __m256i m = _mm256_or_si256(_mm256_or_si256(
+            _mm256_cmpeq_epi8(x, quote32), _mm256_cmpeq_epi8(x, backslash32)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(x, space32), x)); // x <= 0x1F
+        unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+        if (mask != 0)
+            return p + JSON_CTZ(mask);
+    }
+#endif
+#if defined(JSON_AVX2) || defined(JSON_SSE2)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)p);
+        __m128i m = _mm_or_si128(_mm_or_si128(
+            _mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(x, space), x)); // x <= 0x1F
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask != 0)
+            return p + JSON_CTZ(mask);
+    }
+#endif
+    while (p < end && *p != '\"' && *p != '\\' && (unsigned char)*p >= 0x20)
+        p++;
+    return p;
+}
+
+// UTF-8 validation after Keiser and Lemire, "Validating UTF-8 In Less Than
+// One Instruction Per Byte". Every byte is classified together with the one
+// before it by three nibble lookups whose AND is non-zero on an error, the
+// second and third bytes after a 3 and 4-byte lead are checked separately.
+#if defined(JSON_SSSE3) || defined(JSON_UTF8_DISPATCH)
+#define JSON_UTF8_TOO_SHORT      (1 << 0) // Lead not followed by a continuation
+#define JSON_UTF8_TOO_LONG       (1 << 1) // Continuation after ASCII
+#define JSON_UTF8_OVERLONG_3     (1 << 2)
+#define JSON_UTF8_TOO_LARGE      (1 << 3)
+#define JSON_UTF8_SURROGATE      (1 << 4)
+#define JSON_UTF8_OVERLONG_2     (1 << 5)
+#define JSON_UTF8_TOO_LARGE_1000 (1 << 6)
+#define JSON_UTF8_OVERLONG_4     (1 << 6)
+#define JSON_UTF8_TWO_CONTS      (1 << 7) // Continuation after a continuation, unless the lead needs it
+#define JSON_UTF8_CARRY (JSON_UTF8_TOO_SHORT | JSON_UTF8_TOO_LONG | JSON_UTF8_TWO_CONTS)
+
+static const unsigned char json_utf8_table[3][16] = {
+    { // High nibble of the previous byte
+        JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG,
+        JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG, JSON_UTF8_TOO_LONG,
+        JSON_UTF8_TWO_CONTS, JSON_UTF8_TWO_CONTS, JSON_UTF8_TWO_CONTS, JSON_UTF8_TWO_CONTS,
+        JSON_UTF8_TOO_SHORT | JSON_UTF8_OVERLONG_2,
+        JSON_UTF8_TOO_SHORT,
+        JSON_UTF8_TOO_SHORT | JSON_UTF8_OVERLONG_3 | JSON_UTF8_SURROGATE,
+        JSON_UTF8_TOO_SHORT | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000 | JSON_UTF8_OVERLONG_4
+    },
+    { // Low nibble of the previous byte
+        JSON_UTF8_CARRY | JSON_UTF8_OVERLONG_3 | JSON_UTF8_OVERLONG_2 | JSON_UTF8_OVERLONG_4,
+        JSON_UTF8_CARRY | JSON_UTF8_OVERLONG_2,
+        JSON_UTF8_CARRY,
+        JSON_UTF8_CARRY,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000 | JSON_UTF8_SURROGATE,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000,
+        JSON_UTF8_CARRY | JSON_UTF8_TOO_LARGE | JSON_UTF8_TOO_LARGE_1000
+    },
+    { // High nibble of the current byte
+        JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT,
+        JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT,
+        JSON_UTF8_TOO_LONG | JSON_UTF8_OVERLONG_2 | JSON_UTF8_TWO_CONTS | JSON_UTF8_OVERLONG_3
+            | JSON_UTF8_TOO_LARGE_1000 | JSON_UTF8_OVERLONG_4,
+        JSON_UTF8_TOO_LONG | JSON_UTF8_OVERLONG_2 | JSON_UTF8_TWO_CONTS | JSON_UTF8_OVERLONG_3 | JSON_UTF8_TOO_LARGE,
+        JSON_UTF8_TOO_LONG | JSON_UTF8_OVERLONG_2 | JSON_UTF8_TWO_CONTS | JSON_UTF8_SURROGATE | JSON_UTF8_TOO_LARGE,
+        JSON_UTF8_TOO_LONG | JSON_UTF8_OVERLONG_2 | JSON_UTF8_TWO_CONTS | JSON_UTF8_SURROGATE | JSON_UTF8_TOO_LARGE,
+        JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT, JSON_UTF8_TOO_SHORT
+    }
+};
+
+// First n bytes set, loaded from json_utf8_keep + 32 - n.
+static const char json_utf8_keep[64] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+#if !defined(JSON_AVX2)
+// Error bits of block x, prev is the block before it.
+JSON_TARGET_SSSE3 static __m128i json_utf8_check(__m128i prev, __m128i x) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(x, prev, 15);
+    __m128i prev2 = _mm_alignr_epi8(x, prev, 14);
+    __m128i prev3 = _mm_alignr_epi8(x, prev, 13);
+    __m128i sc = _mm_and_si128(_mm_and_si128(
+        _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)json_utf8_table[0]), _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+        _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)json_utf8_table[1]), _mm_and_si128(prev1, nibble))),
+        _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)json_utf8_table[2]), _mm_and_si128(_mm_srli_epi16(x, 4), nibble)));
+    // Bit 7 set where the byte has to be the 3rd or 4th of a sequence
+    __m128i must23 = _mm_or_si128(
+        _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80))),
+        _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80))));
+    return _mm_xor_si128(_mm_and_si128(must23, _mm_set1_epi8((char)0x80)), sc);
+}
+#endif
+#if defined(JSON_AVX2) || defined(JSON_UTF8_DISPATCH)
+// Error bits of the 32-byte block x, prev is the block before it. The
+// lookups work per lane, so the tables are repeated in both.
+JSON_TARGET_AVX2 static __m256i json_utf8_check32(__m256i prev, __m256i x) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i carry = _mm256_permute2x128_si256(prev, x, 0x21); // prev high lane, x low lane
+    __m256i prev1 = _mm256_alignr_epi8(x, carry, 15);
+    __m256i prev2 = _mm256_alignr_epi8(x, carry, 14);
+    __m256i prev3 = _mm256_alignr_epi8(x, carry, 13);
+    __m256i sc = _mm256_and_si256(_mm256_and_si256(
+        _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)json_utf8_table[0])),
+            _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+        _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)json_utf8_table[1])),
+            _mm256_and_si256(prev1, nibble))),
+        _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)json_utf8_table[2])),
+            _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble)));
+    __m256i must23 = _mm256_or_si256(
+        _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80))),
+        _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80))));
+    return _mm256_xor_si256(_mm256_and_si256(must23, _mm256_set1_epi8((char)0x80)), sc);
+}
+#endif
+#endif
+
+#if !defined(JSON_SSSE3)
+// Length of the UTF-8 sequence at s, 0 when it is malformed, overlong, a
+// surrogate or above U+10FFFF.
+static size_t json_utf8_length(const char* s, const char* end) {
+    const unsigned char* p = (const unsigned char*)s;
+    size_t n = end - s;
+    if (p[0] < 0x80)
+        return 1;
+    if (p[0] < 0xC2)
+        return 0;
+    if (p[0] < 0xE0)
+        return n >= 2 && (p[1] & 0xC0) == 0x80 ? 2 : 0;
+    if (p[0] < 0xF0) {
+        if (n < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80
+            || (p[0] == 0xE0 && p[1] < 0xA0) || (p[0] == 0xED && p[1] >= 0xA0))
+            return 0;
+        return 3;
+    }
+    if (p[0] < 0xF5) {
+        if (n < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80
+            || (p[0] == 0xF0 && p[1] < 0x90) || (p[0] == 0xF4 && p[1] >= 0x90))
+            return 0;
+        return 4;
+    }
+    return 0;
+}
+#endif
+
+// json_scan_string() that also validates the UTF-8 it skips, *valid is
+// cleared when [p, result) is not valid UTF-8, including a sequence cut
+// short by the returned byte. Blocks without a byte >= 0x80 cost one more
+// movemask, the others go through the validator in whole.
+#if defined(JSON_AVX2) || defined(JSON_UTF8_DISPATCH)
+JSON_TARGET_AVX2 static const char* json_scan_string_utf8_avx2(const char* p, const char* end, int* valid) {
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(0x1F);
+    __m256i prev = _mm256_setzero_si256(), error = _mm256_setzero_si256();
+    int pending = 0; // prev may hold a sequence that continues in the next block
+    while (1) {
+        char tail[32];
+        __m256i x, m;
+        unsigned mask, high;
+        int n;
+        if (end - p >= 32)
+            x = _mm256_loadu_si256((const __m256i*)p);
+        else {
+            // The zero padding stops the scan at end
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p, end - p);
+            x = _mm256_loadu_si256((const __m256i*)tail);
+        }
+        m = _mm256_or_si256(_mm256_or_si256(
+            _mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, backslash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(x, space), x)); // x <= 0x1F
+        mask = (unsigned)_mm256_movemask_epi8(m);
+        n = mask != 0 ? (int)JSON_CTZ(mask) : 32;
+        high = (unsigned)_mm256_movemask_epi8(x) & (mask != 0 ? (mask & (0u - mask)) - 1 : ~0u);
+        if (high != 0 || pending) {
+            // Bytes from the stop on read as zero, which ends any open sequence
+            x = _mm256_and_si256(x, _mm256_loadu_si256((const __m256i*)(json_utf8_keep + 32 - n)));
+            error = _mm256_or_si256(error, json_utf8_check32(prev, x));
+            prev = x;
+            pending = high != 0;
+        }
+        if (n < 32) {
+            if (!_mm256_testz_si256(error, error))
+                *valid = 0;
+            return p + n;
+        }
+        p += 32;
+    }
+}
+#endif
+
+#if (defined(JSON_SSSE3) && !defined(JSON_AVX2)) || defined(JSON_UTF8_DISPATCH)
+JSON_TARGET_SSSE3 static const char* json_scan_string_utf8_ssse3(const char* p, const char* end, int* valid) {
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x1F);
+    __m128i prev = _mm_setzero_si128(), error = _mm_setzero_si128();
+    int pending = 0; // prev may hold a sequence that continues in the next block
+    while (1) {
+        char tail[16];
+        __m128i x, m;
+        unsigned mask, high;
+        int n;
+        if (end - p >= 16)
+            x = _mm_loadu_si128((const __m128i*)p);
+        else {
+            // The zero padding stops the scan at end
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p, end - p);
+            x = _mm_loadu_si128((const __m128i*)tail);
+        }
+        m = _mm_or_si128(_mm_or_si128(
+            _mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(x, space), x)); // x <= 0x1F
+        mask = (unsigned)_mm_movemask_epi8(m);
+        n = mask != 0 ? (int)JSON_CTZ(mask) : 16;
+        high = (unsigned)_mm_movemask_epi8(x) & ((1u << n) - 1);
+        if (high != 0 || pending) {
+            // Bytes from the stop on read as zero, which ends any open sequence
+            x = _mm_and_si128(x, _mm_loadu_si128((const __m128i*)(json_utf8_keep + 32 - n)));
+            error = _mm_or_si128(error, json_utf8_check(prev, x));
+            prev = x;
+            pending = high != 0;
+        }
+        if (n < 16) {
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF)
+                *valid = 0;
+            return p + n;
+        }
+        p += 16;
+    }
+}
+#endif
+
+#if !defined(JSON_SSSE3)
+static const char* json_scan_string_utf8_scalar(const char* p, const char* end, int* valid) {
+    size_t n;
+    while (1) {
+#if defined(JSON_SSE2)
+        // Only ASCII is skipped in blocks, other bytes one sequence at a time
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i space = _mm_set1_epi8(0x1F);
+        for (; end - p >= 16; p += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i*)p);
+            __m128i m = _mm_or_si128(_mm_or_si128(
+                _mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+                _mm_cmpeq_epi8(_mm_min_epu8(x, space), x)); // x <= 0x1F
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(m, x));
+            if (mask != 0) {
+                p += JSON_CTZ(mask);
+                break;
+            }
+        }
+#endif
+        while (p < end && *p != '\"' && *p != '\\' && (unsigned char)*p >= 0x20 && (unsigned char)*p < 0x80)
+            p++;
+        // Runs of non-ASCII text stay here
+        for (; p < end && (unsigned char)*p >= 0x80; p += n)
+            if ((n = json_utf8_length(p, end)) == 0) {
+                *valid = 0;
+                return p;
+            }
+        if (p == end || *p == '\"' || *p == '\\' || (unsigned char)*p < 0x20)
+            return p;
+    }
+}
+#endif
+
+#if defined(JSON_UTF8_DISPATCH)
+typedef const char* (*json_utf8_scanner)(const char* p, const char* end, int* valid);
+
+static const char* json_scan_string_utf8_pick(const char* p, const char* end, int* valid);
+static json_utf8_scanner json_utf8_scan = json_scan_string_utf8_pick;
+
+// First call only, every thread picks the same one.
+static const char* json_scan_string_utf8_pick(const char* p, const char* end, int* valid) {
+    json_utf8_scanner f = json_scan_string_utf8_scalar;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        f = json_scan_string_utf8_avx2;
+    else if (__builtin_cpu_supports("ssse3"))
+        f = json_scan_string_utf8_ssse3;
+    __atomic_store_n(&json_utf8_scan, f, __ATOMIC_RELAXED);
+    return f(p, end, valid);
+}
+#endif
+
+static const char* json_scan_string_utf8(const char* p, const char* end, int* valid) {
+#if defined(JSON_AVX2)
+    return json_scan_string_utf8_avx2(p, end, valid);
+#elif defined(JSON_SSSE3)
+    return json_scan_string_utf8_ssse3(p, end, valid);
+#elif defined(JSON_UTF8_DISPATCH)
+    // ASCII is skipped here, the first other byte hands the rest of the
+    // string to the validator picked for this CPU
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)p);
+        __m128i m = _mm_or_si128(_mm_or_si128(
+            _mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(x, space), x)); // x <= 0x1F
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(m, x));
+        if (mask != 0) {
+            p += JSON_CTZ(mask);
+            break;
+        }
+    }
+    while (p < end && *p != '\"' && *p != '\\' && (unsigned char)*p >= 0x20 && (unsigned char)*p < 0x80)
+        p++;
+    if (p == end || (unsigned char)*p < 0x80)
+        return p;
+    return __atomic_load_n(&json_utf8_scan, __ATOMIC_RELAXED)(p, end, valid);
+#else
+    return json_scan_string_utf8_scalar(p, end, valid);
+#endif
+}
+
+// Whether [p, end) is valid UTF-8. The bytes the scanner stops on are ASCII
+// and cannot be part of a sequence.
+static int json_utf8_valid(const char* p, const char* end) {
+    int valid = 1;
+    while ((p = json_scan_string_utf8(p, end, &valid)) != end && valid)
+        p++;
+    return valid;
+}
+
+static const char* json_parse_hex4(const char* p, const char* end, unsigned* u) {
+    int i;
+    if (end - p < 4)
+        return NULL;
+    *u = 0;
+    for (i = 0; i < 4; i++) {
+        char ch = *p++;
+        *u <<= 4;
+        if (ch >= '0' && ch <= '9')
+            *u |= ch - '0';
+        else if (ch >= 'A' && ch <= 'F')
+            *u |= ch - ('A' - 10);
+        else if (ch >= 'a' && ch <= 'f')
+            *u |= ch - ('a' - 10);
+        else
+            return NULL;
+    }
+    return p;
+}
+
+static size_t json_encode_utf8(char* buf, unsigned u) {
+    if (u <= 0x7F) {
+        buf[0] = (char)u;
+        return 1;
+    }
+    if (u <= 0x7FF) {
+        buf[0] = (char)(0xC0 | (u >> 6));
+        buf[1] = (char)(0x80 | (u & 0x3F));
+        return 2;
+    }
+    if (u <= 0xFFFF) {
+        buf[0] = (char)(0xE0 | (u >> 12));
+        buf[1] = (char)(0x80 | ((u >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (u & 0x3F));
+        return 3;
+    }
+    buf[0] = (char)(0xF0 | (u >> 18));
+    buf[1] = (char)(0x80 | ((u >> 12) & 0x3F));
+    buf[2] = (char)(0x80 | ((u >> 6) & 0x3F));
+    buf[3] = (char)(0x80 | (u & 0x3F));
+    return 4;
+}
+
+// Decode the escape after a backslash at *s into buf, at most 4 bytes, which
+// is never more than the escape itself. A surrogate pair is one escape.
+static int json_decode_escape(const char** s, const char* end, char* buf, size_t* n) {
+    const char* p = *s;
+    unsigned u, l;
+    if (p == end)
+        return JSON_PARSE_MISS_QUOTATION_MARK;
+    switch (*p++) {
+        case '\"': buf[0] = '\"'; break;
+        case '\\': buf[0] = '\\'; break;
+        case '/':  buf[0] = '/';  break;
+        case 'b':  buf[0] = '\b'; break;
+        case 'f':  buf[0] = '\f'; break;
+        case 'n':  buf[0] = '\n'; break;
+        case 'r':  buf[0] = '\r'; break;
+        case 't':  buf[0] = '\t'; break;
+        case 'u':
+            if ((p = json_parse_hex4(p, end, &u)) == NULL)
+                return JSON_PARSE_INVALID_UNICODE_HEX;
+            if (u >= 0xDC00 && u <= 0xDFFF)
+                return JSON_PARSE_INVALID_UNICODE_SURROGATE;
+            if (u >= 0xD800 && u <= 0xDBFF) {
+                // High surrogate, a low one has to follow
+                if (end - p < 2 || p[0] != '\\' || p[1] != 'u')
+                    return JSON_PARSE_INVALID_UNICODE_SURROGATE;
+                if ((p = json_parse_hex4(p + 2, end, &l)) == NULL)
+                    return JSON_PARSE_INVALID_UNICODE_HEX;
+                if (l < 0xDC00 || l > 0xDFFF)
+                    return JSON_PARSE_INVALID_UNICODE_SURROGATE;
+                u = 0x10000 + ((u - 0xD800) << 10) + (l - 0xDC00);
+            }
+            *n = json_encode_utf8(buf, u);
+            *s = p;
+            return JSON_PARSE_OK;
+        default:
+            return JSON_PARSE_INVALID_STRING_ESCAPE;
+    }
+    *n = 1;
+    *s = p;
+    return JSON_PARSE_OK;
+}
+
+// In-situ variant of json_parse_string_raw().
+// The string is decoded towards its opening quote inside the caller's buffer
+// and terminated there, nothing goes through the stack.
+static int json_parse_string_insitu(json_context* c, char** str, size_t* len) {
+    char* head;
+    char* dst;
+    const char* p;
+    char buf[4];
+    size_t n;
+    int ret, valid = 1;
+    EXPECT(c, '\"');
+    head = dst = (char*)c->json;
+    p = c->json;
+    while (1) {
+        // Move the clean run in one go, nothing to do until dst falls behind
+        const char* q = json_scan_string_utf8(p, c->end, &valid);
+        if (!valid)
+            return JSON_PARSE_INVALID_STRING_CHAR;
+        if (dst != p)
+            memmove(dst, p, q - p);
+        dst += q - p;
+        p = q;
+        if (p == c->end)
+            return JSON_PARSE_MISS_QUOTATION_MARK;
+        char ch = *p++;
+        switch (ch) {
+            case '\"':
+                *len = dst - head;
+                *dst = '\0';
+                *str = head;
+                c->json = p;
+                return JSON_PARSE_OK;
+            case '\\':
+                if ((ret = json_decode_escape(&p, c->end, buf, &n)) != JSON_PARSE_OK)
+                    return ret;
+                memcpy(dst, buf, n);
+                dst += n;
+                break;
+            case '\0':
+                return JSON_PARSE_MISS_QUOTATION_MARK;
+            default:
+                return JSON_PARSE_INVALID_STRING_CHAR;
+        }
+    }
+}
+
 static int json_parse_string_raw(json_context* c, char** str, size_t* len) {
-    size_t head = c->top;
+    size_t head = c->top, n;
     const char* p;
+    char buf[4];
+    int ret, valid = 1;
+    if (c->insitu)
+        return json_parse_string_insitu(c, str, len);
     EXPECT(c, '\"');
     p = c->json;
     while (1) {
+        // Copy the clean run with a single reservation on the stack
+        const char* q = json_scan_string_utf8(p, c->end, &valid);
+        if (!valid) {
+            c->top = head;
+            return JSON_PARSE_INVALID_STRING_CHAR;
+        }
+        if (q != p) {
+            memcpy(json_context_push(c, q - p), p, q - p);
+            p = q;
+        }
+        if (p == c->end) {
+            c->top = head;
+            return JSON_PARSE_MISS_QUOTATION_MARK;
+        }
         char ch = *p++;
         switch (ch) {
             case '\"':
@@ -55,11 +1008,19 @@ static int json_parse_string_raw(json_context* c, char** str, size_t* len) {
                 *str = json_context_pop(c, *len);
                 c->json = p;
                 return JSON_PARSE_OK;
+            case '\\':
+                if ((ret = json_decode_escape(&p, c->end, buf, &n)) != JSON_PARSE_OK) {
+                    c->top = head;
+                    return ret;
+                }
+                memcpy(json_context_push(c, n), buf, n);
+                break;
             case '\0':
                 c->top = head;
                 return JSON_PARSE_MISS_QUOTATION_MARK;
             default:
-                PUTC(c, ch);
+                c->top = head;
+                return JSON_PARSE_INVALID_STRING_CHAR;
         }
     }
 }
@@ -69,20 +1030,20 @@ static int json_parse_string(json_context* c, json_value* v) {
     char* s;
     size_t len;
     if ((ret = json_parse_string_raw(c, &s, &len)) == JSON_PARSE_OK)
-        json_set_string(v, s, len);
+        json_context_set_string(c, v, s, len);
     return ret;
 }
 
 static void json_parse_whitespace(json_context* c) {
     const char* p = c->json;
-    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+    while (p != c->end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
         p++;
     c->json = p;
 }
 
 static int json_parse_null(json_context* c, json_value* v) {
     EXPECT(c, 'n');
-    if (c->json[0] != 'u' || c->json[1] != 'l' || c->json[2] != 'l')
+    if (c->end - c->json < 3 || c->json[0] != 'u' || c->json[1] != 'l' || c->json[2] != 'l')
         return JSON_PARSE_INVALID_VALUE;
     c->json += 3;
     v->type = JSON_NULL;
@@ -91,7 +1052,7 @@ static int json_parse_null(json_context* c, json_value* v) {
 
 static int json_parse_true(json_context* c, json_value* v) {
     EXPECT(c, 't');
-    if (c->json[0] != 'r' || c->json[1] != 'u' || c->json[2] != 'e')
+    if (c->end - c->json < 3 || c->json[0] != 'r' || c->json[1] != 'u' || c->json[2] != 'e')
         return JSON_PARSE_INVALID_VALUE;
     c->json += 3;
     v->type = JSON_TRUE;
@@ -100,7 +1061,7 @@ static int json_parse_true(json_context* c, json_value* v) {
 
 static int json_parse_false(json_context* c, json_value* v) {
     EXPECT(c, 'f');
-    if (c->json[0] != 'a' || c->json[1] != 'l' || c->json[2] != 's' || c->json[3] != 'e')
+    if (c->end - c->json < 4 || c->json[0] != 'a' || c->json[1] != 'l' || c->json[2] != 's' || c->json[3] != 'e')
         return JSON_PARSE_INVALID_VALUE;
     c->json += 4;
     v->type = JSON_FALSE;
@@ -112,7 +1073,7 @@ static int json_parse_literal(json_context* c, json_value* v, const char* litera
 
     size_t i;
     for (i = 0; literal[i+1] != '\0'; i++)
-        if (c->json[i] != literal[i+1])
+        if (c->json + i == c->end || c->json[i] != literal[i+1])
             return JSON_PARSE_INVALID_VALUE;
 
     c->json += i;
@@ -120,200 +1081,4301 @@ static int json_parse_literal(json_context* c, json_value* v, const char* litera
     return JSON_PARSE_OK;
 }
 
-static int json_parse_number(json_context* c, json_value* v) {
-    char* end;
-    // TODO: add number validation
-    v->u.n = strtod(c->json, &end); // Convert string to double
-    if (c->json == end)
-        return JSON_PARSE_INVALID_VALUE;
-    c->json = end;
-    v->type = JSON_NUMBER;
-    return JSON_PARSE_OK;
+#define ISDIGIT(ch)         ((ch) >= '0' && (ch) <= '9')
+#define ISDIGIT1TO9(ch)     ((ch) >= '1' && (ch) <= '9')
+
+// Truncated 128-bit approximations of 5^q for q in [-342, 308], normalized so
+// that the most significant bit is set, as used by the Eisel-Lemire algorithm.
+#define JSON_POW5_MIN_EXP (-342)
+#define JSON_POW5_MAX_EXP 308
+static const uint64_t json_pow5_128[2 * (JSON_POW5_MAX_EXP - JSON_POW5_MIN_EXP + 1)] = {
+    0xeef453d6923bd65au, 0x113faa2906a13b3fu, 0x9558b4661b6565f8u, 0x4ac7ca59a424c507u,
+    0xbaaee17fa23ebf76u, 0x5d79bcf00d2df649u, 0xe95a99df8ace6f53u, 0xf4d82c2c107973dcu,
+    0x91d8a02bb6c10594u, 0x79071b9b8a4be869u, 0xb64ec836a47146f9u, 0x9748e2826cdee284u,
+    0xe3e27a444d8d98b7u, 0xfd1b1b2308169b25u, 0x8e6d8c6ab0787f72u, 0xfe30f0f5e50e20f7u,
+    0xb208ef855c969f4fu, 0xbdbd2d335e51a935u, 0xde8b2b66b3bc4723u, 0xad2c788035e61382u,
+    0x8b16fb203055ac76u, 0x4c3bcb5021afcc31u, 0xaddcb9e83c6b1793u, 0xdf4abe242a1bbf3du,
+    0xd953e8624b85dd78u, 0xd71d6dad34a2af0du, 0x87d4713d6f33aa6bu, 0x8672648c40e5ad68u,
+    0xa9c98d8ccb009506u, 0x680efdaf511f18c2u, 0xd43bf0effdc0ba48u, 0x0212bd1b2566def2u,
+    0x84a57695fe98746du, 0x014bb630f7604b57u, 0xa5ced43b7e3e9188u, 0x419ea3bd35385e2du,
+    0xcf42894a5dce35eau, 0x52064cac828675b9u, 0x818995ce7aa0e1b2u, 0x7343efebd1940993u,
+    0xa1ebfb4219491a1fu, 0x1014ebe6c5f90bf8u, 0xca66fa129f9b60a6u, 0xd41a26e077774ef6u,
+    0xfd00b897478238d0u, 0x8920b098955522b4u, 0x9e20735e8cb16382u, 0x55b46e5f5d5535b0u,
+    0xc5a890362fddbc62u, 0xeb2189f734aa831du, 0xf712b443bbd52b7bu, 0xa5e9ec7501d523e4u,
+    0x9a6bb0aa55653b2du, 0x47b233c92125366eu, 0xc1069cd4eabe89f8u, 0x999ec0bb696e840au,
+    0xf148440a256e2c76u, 0xc00670ea43ca250du, 0x96cd2a865764dbcau, 0x380406926a5e5728u,
+    0xbc807527ed3e12bcu, 0xc605083704f5ecf2u, 0xeba09271e88d976bu, 0xf7864a44c633682eu,
+    0x93445b8731587ea3u, 0x7ab3ee6afbe0211du, 0xb8157268fdae9e4cu, 0x5960ea05bad82964u,
+    0xe61acf033d1a45dfu, 0x6fb92487298e33bdu, 0x8fd0c16206306babu, 0xa5d3b6d479f8e056u,
+    0xb3c4f1ba87bc8696u, 0x8f48a4899877186cu, 0xe0b62e2929aba83cu, 0x331acdabfe94de87u,
+    0x8c71dcd9ba0b4925u, 0x9ff0c08b7f1d0b14u, 0xaf8e5410288e1b6fu, 0x07ecf0ae5ee44dd9u,
+    0xdb71e91432b1a24au, 0xc9e82cd9f69d6150u, 0x892731ac9faf056eu, 0xbe311c083a225cd2u,
+    0xab70fe17c79ac6cau, 0x6dbd630a48aaf406u, 0xd64d3d9db981787du, 0x092cbbccdad5b108u,
+    0x85f0468293f0eb4eu, 0x25bbf56008c58ea5u, 0xa76c582338ed2621u, 0xaf2af2b80af6f24eu,
+    0xd1476e2c07286faau, 0x1af5af660db4aee1u, 0x82cca4db847945cau, 0x50d98d9fc890ed4du,
+    0xa37fce126597973cu, 0xe50ff107bab528a0u, 0xcc5fc196fefd7d0cu, 0x1e53ed49a96272c8u,
+    0xff77b1fcbebcdc4fu, 0x25e8e89c13bb0f7au, 0x9faacf3df73609b1u, 0x77b191618c54e9acu,
+    0xc795830d75038c1du, 0xd59df5b9ef6a2417u, 0xf97ae3d0d2446f25u, 0x4b0573286b44ad1du,
+    0x9becce62836ac577u, 0x4ee367f9430aec32u, 0xc2e801fb244576d5u, 0x229c41f793cda73fu,
+    0xf3a20279ed56d48au, 0x6b43527578c1110fu, 0x9845418c345644d6u, 0x830a13896b78aaa9u,
+    0xbe5691ef416bd60cu, 0x23cc986bc656d553u, 0xedec366b11c6cb8fu, 0x2cbfbe86b7ec8aa8u,
+    0x94b3a202eb1c3f39u, 0x7bf7d71432f3d6a9u, 0xb9e08a83a5e34f07u, 0xdaf5ccd93fb0cc53u,
+    0xe858ad248f5c22c9u, 0xd1b3400f8f9cff68u, 0x91376c36d99995beu, 0x23100809b9c21fa1u,
+    0xb58547448ffffb2du, 0xabd40a0c2832a78au, 0xe2e69915b3fff9f9u, 0x16c90c8f323f516cu,
+    0x8dd01fad907ffc3bu, 0xae3da7d97f6792e3u, 0xb1442798f49ffb4au, 0x99cd11cfdf41779cu,
+    0xdd95317f31c7fa1du, 0x40405643d711d583u, 0x8a7d3eef7f1cfc52u, 0x482835ea666b2572u,
+    0xad1c8eab5ee43b66u, 0xda3243650005eecfu, 0xd863b256369d4a40u, 0x90bed43e40076a82u,
+    0x873e4f75e2224e68u, 0x5a7744a6e804a291u, 0xa90de3535aaae202u, 0x711515d0a205cb36u,
+    0xd3515c2831559a83u, 0x0d5a5b44ca873e03u, 0x8412d9991ed58091u, 0xe858790afe9486c2u,
+    0xa5178fff668ae0b6u, 0x626e974dbe39a872u, 0xce5d73ff402d98e3u, 0xfb0a3d212dc8128fu,
+    0x80fa687f881c7f8eu, 0x7ce66634bc9d0b99u, 0xa139029f6a239f72u, 0x1c1fffc1ebc44e80u,
+    0xc987434744ac874eu, 0xa327ffb266b56220u, 0xfbe9141915d7a922u, 0x4bf1ff9f0062baa8u,
+    0x9d71ac8fada6c9b5u, 0x6f773fc3603db4a9u, 0xc4ce17b399107c22u, 0xcb550fb4384d21d3u,
+    0xf6019da07f549b2bu, 0x7e2a53a146606a48u, 0x99c102844f94e0fbu, 0x2eda7444cbfc426du,
+    0xc0314325637a1939u, 0xfa911155fefb5308u, 0xf03d93eebc589f88u, 0x793555ab7eba27cau,
+    0x96267c7535b763b5u, 0x4bc1558b2f3458deu, 0xbbb01b9283253ca2u, 0x9eb1aaedfb016f16u,
+    0xea9c227723ee8bcbu, 0x465e15a979c1cadcu, 0x92a1958a7675175fu, 0x0bfacd89ec191ec9u,
+    0xb749faed14125d36u, 0xcef980ec671f667bu, 0xe51c79a85916f484u, 0x82b7e12780e7401au,
+    0x8f31cc0937ae58d2u, 0xd1b2ecb8b0908810u, 0xb2fe3f0b8599ef07u, 0x861fa7e6dcb4aa15u,
+    0xdfbdcece67006ac9u, 0x67a791e093e1d49au, 0x8bd6a141006042bdu, 0xe0c8bb2c5c6d24e0u,
+    0xaecc49914078536du, 0x58fae9f773886e18u, 0xda7f5bf590966848u, 0xaf39a475506a899eu,
+    0x888f99797a5e012du, 0x6d8406c952429603u, 0xaab37fd7d8f58178u, 0xc8e5087ba6d33b83u,
+    0xd5605fcdcf32e1d6u, 0xfb1e4a9a90880a64u, 0x855c3be0a17fcd26u, 0x5cf2eea09a55067fu,
+    0xa6b34ad8c9dfc06fu, 0xf42faa48c0ea481eu, 0xd0601d8efc57b08bu, 0xf13b94daf124da26u,
+    0x823c12795db6ce57u, 0x76c53d08d6b70858u, 0xa2cb1717b52481edu, 0x54768c4b0c64ca6eu,
+    0xcb7ddcdda26da268u, 0xa9942f5dcf7dfd09u, 0xfe5d54150b090b02u, 0xd3f93b35435d7c4cu,
+    0x9efa548d26e5a6e1u, 0xc47bc5014a1a6dafu, 0xc6b8e9b0709f109au, 0x359ab6419ca1091bu,
+    0xf867241c8cc6d4c0u, 0xc30163d203c94b62u, 0x9b407691d7fc44f8u, 0x79e0de63425dcf1du,
+    0xc21094364dfb5636u, 0x985915fc12f542e4u, 0xf294b943e17a2bc4u, 0x3e6f5b7b17b2939du,
+    0x979cf3ca6cec5b5au, 0xa705992ceecf9c42u, 0xbd8430bd08277231u, 0x50c6ff782a838353u,
+    0xece53cec4a314ebdu, 0xa4f8bf5635246428u, 0x940f4613ae5ed136u, 0x871b7795e136be99u,
+    0xb913179899f68584u, 0x28e2557b59846e3fu, 0xe757dd7ec07426e5u, 0x331aeada2fe589cfu,
+    0x9096ea6f3848984fu, 0x3ff0d2c85def7621u, 0xb4bca50b065abe63u, 0x0fed077a756b53a9u,
+    0xe1ebce4dc7f16dfbu, 0xd3e8495912c62894u, 0x8d3360f09cf6e4bdu, 0x64712dd7abbbd95cu,
+    0xb080392cc4349decu, 0xbd8d794d96aacfb3u, 0xdca04777f541c567u, 0xecf0d7a0fc5583a0u,
+    0x89e42caaf9491b60u, 0xf41686c49db57244u, 0xac5d37d5b79b6239u, 0x311c2875c522ced5u,
+    0xd77485cb25823ac7u, 0x7d633293366b828bu, 0x86a8d39ef77164bcu, 0xae5dff9c02033197u,
+    0xa8530886b54dbdebu, 0xd9f57f830283fdfcu, 0xd267caa862a12d66u, 0xd072df63c324fd7bu,
+    0x8380dea93da4bc60u, 0x4247cb9e59f71e6du, 0xa46116538d0deb78u, 0x52d9be85f074e608u,
+    0xcd795be870516656u, 0x67902e276c921f8bu, 0x806bd9714632dff6u, 0x00ba1cd8a3db53b6u,
+    0xa086cfcd97bf97f3u, 0x80e8a40eccd228a4u, 0xc8a883c0fdaf7df0u, 0x6122cd128006b2cdu,
+    0xfad2a4b13d1b5d6cu, 0x796b805720085f81u, 0x9cc3a6eec6311a63u, 0xcbe3303674053bb0u,
+    0xc3f490aa77bd60fcu, 0xbedbfc4411068a9cu, 0xf4f1b4d515acb93bu, 0xee92fb5515482d44u,
+    0x991711052d8bf3c5u, 0x751bdd152d4d1c4au, 0xbf5cd54678eef0b6u, 0xd262d45a78a0635du,
+    0xef340a98172aace4u, 0x86fb897116c87c34u, 0x9580869f0e7aac0eu, 0xd45d35e6ae3d4da0u,
+    0xbae0a846d2195712u, 0x8974836059cca109u, 0xe998d258869facd7u, 0x2bd1a438703fc94bu,
+    0x91ff83775423cc06u, 0x7b6306a34627ddcfu, 0xb67f6455292cbf08u, 0x1a3bc84c17b1d542u,
+    0xe41f3d6a7377eecau, 0x20caba5f1d9e4a93u, 0x8e938662882af53eu, 0x547eb47b7282ee9cu,
+    0xb23867fb2a35b28du, 0xe99e619a4f23aa43u, 0xdec681f9f4c31f31u, 0x6405fa00e2ec94d4u,
+    0x8b3c113c38f9f37eu, 0xde83bc408dd3dd04u, 0xae0b158b4738705eu, 0x9624ab50b148d445u,
+    0xd98ddaee19068c76u, 0x3badd624dd9b0957u, 0x87f8a8d4cfa417c9u, 0xe54ca5d70a80e5d6u,
+    0xa9f6d30a038d1dbcu, 0x5e9fcf4ccd211f4cu, 0xd47487cc8470652bu, 0x7647c3200069671fu,
+    0x84c8d4dfd2c63f3bu, 0x29ecd9f40041e073u, 0xa5fb0a17c777cf09u, 0xf468107100525890u,
+    0xcf79cc9db955c2ccu, 0x7182148d4066eeb4u, 0x81ac1fe293d599bfu, 0xc6f14cd848405530u,
+    0xa21727db38cb002fu, 0xb8ada00e5a506a7cu, 0xca9cf1d206fdc03bu, 0xa6d90811f0e4851cu,
+    0xfd442e4688bd304au, 0x908f4a166d1da663u, 0x9e4a9cec15763e2eu, 0x9a598e4e043287feu,
+    0xc5dd44271ad3cdbau, 0x40eff1e1853f29fdu, 0xf7549530e188c128u, 0xd12bee59e68ef47cu,
+    0x9a94dd3e8cf578b9u, 0x82bb74f8301958ceu, 0xc13a148e3032d6e7u, 0xe36a52363c1faf01u,
+    0xf18899b1bc3f8ca1u, 0xdc44e6c3cb279ac1u, 0x96f5600f15a7b7e5u, 0x29ab103a5ef8c0b9u,
+    0xbcb2b812db11a5deu, 0x7415d448f6b6f0e7u, 0xebdf661791d60f56u, 0x111b495b3464ad21u,
+    0x936b9fcebb25c995u, 0xcab10dd900beec34u, 0xb84687c269ef3bfbu, 0x3d5d514f40eea742u,
+    0xe65829b3046b0afau, 0x0cb4a5a3112a5112u, 0x8ff71a0fe2c2e6dcu, 0x47f0e785eaba72abu,
+    0xb3f4e093db73a093u, 0x59ed216765690f56u, 0xe0f218b8d25088b8u, 0x306869c13ec3532cu,
+    0x8c974f7383725573u, 0x1e414218c73a13fbu, 0xafbd2350644eeacfu, 0xe5d1929ef90898fau,
+    0xdbac6c247d62a583u, 0xdf45f746b74abf39u, 0x894bc396ce5da772u, 0x6b8bba8c328eb783u,
+    0xab9eb47c81f5114fu, 0x066ea92f3f326564u, 0xd686619ba27255a2u, 0xc80a537b0efefebdu,
+    0x8613fd0145877585u, 0xbd06742ce95f5f36u, 0xa798fc4196e952e7u, 0x2c48113823b73704u,
+    0xd17f3b51fca3a7a0u, 0xf75a15862ca504c5u, 0x82ef85133de648c4u, 0x9a984d73dbe722fbu,
+    0xa3ab66580d5fdaf5u, 0xc13e60d0d2e0ebbau, 0xcc963fee10b7d1b3u, 0x318df905079926a8u,
+    0xffbbcfe994e5c61fu, 0xfdf17746497f7052u, 0x9fd561f1fd0f9bd3u, 0xfeb6ea8bedefa633u,
+    0xc7caba6e7c5382c8u, 0xfe64a52ee96b8fc0u, 0xf9bd690a1b68637bu, 0x3dfdce7aa3c673b0u,
+    0x9c1661a651213e2du, 0x06bea10ca65c084eu, 0xc31bfa0fe5698db8u, 0x486e494fcff30a62u,
+    0xf3e2f893dec3f126u, 0x5a89dba3c3efccfau, 0x986ddb5c6b3a76b7u, 0xf89629465a75e01cu,
+    0xbe89523386091465u, 0xf6bbb397f1135823u, 0xee2ba6c0678b597fu, 0x746aa07ded582e2cu,
+    0x94db483840b717efu, 0xa8c2a44eb4571cdcu, 0xba121a4650e4ddebu, 0x92f34d62616ce413u,
+    0xe896a0d7e51e1566u, 0x77b020baf9c81d17u, 0x915e2486ef32cd60u, 0x0ace1474dc1d122eu,
+    0xb5b5ada8aaff80b8u, 0x0d819992132456bau, 0xe3231912d5bf60e6u, 0x10e1fff697ed6c69u,
+    0x8df5efabc5979c8fu, 0xca8d3ffa1ef463c1u, 0xb1736b96b6fd83b3u, 0xbd308ff8a6b17cb2u,
+    0xddd0467c64bce4a0u, 0xac7cb3f6d05ddbdeu, 0x8aa22c0dbef60ee4u, 0x6bcdf07a423aa96bu,
+    0xad4ab7112eb3929du, 0x86c16c98d2c953c6u, 0xd89d64d57a607744u, 0xe871c7bf077ba8b7u,
+    0x87625f056c7c4a8bu, 0x11471cd764ad4972u, 0xa93af6c6c79b5d2du, 0xd598e40d3dd89bcfu,
+    0xd389b47879823479u, 0x4aff1d108d4ec2c3u, 0x843610cb4bf160cbu, 0xcedf722a585139bau,
+    0xa54394fe1eedb8feu, 0xc2974eb4ee658828u, 0xce947a3da6a9273eu, 0x733d226229feea32u,
+    0x811ccc668829b887u, 0x0806357d5a3f525fu, 0xa163ff802a3426a8u, 0xca07c2dcb0cf26f7u,
+    0xc9bcff6034c13052u, 0xfc89b393dd02f0b5u, 0xfc2c3f3841f17c67u, 0xbbac2078d443ace2u,
+    0x9d9ba7832936edc0u, 0xd54b944b84aa4c0du, 0xc5029163f384a931u, 0x0a9e795e65d4df11u,
+    0xf64335bcf065d37du, 0x4d4617b5ff4a16d5u, 0x99ea0196163fa42eu, 0x504bced1bf8e4e45u,
+    0xc06481fb9bcf8d39u, 0xe45ec2862f71e1d6u, 0xf07da27a82c37088u, 0x5d767327bb4e5a4cu,
+    0x964e858c91ba2655u, 0x3a6a07f8d510f86fu, 0xbbe226efb628afeau, 0x890489f70a55368bu,
+    0xeadab0aba3b2dbe5u, 0x2b45ac74ccea842eu, 0x92c8ae6b464fc96fu, 0x3b0b8bc90012929du,
+    0xb77ada0617e3bbcbu, 0x09ce6ebb40173744u, 0xe55990879ddcaabdu, 0xcc420a6a101d0515u,
+    0x8f57fa54c2a9eab6u, 0x9fa946824a12232du, 0xb32df8e9f3546564u, 0x47939822dc96abf9u,
+    0xdff9772470297ebdu, 0x59787e2b93bc56f7u, 0x8bfbea76c619ef36u, 0x57eb4edb3c55b65au,
+    0xaefae51477a06b03u, 0xede622920b6b23f1u, 0xdab99e59958885c4u, 0xe95fab368e45ecedu,
+    0x88b402f7fd75539bu, 0x11dbcb0218ebb414u, 0xaae103b5fcd2a881u, 0xd652bdc29f26a119u,
+    0xd59944a37c0752a2u, 0x4be76d3346f0495fu, 0x857fcae62d8493a5u, 0x6f70a4400c562ddbu,
+    0xa6dfbd9fb8e5b88eu, 0xcb4ccd500f6bb952u, 0xd097ad07a71f26b2u, 0x7e2000a41346a7a7u,
+    0x825ecc24c873782fu, 0x8ed400668c0c28c8u, 0xa2f67f2dfa90563bu, 0x728900802f0f32fau,
+    0xcbb41ef979346bcau, 0x4f2b40a03ad2ffb9u, 0xfea126b7d78186bcu, 0xe2f610c84987bfa8u,
+    0x9f24b832e6b0f436u, 0x0dd9ca7d2df4d7c9u, 0xc6ede63fa05d3143u, 0x91503d1c79720dbbu,
+    0xf8a95fcf88747d94u, 0x75a44c6397ce912au, 0x9b69dbe1b548ce7cu, 0xc986afbe3ee11abau,
+    0xc24452da229b021bu, 0xfbe85badce996168u, 0xf2d56790ab41c2a2u, 0xfae27299423fb9c3u,
+    0x97c560ba6b0919a5u, 0xdccd879fc967d41au, 0xbdb6b8e905cb600fu, 0x5400e987bbc1c920u,
+    0xed246723473e3813u, 0x290123e9aab23b68u, 0x9436c0760c86e30bu, 0xf9a0b6720aaf6521u,
+    0xb94470938fa89bceu, 0xf808e40e8d5b3e69u, 0xe7958cb87392c2c2u, 0xb60b1d1230b20e04u,
+    0x90bd77f3483bb9b9u, 0xb1c6f22b5e6f48c2u, 0xb4ecd5f01a4aa828u, 0x1e38aeb6360b1af3u,
+    0xe2280b6c20dd5232u, 0x25c6da63c38de1b0u, 0x8d590723948a535fu, 0x579c487e5a38ad0eu,
+    0xb0af48ec79ace837u, 0x2d835a9df0c6d851u, 0xdcdb1b2798182244u, 0xf8e431456cf88e65u,
+    0x8a08f0f8bf0f156bu, 0x1b8e9ecb641b58ffu, 0xac8b2d36eed2dac5u, 0xe272467e3d222f3fu,
+    0xd7adf884aa879177u, 0x5b0ed81dcc6abb0fu, 0x86ccbb52ea94baeau, 0x98e947129fc2b4e9u,
+    0xa87fea27a539e9a5u, 0x3f2398d747b36224u, 0xd29fe4b18e88640eu, 0x8eec7f0d19a03aadu,
+    0x83a3eeeef9153e89u, 0x1953cf68300424acu, 0xa48ceaaab75a8e2bu, 0x5fa8c3423c052dd7u,
+    0xcdb02555653131b6u, 0x3792f412cb06794du, 0x808e17555f3ebf11u, 0xe2bbd88bbee40bd0u,
+    0xa0b19d2ab70e6ed6u, 0x5b6aceaeae9d0ec4u, 0xc8de047564d20a8bu, 0xf245825a5a445275u,
+    0xfb158592be068d2eu, 0xeed6e2f0f0d56712u, 0x9ced737bb6c4183du, 0x55464dd69685606bu,
+    0xc428d05aa4751e4cu, 0xaa97e14c3c26b886u, 0xf53304714d9265dfu, 0xd53dd99f4b3066a8u,
+    0x993fe2c6d07b7fabu, 0xe546a8038efe4029u, 0xbf8fdb78849a5f96u, 0xde98520472bdd033u,
+    0xef73d256a5c0f77cu, 0x963e66858f6d4440u, 0x95a8637627989aadu, 0xdde7001379a44aa8u,
+    0xbb127c53b17ec159u, 0x5560c018580d5d52u, 0xe9d71b689dde71afu, 0xaab8f01e6e10b4a6u,
+    0x9226712162ab070du, 0xcab3961304ca70e8u, 0xb6b00d69bb55c8d1u, 0x3d607b97c5fd0d22u,
+    0xe45c10c42a2b3b05u, 0x8cb89a7db77c506au, 0x8eb98a7a9a5b04e3u, 0x77f3608e92adb242u,
+    0xb267ed1940f1c61cu, 0x55f038b237591ed3u, 0xdf01e85f912e37a3u, 0x6b6c46dec52f6688u,
+    0x8b61313bbabce2c6u, 0x2323ac4b3b3da015u, 0xae397d8aa96c1b77u, 0xabec975e0a0d081au,
+    0xd9c7dced53c72255u, 0x96e7bd358c904a21u, 0x881cea14545c7575u, 0x7e50d64177da2e54u,
+    0xaa242499697392d2u, 0xdde50bd1d5d0b9e9u, 0xd4ad2dbfc3d07787u, 0x955e4ec64b44e864u,
+    0x84ec3c97da624ab4u, 0xbd5af13bef0b113eu, 0xa6274bbdd0fadd61u, 0xecb1ad8aeacdd58eu,
+    0xcfb11ead453994bau, 0x67de18eda5814af2u, 0x81ceb32c4b43fcf4u, 0x80eacf948770ced7u,
+    0xa2425ff75e14fc31u, 0xa1258379a94d028du, 0xcad2f7f5359a3b3eu, 0x096ee45813a04330u,
+    0xfd87b5f28300ca0du, 0x8bca9d6e188853fcu, 0x9e74d1b791e07e48u, 0x775ea264cf55347eu,
+    0xc612062576589ddau, 0x95364afe032a819eu, 0xf79687aed3eec551u, 0x3a83ddbd83f52205u,
+    0x9abe14cd44753b52u, 0xc4926a9672793543u, 0xc16d9a0095928a27u, 0x75b7053c0f178294u,
+    0xf1c90080baf72cb1u, 0x5324c68b12dd6339u, 0x971da05074da7beeu, 0xd3f6fc16ebca5e04u,
+    0xbce5086492111aeau, 0x88f4bb1ca6bcf585u, 0xec1e4a7db69561a5u, 0x2b31e9e3d06c32e6u,
+    0x9392ee8e921d5d07u, 0x3aff322e62439fd0u, 0xb877aa3236a4b449u, 0x09befeb9fad487c3u,
+    0xe69594bec44de15bu, 0x4c2ebe687989a9b4u, 0x901d7cf73ab0acd9u, 0x0f9d37014bf60a11u,
+    0xb424dc35095cd80fu, 0x538484c19ef38c95u, 0xe12e13424bb40e13u, 0x2865a5f206b06fbau,
+    0x8cbccc096f5088cbu, 0xf93f87b7442e45d4u, 0xafebff0bcb24aafeu, 0xf78f69a51539d749u,
+    0xdbe6fecebdedd5beu, 0xb573440e5a884d1cu, 0x89705f4136b4a597u, 0x31680a88f8953031u,
+    0xabcc77118461cefcu, 0xfdc20d2b36ba7c3eu, 0xd6bf94d5e57a42bcu, 0x3d32907604691b4du,
+    0x8637bd05af6c69b5u, 0xa63f9a49c2c1b110u, 0xa7c5ac471b478423u, 0x0fcf80dc33721d54u,
+    0xd1b71758e219652bu, 0xd3c36113404ea4a9u, 0x83126e978d4fdf3bu, 0x645a1cac083126eau,
+    0xa3d70a3d70a3d70au, 0x3d70a3d70a3d70a4u, 0xccccccccccccccccu, 0xcccccccccccccccdu,
+    0x8000000000000000u, 0x0000000000000000u, 0xa000000000000000u, 0x0000000000000000u,
+    0xc800000000000000u, 0x0000000000000000u, 0xfa00000000000000u, 0x0000000000000000u,
+    0x9c40000000000000u, 0x0000000000000000u, 0xc350000000000000u, 0x0000000000000000u,
+    0xf424000000000000u, 0x0000000000000000u, 0x9896800000000000u, 0x0000000000000000u,
+    0xbebc200000000000u, 0x0000000000000000u, 0xee6b280000000000u, 0x0000000000000000u,
+    0x9502f90000000000u, 0x0000000000000000u, 0xba43b74000000000u, 0x0000000000000000u,
+    0xe8d4a51000000000u, 0x0000000000000000u, 0x9184e72a00000000u, 0x0000000000000000u,
+    0xb5e620f480000000u, 0x0000000000000000u, 0xe35fa931a0000000u, 0x0000000000000000u,
+    0x8e1bc9bf04000000u, 0x0000000000000000u, 0xb1a2bc2ec5000000u, 0x0000000000000000u,
+    0xde0b6b3a76400000u, 0x0000000000000000u, 0x8ac7230489e80000u, 0x0000000000000000u,
+    0xad78ebc5ac620000u, 0x0000000000000000u, 0xd8d726b7177a8000u, 0x0000000000000000u,
+    0x878678326eac9000u, 0x0000000000000000u, 0xa968163f0a57b400u, 0x0000000000000000u,
+    0xd3c21bcecceda100u, 0x0000000000000000u, 0x84595161401484a0u, 0x0000000000000000u,
+    0xa56fa5b99019a5c8u, 0x0000000000000000u, 0xcecb8f27f4200f3au, 0x0000000000000000u,
+    0x813f3978f8940984u, 0x4000000000000000u, 0xa18f07d736b90be5u, 0x5000000000000000u,
+    0xc9f2c9cd04674edeu, 0xa400000000000000u, 0xfc6f7c4045812296u, 0x4d00000000000000u,
+    0x9dc5ada82b70b59du, 0xf020000000000000u, 0xc5371912364ce305u, 0x6c28000000000000u,
+    0xf684df56c3e01bc6u, 0xc732000000000000u, 0x9a130b963a6c115cu, 0x3c7f400000000000u,
+    0xc097ce7bc90715b3u, 0x4b9f100000000000u, 0xf0bdc21abb48db20u, 0x1e86d40000000000u,
+    0x96769950b50d88f4u, 0x1314448000000000u, 0xbc143fa4e250eb31u, 0x17d955a000000000u,
+    0xeb194f8e1ae525fdu, 0x5dcfab0800000000u, 0x92efd1b8d0cf37beu, 0x5aa1cae500000000u,
+    0xb7abc627050305adu, 0xf14a3d9e40000000u, 0xe596b7b0c643c719u, 0x6d9ccd05d0000000u,
+    0x8f7e32ce7bea5c6fu, 0xe4820023a2000000u, 0xb35dbf821ae4f38bu, 0xdda2802c8a800000u,
+    0xe0352f62a19e306eu, 0xd50b2037ad200000u, 0x8c213d9da502de45u, 0x4526f422cc340000u,
+    0xaf298d050e4395d6u, 0x9670b12b7f410000u, 0xdaf3f04651d47b4cu, 0x3c0cdd765f114000u,
+    0x88d8762bf324cd0fu, 0xa5880a69fb6ac800u, 0xab0e93b6efee0053u, 0x8eea0d047a457a00u,
+    0xd5d238a4abe98068u, 0x72a4904598d6d880u, 0x85a36366eb71f041u, 0x47a6da2b7f864750u,
+    0xa70c3c40a64e6c51u, 0x999090b65f67d924u, 0xd0cf4b50cfe20765u, 0xfff4b4e3f741cf6du,
+    0x82818f1281ed449fu, 0xbff8f10e7a8921a4u, 0xa321f2d7226895c7u, 0xaff72d52192b6a0du,
+    0xcbea6f8ceb02bb39u, 0x9bf4f8a69f764490u, 0xfee50b7025c36a08u, 0x02f236d04753d5b4u,
+    0x9f4f2726179a2245u, 0x01d762422c946590u, 0xc722f0ef9d80aad6u, 0x424d3ad2b7b97ef5u,
+    0xf8ebad2b84e0d58bu, 0xd2e0898765a7deb2u, 0x9b934c3b330c8577u, 0x63cc55f49f88eb2fu,
+    0xc2781f49ffcfa6d5u, 0x3cbf6b71c76b25fbu, 0xf316271c7fc3908au, 0x8bef464e3945ef7au,
+    0x97edd871cfda3a56u, 0x97758bf0e3cbb5acu, 0xbde94e8e43d0c8ecu, 0x3d52eeed1cbea317u,
+    0xed63a231d4c4fb27u, 0x4ca7aaa863ee4bddu, 0x945e455f24fb1cf8u, 0x8fe8caa93e74ef6au,
+    0xb975d6b6ee39e436u, 0xb3e2fd538e122b44u, 0xe7d34c64a9c85d44u, 0x60dbbca87196b616u,
+    0x90e40fbeea1d3a4au, 0xbc8955e946fe31cdu, 0xb51d13aea4a488ddu, 0x6babab6398bdbe41u,
+    0xe264589a4dcdab14u, 0xc696963c7eed2dd1u, 0x8d7eb76070a08aecu, 0xfc1e1de5cf543ca2u,
+    0xb0de65388cc8ada8u, 0x3b25a55f43294bcbu, 0xdd15fe86affad912u, 0x49ef0eb713f39ebeu,
+    0x8a2dbf142dfcc7abu, 0x6e3569326c784337u, 0xacb92ed9397bf996u, 0x49c2c37f07965404u,
+    0xd7e77a8f87daf7fbu, 0xdc33745ec97be906u, 0x86f0ac99b4e8dafdu, 0x69a028bb3ded71a3u,
+    0xa8acd7c0222311bcu, 0xc40832ea0d68ce0cu, 0xd2d80db02aabd62bu, 0xf50a3fa490c30190u,
+    0x83c7088e1aab65dbu, 0x792667c6da79e0fau, 0xa4b8cab1a1563f52u, 0x577001b891185938u,
+    0xcde6fd5e09abcf26u, 0xed4c0226b55e6f86u, 0x80b05e5ac60b6178u, 0x544f8158315b05b4u,
+    0xa0dc75f1778e39d6u, 0x696361ae3db1c721u, 0xc913936dd571c84cu, 0x03bc3a19cd1e38e9u,
+    0xfb5878494ace3a5fu, 0x04ab48a04065c723u, 0x9d174b2dcec0e47bu, 0x62eb0d64283f9c76u,
+    0xc45d1df942711d9au, 0x3ba5d0bd324f8394u, 0xf5746577930d6500u, 0xca8f44ec7ee36479u,
+    0x9968bf6abbe85f20u, 0x7e998b13cf4e1ecbu, 0xbfc2ef456ae276e8u, 0x9e3fedd8c321a67eu,
+    0xefb3ab16c59b14a2u, 0xc5cfe94ef3ea101eu, 0x95d04aee3b80ece5u, 0xbba1f1d158724a12u,
+    0xbb445da9ca61281fu, 0x2a8a6e45ae8edc97u, 0xea1575143cf97226u, 0xf52d09d71a3293bdu,
+    0x924d692ca61be758u, 0x593c2626705f9c56u, 0xb6e0c377cfa2e12eu, 0x6f8b2fb00c77836cu,
+    0xe498f455c38b997au, 0x0b6dfb9c0f956447u, 0x8edf98b59a373fecu, 0x4724bd4189bd5eacu,
+    0xb2977ee300c50fe7u, 0x58edec91ec2cb657u, 0xdf3d5e9bc0f653e1u, 0x2f2967b66737e3edu,
+    0x8b865b215899f46cu, 0xbd79e0d20082ee74u, 0xae67f1e9aec07187u, 0xecd8590680a3aa11u,
+    0xda01ee641a708de9u, 0xe80e6f4820cc9495u, 0x884134fe908658b2u, 0x3109058d147fdcddu,
+    0xaa51823e34a7eedeu, 0xbd4b46f0599fd415u, 0xd4e5e2cdc1d1ea96u, 0x6c9e18ac7007c91au,
+    0x850fadc09923329eu, 0x03e2cf6bc604ddb0u, 0xa6539930bf6bff45u, 0x84db8346b786151cu,
+    0xcfe87f7cef46ff16u, 0xe612641865679a63u, 0x81f14fae158c5f6eu, 0x4fcb7e8f3f60c07eu,
+    0xa26da3999aef7749u, 0xe3be5e330f38f09du, 0xcb090c8001ab551cu, 0x5cadf5bfd3072cc5u,
+    0xfdcb4fa002162a63u, 0x73d9732fc7c8f7f6u, 0x9e9f11c4014dda7eu, 0x2867e7fddcdd9afau,
+    0xc646d63501a1511du, 0xb281e1fd541501b8u, 0xf7d88bc24209a565u, 0x1f225a7ca91a4226u,
+    0x9ae757596946075fu, 0x3375788de9b06958u, 0xc1a12d2fc3978937u, 0x0052d6b1641c83aeu,
+    0xf209787bb47d6b84u, 0xc0678c5dbd23a49au, 0x9745eb4d50ce6332u, 0xf840b7ba963646e0u,
+    0xbd176620a501fbffu, 0xb650e5a93bc3d898u, 0xec5d3fa8ce427affu, 0xa3e51f138ab4cebeu,
+    0x93ba47c980e98cdfu, 0xc66f336c36b10137u, 0xb8a8d9bbe123f017u, 0xb80b0047445d4184u,
+    0xe6d3102ad96cec1du, 0xa60dc059157491e5u, 0x9043ea1ac7e41392u, 0x87c89837ad68db2fu,
+    0xb454e4a179dd1877u, 0x29babe4598c311fbu, 0xe16a1dc9d8545e94u, 0xf4296dd6fef3d67au,
+    0x8ce2529e2734bb1du, 0x1899e4a65f58660cu, 0xb01ae745b101e9e4u, 0x5ec05dcff72e7f8fu,
+    0xdc21a1171d42645du, 0x76707543f4fa1f73u, 0x899504ae72497ebau, 0x6a06494a791c53a8u,
+    0xabfa45da0edbde69u, 0x0487db9d17636892u, 0xd6f8d7509292d603u, 0x45a9d2845d3c42b6u,
+    0x865b86925b9bc5c2u, 0x0b8a2392ba45a9b2u, 0xa7f26836f282b732u, 0x8e6cac7768d7141eu,
+    0xd1ef0244af2364ffu, 0x3207d795430cd926u, 0x8335616aed761f1fu, 0x7f44e6bd49e807b8u,
+    0xa402b9c5a8d3a6e7u, 0x5f16206c9c6209a6u, 0xcd036837130890a1u, 0x36dba887c37a8c0fu,
+    0x802221226be55a64u, 0xc2494954da2c9789u, 0xa02aa96b06deb0fdu, 0xf2db9baa10b7bd6cu,
+    0xc83553c5c8965d3du, 0x6f92829494e5acc7u, 0xfa42a8b73abbf48cu, 0xcb772339ba1f17f9u,
+    0x9c69a97284b578d7u, 0xff2a760414536efbu, 0xc38413cf25e2d70du, 0xfef5138519684abau,
+    0xf46518c2ef5b8cd1u, 0x7eb258665fc25d69u, 0x98bf2f79d5993802u, 0xef2f773ffbd97a61u,
+    0xbeeefb584aff8603u, 0xaafb550ffacfd8fau, 0xeeaaba2e5dbf6784u, 0x95ba2a53f983cf38u,
+    0x952ab45cfa97a0b2u, 0xdd945a747bf26183u, 0xba756174393d88dfu, 0x94f971119aeef9e4u,
+    0xe912b9d1478ceb17u, 0x7a37cd5601aab85du, 0x91abb422ccb812eeu, 0xac62e055c10ab33au,
+    0xb616a12b7fe617aau, 0x577b986b314d6009u, 0xe39c49765fdf9d94u, 0xed5a7e85fda0b80bu,
+    0x8e41ade9fbebc27du, 0x14588f13be847307u, 0xb1d219647ae6b31cu, 0x596eb2d8ae258fc8u,
+    0xde469fbd99a05fe3u, 0x6fca5f8ed9aef3bbu, 0x8aec23d680043beeu, 0x25de7bb9480d5854u,
+    0xada72ccc20054ae9u, 0xaf561aa79a10ae6au, 0xd910f7ff28069da4u, 0x1b2ba1518094da04u,
+    0x87aa9aff79042286u, 0x90fb44d2f05d0842u, 0xa99541bf57452b28u, 0x353a1607ac744a53u,
+    0xd3fa922f2d1675f2u, 0x42889b8997915ce8u, 0x847c9b5d7c2e09b7u, 0x69956135febada11u,
+    0xa59bc234db398c25u, 0x43fab9837e699095u, 0xcf02b2c21207ef2eu, 0x94f967e45e03f4bbu,
+    0x8161afb94b44f57du, 0x1d1be0eebac278f5u, 0xa1ba1ba79e1632dcu, 0x6462d92a69731732u,
+    0xca28a291859bbf93u, 0x7d7b8f7503cfdcfeu, 0xfcb2cb35e702af78u, 0x5cda735244c3d43eu,
+    0x9defbf01b061adabu, 0x3a0888136afa64a7u, 0xc56baec21c7a1916u, 0x088aaa1845b8fdd0u,
+    0xf6c69a72a3989f5bu, 0x8aad549e57273d45u, 0x9a3c2087a63f6399u, 0x36ac54e2f678864bu,
+    0xc0cb28a98fcf3c7fu, 0x84576a1bb416a7ddu, 0xf0fdf2d3f3c30b9fu, 0x656d44a2a11c51d5u,
+    0x969eb7c47859e743u, 0x9f644ae5a4b1b325u, 0xbc4665b596706114u, 0x873d5d9f0dde1feeu,
+    0xeb57ff22fc0c7959u, 0xa90cb506d155a7eau, 0x9316ff75dd87cbd8u, 0x09a7f12442d588f2u,
+    0xb7dcbf5354e9beceu, 0x0c11ed6d538aeb2fu, 0xe5d3ef282a242e81u, 0x8f1668c8a86da5fau,
+    0x8fa475791a569d10u, 0xf96e017d694487bcu, 0xb38d92d760ec4455u, 0x37c981dcc395a9acu,
+    0xe070f78d3927556au, 0x85bbe253f47b1417u, 0x8c469ab843b89562u, 0x93956d7478ccec8eu,
+    0xaf58416654a6babbu, 0x387ac8d1970027b2u, 0xdb2e51bfe9d0696au, 0x06997b05fcc0319eu,
+    0x88fcf317f22241e2u, 0x441fece3bdf81f03u, 0xab3c2fddeeaad25au, 0xd527e81cad7626c3u,
+    0xd60b3bd56a5586f1u, 0x8a71e223d8d3b074u, 0x85c7056562757456u, 0xf6872d5667844e49u,
+    0xa738c6bebb12d16cu, 0xb428f8ac016561dbu, 0xd106f86e69d785c7u, 0xe13336d701beba52u,
+    0x82a45b450226b39cu, 0xecc0024661173473u, 0xa34d721642b06084u, 0x27f002d7f95d0190u,
+    0xcc20ce9bd35c78a5u, 0x31ec038df7b441f4u, 0xff290242c83396ceu, 0x7e67047175a15271u,
+    0x9f79a169bd203e41u, 0x0f0062c6e984d386u, 0xc75809c42c684dd1u, 0x52c07b78a3e60868u,
+    0xf92e0c3537826145u, 0xa7709a56ccdf8a82u, 0x9bbcc7a142b17ccbu, 0x88a66076400bb691u,
+    0xc2abf989935ddbfeu, 0x6acff893d00ea435u, 0xf356f7ebf83552feu, 0x0583f6b8c4124d43u,
+    0x98165af37b2153deu, 0xc3727a337a8b704au, 0xbe1bf1b059e9a8d6u, 0x744f18c0592e4c5cu,
+    0xeda2ee1c7064130cu, 0x1162def06f79df73u, 0x9485d4d1c63e8be7u, 0x8addcb5645ac2ba8u,
+    0xb9a74a0637ce2ee1u, 0x6d953e2bd7173692u, 0xe8111c87c5c1ba99u, 0xc8fa8db6ccdd0437u,
+    0x910ab1d4db9914a0u, 0x1d9c9892400a22a2u, 0xb54d5e4a127f59c8u, 0x2503beb6d00cab4bu,
+    0xe2a0b5dc971f303au, 0x2e44ae64840fd61du, 0x8da471a9de737e24u, 0x5ceaecfed289e5d2u,
+    0xb10d8e1456105dadu, 0x7425a83e872c5f47u, 0xdd50f1996b947518u, 0xd12f124e28f77719u,
+    0x8a5296ffe33cc92fu, 0x82bd6b70d99aaa6fu, 0xace73cbfdc0bfb7bu, 0x636cc64d1001550bu,
+    0xd8210befd30efa5au, 0x3c47f7e05401aa4eu, 0x8714a775e3e95c78u, 0x65acfaec34810a71u,
+    0xa8d9d1535ce3b396u, 0x7f1839a741a14d0du, 0xd31045a8341ca07cu, 0x1ede48111209a050u,
+    0x83ea2b892091e44du, 0x934aed0aab460432u, 0xa4e4b66b68b65d60u, 0xf81da84d5617853fu,
+    0xce1de40642e3f4b9u, 0x36251260ab9d668eu, 0x80d2ae83e9ce78f3u, 0xc1d72b7c6b426019u,
+    0xa1075a24e4421730u, 0xb24cf65b8612f81fu, 0xc94930ae1d529cfcu, 0xdee033f26797b627u,
+    0xfb9b7cd9a4a7443cu, 0x169840ef017da3b1u, 0x9d412e0806e88aa5u, 0x8e1f289560ee864eu,
+    0xc491798a08a2ad4eu, 0xf1a6f2bab92a27e2u, 0xf5b5d7ec8acb58a2u, 0xae10af696774b1dbu,
+    0x9991a6f3d6bf1765u, 0xacca6da1e0a8ef29u, 0xbff610b0cc6edd3fu, 0x17fd090a58d32af3u,
+    0xeff394dcff8a948eu, 0xddfc4b4cef07f5b0u, 0x95f83d0a1fb69cd9u, 0x4abdaf101564f98eu,
+    0xbb764c4ca7a4440fu, 0x9d6d1ad41abe37f1u, 0xea53df5fd18d5513u, 0x84c86189216dc5edu,
+    0x92746b9be2f8552cu, 0x32fd3cf5b4e49bb4u, 0xb7118682dbb66a77u, 0x3fbc8c33221dc2a1u,
+    0xe4d5e82392a40515u, 0x0fabaf3feaa5334au, 0x8f05b1163ba6832du, 0x29cb4d87f2a7400eu,
+    0xb2c71d5bca9023f8u, 0x743e20e9ef511012u, 0xdf78e4b2bd342cf6u, 0x914da9246b255416u,
+    0x8bab8eefb6409c1au, 0x1ad089b6c2f7548eu, 0xae9672aba3d0c320u, 0xa184ac2473b529b1u,
+    0xda3c0f568cc4f3e8u, 0xc9e5d72d90a2741eu, 0x8865899617fb1871u, 0x7e2fa67c7a658892u,
+    0xaa7eebfb9df9de8du, 0xddbb901b98feeab7u, 0xd51ea6fa85785631u, 0x552a74227f3ea565u,
+    0x8533285c936b35deu, 0xd53a88958f87275fu, 0xa67ff273b8460356u, 0x8a892abaf368f137u,
+    0xd01fef10a657842cu, 0x2d2b7569b0432d85u, 0x8213f56a67f6b29bu, 0x9c3b29620e29fc73u,
+    0xa298f2c501f45f42u, 0x8349f3ba91b47b8fu, 0xcb3f2f7642717713u, 0x241c70a936219a73u,
+    0xfe0efb53d30dd4d7u, 0xed238cd383aa0110u, 0x9ec95d1463e8a506u, 0xf4363804324a40aau,
+    0xc67bb4597ce2ce48u, 0xb143c6053edcd0d5u, 0xf81aa16fdc1b81dau, 0xdd94b7868e94050au,
+    0x9b10a4e5e9913128u, 0xca7cf2b4191c8326u, 0xc1d4ce1f63f57d72u, 0xfd1c2f611f63a3f0u,
+    0xf24a01a73cf2dccfu, 0xbc633b39673c8cecu, 0x976e41088617ca01u, 0xd5be0503e085d813u,
+    0xbd49d14aa79dbc82u, 0x4b2d8644d8a74e18u, 0xec9c459d51852ba2u, 0xddf8e7d60ed1219eu,
+    0x93e1ab8252f33b45u, 0xcabb90e5c942b503u, 0xb8da1662e7b00a17u, 0x3d6a751f3b936243u,
+    0xe7109bfba19c0c9du, 0x0cc512670a783ad4u, 0x906a617d450187e2u, 0x27fb2b80668b24c5u,
+    0xb484f9dc9641e9dau, 0xb1f9f660802dedf6u, 0xe1a63853bbd26451u, 0x5e7873f8a0396973u,
+    0x8d07e33455637eb2u, 0xdb0b487b6423e1e8u, 0xb049dc016abc5e5fu, 0x91ce1a9a3d2cda62u,
+    0xdc5c5301c56b75f7u, 0x7641a140cc7810fbu, 0x89b9b3e11b6329bau, 0xa9e904c87fcb0a9du,
+    0xac2820d9623bf429u, 0x546345fa9fbdcd44u, 0xd732290fbacaf133u, 0xa97c177947ad4095u,
+    0x867f59a9d4bed6c0u, 0x49ed8eabcccc485du, 0xa81f301449ee8c70u, 0x5c68f256bfff5a74u,
+    0xd226fc195c6a2f8cu, 0x73832eec6fff3111u, 0x83585d8fd9c25db7u, 0xc831fd53c5ff7eabu,
+    0xa42e74f3d032f525u, 0xba3e7ca8b77f5e55u, 0xcd3a1230c43fb26fu, 0x28ce1bd2e55f35ebu,
+    0x80444b5e7aa7cf85u, 0x7980d163cf5b81b3u, 0xa0555e361951c366u, 0xd7e105bcc332621fu,
+    0xc86ab5c39fa63440u, 0x8dd9472bf3fefaa7u, 0xfa856334878fc150u, 0xb14f98f6f0feb951u,
+    0x9c935e00d4b9d8d2u, 0x6ed1bf9a569f33d3u, 0xc3b8358109e84f07u, 0x0a862f80ec4700c8u,
+    0xf4a642e14c6262c8u, 0xcd27bb612758c0fau, 0x98e7e9cccfbd7dbdu, 0x8038d51cb897789cu,
+    0xbf21e44003acdd2cu, 0xe0470a63e6bd56c3u, 0xeeea5d5004981478u, 0x1858ccfce06cac74u,
+    0x95527a5202df0ccbu, 0x0f37801e0c43ebc8u, 0xbaa718e68396cffdu, 0xd30560258f54e6bau,
+    0xe950df20247c83fdu, 0x47c6b82ef32a2069u, 0x91d28b7416cdd27eu, 0x4cdc331d57fa5441u,
+    0xb6472e511c81471du, 0xe0133fe4adf8e952u, 0xe3d8f9e563a198e5u, 0x58180fddd97723a6u,
+    0x8e679c2f5e44ff8fu, 0x570f09eaa7ea7648u
+};
+
+// Exactly representable powers of ten for the Clinger fast path.
+static const double json_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Full 64x64 -> 128 bit multiplication.
+static uint64_t json_mul128(uint64_t a, uint64_t b, uint64_t* hi) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 json_uint128;
+    json_uint128 r = (json_uint128)a * b;
+    *hi = (uint64_t)(r >> 64);
+    return (uint64_t)r;
+#else
+    uint64_t al = (uint32_t)a, ah = a >> 32, bl = (uint32_t)b, bh = b >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (uint32_t)ll;
+#endif
 }
 
-static int json_parse_value(json_context* c, json_value* v); // Forward declare
-static int json_parse_array(json_context* c, json_value* v) {
-    size_t size = 0;
-    int ret;
-    EXPECT(c, '[');
-    json_parse_whitespace(c);
-    if (*c->json == ']') {
-        c->json++;
-        v->type = JSON_ARRAY;
-        v->u.a.size = 0;
-        v->u.a.e = NULL;
-        return JSON_PARSE_OK;
+static int json_clz64(uint64_t x) {
+    int n = 0;
+    assert(x != 0);
+    while (!(x & ((uint64_t)1 << 63))) {
+        x <<= 1;
+        n++;
     }
-    // Process recursively
-    while(1) {
-        json_value e;
-        json_init(&e);
-        if ((ret = json_parse_value(c, &e)) != JSON_PARSE_OK)
-            break;
-        // Push(or copy) element e into stack
-        memcpy(json_context_push(c, sizeof(json_value)), &e, sizeof(json_value));
-        size++;
-        json_parse_whitespace(c);
-        if (*c->json == ',') {
-            c->json++;
-            json_parse_whitespace(c);
-        }
-        else if (*c->json == ']') {
-            c->json++;
-            v->type = JSON_ARRAY;
-            v->u.a.size = size;
-            size *= sizeof(json_value);
-            // Copy full buffer into json_value
-            memcpy(v->u.a.e = (json_value*)malloc(size), json_context_pop(c, size), size);
-            return JSON_PARSE_OK;
-        }
-        else {
-            ret = JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
-            break;
-        }
+    return n;
+}
+
+// Eisel-Lemire: w * 10^q to the nearest double, w != 0 and q in table range.
+// Returns the IEEE-754 bit pattern without sign.
+static uint64_t json_eisel_lemire(uint64_t w, int q) {
+    const uint64_t* pow5 = &json_pow5_128[2 * (q - JSON_POW5_MIN_EXP)];
+    uint64_t lo, hi, hi2, mantissa;
+    int lz = json_clz64(w), upperbit, shift, power2;
+    w <<= lz;
+    lo = json_mul128(w, pow5[0], &hi);
+    // The lower word of 5^q only matters when the upper product is inexact
+    if ((hi & 0x1FF) == 0x1FF) {
+        json_mul128(w, pow5[1], &hi2);
+        lo += hi2;
+        if (hi2 > lo)
+            hi++;
+    }
+    upperbit = (int)(hi >> 63);
+    shift = upperbit + 64 - 52 - 3;
+    mantissa = hi >> shift;
+    power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+    if (power2 <= 0) {
+        // Subnormal
+        if (-power2 + 1 >= 64)
+            return 0;
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < ((uint64_t)1 << 52) ? 0 : 1;
+        return ((uint64_t)power2 << 52) | (mantissa & (((uint64_t)1 << 52) - 1));
+    }
+    // Exactly halfway between two doubles: round to even instead of up
+    if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi)
+        mantissa &= ~(uint64_t)1;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= ((uint64_t)2 << 52)) {
+        mantissa = (uint64_t)1 << 52;
+        power2++;
+    }
+    mantissa &= ~((uint64_t)1 << 52);
+    if (power2 >= 0x7FF)
+        return (uint64_t)0x7FF << 52;
+    return ((uint64_t)power2 << 52) | mantissa;
+}
+
+// Slow path for mantissas with more than 19 significant digits that
+// Eisel-Lemire cannot settle. The text has already been validated as a JSON
+// number, swap '.' for the locale's decimal point so strtod() agrees with it.
+static double json_strtod(const char* p, size_t len) {
+    char buf[64];
+    char* s = len < sizeof(buf) ? buf : (char*)JSON_MALLOC(json_heap, len + 1);
+    char point = localeconv()->decimal_point[0];
+    double d;
+    size_t i;
+    for (i = 0; i < len; i++)
+        s[i] = p[i] == '.' ? point : p[i];
+    s[len] = '\0';
+    d = strtod(s, NULL);
+    if (s != buf)
+        JSON_FREE(json_heap, s);
+    return d;
+}
+
+// Convert a validated number -w * 10^q (or w * 10^q) into a double.
+static double json_decimal_to_double(int neg, uint64_t w, int q, int truncated, const char* p, size_t len) {
+    uint64_t bits;
+    double d;
+#if FLT_EVAL_METHOD == 0
+    // Clinger: both operands are exact, so is the correctly rounded result
+    if (!truncated && w <= ((uint64_t)1 << 53) && q >= -22 && q <= 22) {
+        d = (double)w;
+        d = q < 0 ? d / json_pow10[-q] : d * json_pow10[q];
+        return neg ? -d : d;
+    }
+#endif
+    if (w == 0 || q < JSON_POW5_MIN_EXP)
+        bits = 0;
+    else if (q > JSON_POW5_MAX_EXP)
+        bits = (uint64_t)0x7FF << 52;
+    else {
+        bits = json_eisel_lemire(w, q);
+        // Digits were dropped: the result is only known when w and w + 1 agree
+        if (truncated && (w == UINT64_MAX || bits != json_eisel_lemire(w + 1, q)))
+            return json_strtod(p, len);
+    }
+    if (neg)
+        bits |= (uint64_t)1 << 63;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// number = [ "-" ] int [ frac ] [ exp ]
+// Integers that fit are kept exactly as int64 or uint64, everything else is
+// converted into a correctly rounded double.
+static int json_parse_number(json_context* c, json_value* v) {
+    const char* start = c->json;
+    const char* p = start;
+    const char* limit = c->end;
+    const char* digits;
+    const char* end;
+    int neg = 0, is_int = 1, q = 0, nd = 0, frac = 0, truncated = 0;
+    uint64_t w = 0;
+
+    // Validate
+    if (p != limit && *p == '-') {
+        neg = 1;
+        p++;
+    }
+    digits = p;
+    if (p != limit && *p == '0')
+        p++;
+    else if (p != limit && ISDIGIT1TO9(*p))
+        while (p != limit && ISDIGIT(*p))
+            p++;
+    else
+        return JSON_PARSE_INVALID_VALUE;
+    if (p != limit && *p == '.') {
+        p++;
+        if (p == limit || !ISDIGIT(*p))
+            return JSON_PARSE_INVALID_VALUE;
+        while (p != limit && ISDIGIT(*p))
+            p++;
+        is_int = 0;
+    }
+    if (p != limit && (*p == 'e' || *p == 'E')) {
+        int eneg = 0, e = 0;
+        p++;
+        if (p != limit && (*p == '+' || *p == '-'))
+            eneg = *p++ == '-';
+        if (p == limit || !ISDIGIT(*p))
+            return JSON_PARSE_INVALID_VALUE;
+        // Saturate, anything this large under- or overflows anyway
+        for (; p != limit && ISDIGIT(*p); p++)
+            if (e < 100000)
+                e = e * 10 + (*p - '0');
+        q = eneg ? -e : e;
+        is_int = 0;
+    }
+    end = p;
+
+    // Integer fast path
+    if (is_int) {
+        for (p = digits; p != end; p++) {
+            unsigned d = *p - '0';
+            if (w > (UINT64_MAX - d) / 10)
+                break;
+            w = w * 10 + d;
+        }
+        // -0 has no integer representation, keep it as a double
+        if (p == end && !(neg && w == 0) && (!neg || w <= (uint64_t)INT64_MAX + 1)) {
+            if (neg) {
+                v->u.i = w == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)w;
+                v->flags = JSON_FLAG_INT64;
+            }
+            else if (w <= INT64_MAX) {
+                v->u.i = (int64_t)w;
+                v->flags = JSON_FLAG_INT64;
+            }
+            else {
+                v->u.ui = w;
+                v->flags = JSON_FLAG_UINT64;
+            }
+            v->type = JSON_NUMBER;
+            c->json = end;
+            return JSON_PARSE_OK;
+        }
+        w = 0;
+    }
+
+    // Up to 19 significant digits into w, the rest only moves the exponent
+    for (p = digits; p != end && *p != 'e' && *p != 'E'; p++) {
+        unsigned d;
+        if (*p == '.') {
+            frac = 1;
+            continue;
+        }
+        d = *p - '0';
+        if (w == 0 && d == 0)
+            q -= frac; // Leading zero
+        else if (nd < 19) {
+            w = w * 10 + d;
+            nd++;
+            q -= frac;
+        }
+        else {
+            q += !frac;
+            truncated |= d != 0;
+        }
+    }
+    v->u.n = json_decimal_to_double(neg, w, q, truncated, start, end - start);
+    if (v->u.n == HUGE_VAL || v->u.n == -HUGE_VAL)
+        return JSON_PARSE_NUMBER_TOO_BIG;
+    v->type = JSON_NUMBER;
+    v->flags = 0;
+    c->json = end;
+    return JSON_PARSE_OK;
+}
+
+static int json_parse_value(json_context* c, json_value* v); // Forward declare
+static int json_parse_array(json_context* c, json_value* v) {
+    size_t size = 0;
+    int ret;
+    EXPECT(c, '[');
+    json_parse_whitespace(c);
+    if (PEEK(c) == ']') {
+        c->json++;
+        v->type = JSON_ARRAY;
+        v->flags = JSON_CONTEXT_FLAGS(c) & JSON_FLAG_BORROWED;
+        v->u.a.size = 0;
+        v->u.a.capacity = 0;
+        v->u.a.e = (json_value*)json_context_items(c, v, 0);
+        return JSON_PARSE_OK;
+    }
+    // Process recursively
+    while(1) {
+        json_value e;
+        json_init(&e);
+        if ((ret = json_parse_value(c, &e)) != JSON_PARSE_OK)
+            break;
+        // Push(or copy) element e into stack
+        memcpy(json_context_push(c, sizeof(json_value)), &e, sizeof(json_value));
+        size++;
+        json_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            json_parse_whitespace(c);
+        }
+        else if (PEEK(c) == ']') {
+            c->json++;
+            v->type = JSON_ARRAY;
+            v->flags = JSON_CONTEXT_FLAGS(c) & JSON_FLAG_BORROWED;
+            v->u.a.size = size;
+            v->u.a.capacity = size;
+            size *= sizeof(json_value);
+            // Copy full buffer into json_value
+            memcpy(v->u.a.e = (json_value*)json_context_items(c, v, size), json_context_pop(c, size), size);
+            return JSON_PARSE_OK;
+        }
+        else {
+            ret = JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            break;
+        }
+    }
+    // Free allocated memory when parsing failed
+    for (size_t i = 0; i < size; i++)
+        json_free((json_value*)json_context_pop(c, sizeof(json_value)));
+
+    return ret;
+}
+
+static int json_parse_object(json_context* c, json_value* v) {
+    size_t i, size;
+    json_member m;
+    int ret;
+    EXPECT(c, '{');
+    json_parse_whitespace(c);
+    if (PEEK(c) == '}') {
+        c->json++;
+        v->type = JSON_OBJECT;
+        v->flags = JSON_CONTEXT_FLAGS(c);
+        v->u.o.m = (json_member*)json_context_items(c, v, 0);
+        v->u.o.size = 0;
+        v->u.o.capacity = 0;
+        v->u.o.index = NULL;
+        return JSON_PARSE_OK;
+    }
+    m.k = NULL;
+    size = 0;
+    while(1) {
+        char* str;
+        json_init(&m.v);
+
+        // parse key
+        if (PEEK(c) != '"') {
+            ret = JSON_PARSE_MISS_KEY;
+            break;
+        }
+        if ((ret = json_parse_string_raw(c, &str, &m.klen)) != JSON_PARSE_OK)
+            break;
+        m.k = json_context_key(c, str, m.klen);
+
+        // parse ws colon ws
+        json_parse_whitespace(c);
+        if (PEEK(c) != ':') {
+            ret = JSON_PARSE_MISS_COLON;
+            break;
+        }
+        c->json++;
+        json_parse_whitespace(c);
+
+        // parse value
+        if ((ret = json_parse_value(c, &m.v)) != JSON_PARSE_OK)
+            break;
+        memcpy(json_context_push(c, sizeof(json_member)), &m, sizeof(json_member));
+        size++;
+        m.k = NULL; // ownership is transferred to member on stack
+
+        // parse comma or right-curly-brace
+        json_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            json_parse_whitespace(c);
+        }
+        else if (PEEK(c) == '}') {
+            size_t s = sizeof(json_member) * size;
+            c->json++;
+            v->type = JSON_OBJECT;
+            v->flags = JSON_CONTEXT_FLAGS(c);
+            v->u.o.size = size;
+            v->u.o.capacity = size;
+            memcpy(v->u.o.m = (json_member*)json_context_items(c, v, s), json_context_pop(c, s), s);
+            v->u.o.index = json_context_index(c, v);
+            return JSON_PARSE_OK;
+        }
+        else {
+            ret = JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        }
+    }
+    // Pop and free members on the stack, borrowed keys are left alone
+    if (!(JSON_CONTEXT_FLAGS(c) & JSON_FLAG_KEYS_BORROWED))
+        JSON_FREE(json_heap, m.k);
+    for (i = 0; i < size; i++) {
+        json_member* m = (json_member*)json_context_pop(c, sizeof(json_member));
+        if (!(JSON_CONTEXT_FLAGS(c) & JSON_FLAG_KEYS_BORROWED))
+            JSON_FREE(json_heap, m->k);
+        json_free(&m->v);
+    }
+    v->type = JSON_NULL;
+    return ret;
+}
+
+static int json_parse_value(json_context* c, json_value* v) {
+    int ret;
+    switch (PEEK(c)) { // Equals to c->json[0] before the end
+        case 'n':  return json_parse_literal(c, v, "null", JSON_NULL);
+        case 't':  return json_parse_literal(c, v, "true", JSON_TRUE);
+        case 'f':  return json_parse_literal(c, v, "false", JSON_FALSE);
+        case '\"': return json_parse_string(c, v);
+        case '\0': return JSON_PARSE_EXPECT_VALUE;
+        case '[':
+        case '{':
+            if (c->depth == c->max_depth)
+                return JSON_PARSE_DEPTH_EXCEEDED;
+            c->depth++;
+            ret = *c->json == '[' ? json_parse_array(c, v) : json_parse_object(c, v);
+            c->depth--;
+            return ret;
+        default:   return json_parse_number(c, v);
+    }
+}
+
+// Parse a whole document: ws value ws
+static int json_parse_root(json_context* c, json_value* v) {
+    int ret;
+    json_init(v);
+    json_parse_whitespace(c);
+    if ((ret = json_parse_value(c, v)) == JSON_PARSE_OK) {
+        json_parse_whitespace(c);
+        // Has extra chars at the end of the value, fail it
+        if (c->json != c->end) {
+            json_free(v);
+            ret = JSON_PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    assert(c->top == 0);
+    return ret;
+}
+
+static int json_parse_descent(json_value* v, const char* json, size_t len) {
+    int ret;
+    json_context c;
+    json_context_init(&c, json, len);
+    ret = json_parse_root(&c, v);
+    JSON_FREE(c.alloc, c.stack);
+    return ret;
+}
+
+static int json_whitespace_dense(const char* json, size_t len); // Forward declare
+static int json_parse_structural(json_value* v, const char* json, size_t len); // Forward declare
+
+int json_parse(json_value* v, const char* json) {
+    assert(v != NULL);
+    return json_parse_n(v, json, strlen(json));
+}
+
+int json_parse_n(json_value* v, const char* json, size_t len) {
+    assert(v != NULL && (json != NULL || len == 0));
+    // Pretty-printed text is mostly indentation, which the structural index
+    // steps over without looking at it. On compact text it only adds work.
+    if (len >= JSON_STRUCTURAL_MIN_SIZE && json_whitespace_dense(json, len))
+        return json_parse_structural(v, json, len);
+    return json_parse_descent(v, json, len);
+}
+
+#if !defined(_WIN32)
+int json_parse_file(json_value* v, const char* path) {
+    assert(v != NULL && path != NULL);
+
+    struct stat st;
+    void* map;
+    int fd, ret;
+    json_init(v);
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return JSON_PARSE_IO_ERROR;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return JSON_PARSE_IO_ERROR;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return json_parse_n(v, NULL, 0);
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return JSON_PARSE_IO_ERROR;
+    // The parser reads front to back, ask for aggressive read-ahead
+    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    ret = json_parse_n(v, (const char*)map, (size_t)st.st_size);
+    munmap(map, (size_t)st.st_size);
+    return ret;
+}
+#else
+// No mmap(), read the file in one go instead.
+int json_parse_file(json_value* v, const char* path) {
+    assert(v != NULL && path != NULL);
+
+    FILE* f;
+    char* buf;
+    long size;
+    int ret;
+    json_init(v);
+    if ((f = fopen(path, "rb")) == NULL)
+        return JSON_PARSE_IO_ERROR;
+    if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return JSON_PARSE_IO_ERROR;
+    }
+    buf = (char*)JSON_MALLOC(json_heap, size > 0 ? (size_t)size : 1);
+    if (fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        JSON_FREE(json_heap, buf);
+        fclose(f);
+        return JSON_PARSE_IO_ERROR;
+    }
+    fclose(f);
+    ret = json_parse_n(v, buf, (size_t)size);
+    JSON_FREE(json_heap, buf);
+    return ret;
+}
+#endif
+
+int json_parse_insitu(json_value* v, char* buf) {
+    assert(v != NULL && buf != NULL);
+
+    int ret;
+    json_context c;
+    json_context_init(&c, buf, strlen(buf));
+    c.insitu = 1;
+    ret = json_parse_root(&c, v);
+    JSON_FREE(c.alloc, c.stack);
+    return ret;
+}
+
+int json_parse_interned(json_value* v, const char* json, json_symbols* symbols) {
+    assert(v != NULL && json != NULL && symbols != NULL);
+
+    int ret;
+    json_context c;
+    json_context_init(&c, json, strlen(json));
+    c.symbols = symbols;
+    ret = json_parse_root(&c, v);
+    JSON_FREE(c.alloc, c.stack);
+    return ret;
+}
+
+json_symbols* json_symbols_create(void) {
+    json_symbols* y = (json_symbols*)JSON_MALLOC(json_heap, sizeof(json_symbols));
+    json_symbols_init(y, json_heap);
+    return y;
+}
+
+void json_symbols_destroy(json_symbols* y) {
+    if (y == NULL)
+        return;
+    json_symbols_release(y);
+    JSON_FREE(json_heap, y);
+}
+
+size_t json_symbols_size(const json_symbols* y) {
+    assert(y != NULL);
+    return y->count;
+}
+
+const char* json_symbols_intern(json_symbols* y, const char* s, size_t len) {
+    assert(y != NULL && (s != NULL || len == 0));
+    return json_symbols_find_or_add(y, s, len);
+}
+
+// Structural Begin
+// Two-stage engine. Stage 1 classifies the input 64 bytes at a time into
+// bitmasks and records the offset of every structural character, opening
+// quote and scalar start outside strings. Stage 2 walks those offsets and
+// reuses the scalar decoders, so whitespace is never looked at again.
+// That only pays when there is a lot of whitespace, json_parse_n() checks.
+// On any error, or when the index and the tokenizer disagree, the input is
+// parsed again by the descent engine, which reports the exact error.
+typedef struct {
+    uint32_t* pos;  // Offsets of the tokens in input order
+    size_t n, i;    // Token count, next token
+    size_t cap;     // Room in pos
+    const char* base;
+} json_index;
+
+// Bitmasks of one 64-byte block, bit i is byte i.
+typedef struct {
+    uint64_t quote, backslash, op, ws;
+} json_block;
+
+static void json_classify(const char* p, json_block* b) {
+#if defined(JSON_AVX2)
+    const __m256i quote = _mm256_set1_epi8('\"'), backslash = _mm256_set1_epi8('\\');
+    const __m256i lower = _mm256_set1_epi8(0x20), open = _mm256_set1_epi8('{'), close = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':'), comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t');
+    const __m256i lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+    int i;
+    b->quote = b->backslash = b->op = b->ws = 0;
+    for (i = 0; i < 64; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i y = _mm256_or_si256(x, lower); // '[' -> '{', ']' -> '}'
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(y, open), _mm256_cmpeq_epi8(y, close)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, colon), _mm256_cmpeq_epi8(x, comma)));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, space), _mm256_cmpeq_epi8(x, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, lf), _mm256_cmpeq_epi8(x, cr)));
+        b->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, quote)) << i;
+        b->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, backslash)) << i;
+        b->op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << i;
+        b->ws |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ws) << i;
+    }
+#elif defined(JSON_SSE2)
+    const __m128i quote = _mm_set1_epi8('\"'), backslash = _mm_set1_epi8('\\');
+    const __m128i lower = _mm_set1_epi8(0x20), open = _mm_set1_epi8('{'), close = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':'), comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t');
+    const __m128i lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+    int i;
+    b->quote = b->backslash = b->op = b->ws = 0;
+    for (i = 0; i < 64; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i y = _mm_or_si128(x, lower); // '[' -> '{', ']' -> '}'
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(y, open), _mm_cmpeq_epi8(y, close)),
+            _mm_or_si128(_mm_cmpeq_epi8(x, colon), _mm_cmpeq_epi8(x, comma)));
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(x, space), _mm_cmpeq_epi8(x, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(x, lf), _mm_cmpeq_epi8(x, cr)));
+        b->quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, quote)) << i;
+        b->backslash |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, backslash)) << i;
+        b->op |= (uint64_t)(unsigned)_mm_movemask_epi8(op) << i;
+        b->ws |= (uint64_t)(unsigned)_mm_movemask_epi8(ws) << i;
+    }
+#else
+    int i;
+    b->quote = b->backslash = b->op = b->ws = 0;
+    for (i = 0; i < 64; i++) {
+        uint64_t bit = (uint64_t)1 << i;
+        switch (p[i]) {
+            case '\"':  b->quote |= bit; break;
+            case '\\': b->backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                b->op |= bit; break;
+            case ' ': case '\t': case '\n': case '\r':
+                b->ws |= bit; break;
+        }
+    }
+#endif
+}
+
+// Bit i of the result is the XOR of bits 0..i of x.
+static uint64_t json_prefix_xor(uint64_t x) {
+#if defined(JSON_PCLMUL)
+    __m128i r = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)x), _mm_set1_epi8((char)0xFF), 0);
+    return (uint64_t)_mm_cvtsi128_si64(r);
+#else
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+#endif
+}
+
+// Bits of the characters preceded by an odd run of backslashes, after
+// simdjson. prev carries an escape across the block boundary.
+static uint64_t json_escaped(uint64_t backslash, uint64_t* prev) {
+    const uint64_t even = 0x5555555555555555ULL;
+    uint64_t follows, odd_starts, even_ends, carry;
+    backslash &= ~*prev;
+    follows = (backslash << 1) | *prev;
+    odd_starts = backslash & ~even & ~follows;
+    even_ends = odd_starts + backslash;
+    carry = even_ends < backslash;
+    *prev = carry;
+    return (even ^ (even_ends << 1)) & follows;
+}
+
+// Whether whitespace makes up JSON_STRUCTURAL_MIN_WHITESPACE percent of
+// the first 4 KiB. Whitespace inside strings counts too, it is a sample.
+static int json_whitespace_dense(const char* json, size_t len) {
+    size_t off, ws = 0, n = len < 4096 ? len & ~(size_t)63 : 4096;
+    for (off = 0; off < n; off += 64) {
+        json_block b;
+        json_classify(json + off, &b);
+        ws += JSON_POPCOUNT64(b.ws);
+    }
+    return ws * 100 >= (size_t)JSON_STRUCTURAL_MIN_WHITESPACE * n;
+}
+
+// Stage 1, fills x->pos. Returns 0 when the input is too large to index.
+static int json_index_build(json_index* x, const char* json, size_t len) {
+    uint64_t prev_escaped = 0, prev_in_string = 0, prev_scalar = 0;
+    size_t off;
+    if (len > UINT32_MAX)
+        return 0;
+    x->base = json;
+    x->n = x->i = 0;
+    // Sized for sparse text, which is when this engine runs, and grown on demand
+    x->cap = len / 64 + 64;
+    x->pos = (uint32_t*)JSON_MALLOC(json_heap, x->cap * sizeof(uint32_t));
+    for (off = 0; off < len; off += 64) {
+        json_block b;
+        uint64_t quote, in_string, scalar, tokens;
+        // A block adds at most 64 tokens
+        if (x->n + 64 > x->cap) {
+            while (x->n + 64 > x->cap)
+                x->cap += x->cap >> 1;
+            x->pos = (uint32_t*)JSON_REALLOC(json_heap, x->pos, x->cap * sizeof(uint32_t));
+        }
+        if (len - off >= 64)
+            json_classify(json + off, &b);
+        else {
+            // Pad the tail with spaces, they never start a token
+            char tail[64];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, json + off, len - off);
+            json_classify(tail, &b);
+        }
+        quote = b.quote & ~json_escaped(b.backslash, &prev_escaped);
+        // Includes the opening quote, excludes the closing one
+        in_string = json_prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = (uint64_t)0 - (in_string >> 63);
+        scalar = ~(b.op | b.ws | quote | in_string);
+        tokens = (b.op & ~in_string) | (quote & in_string) | (scalar & ~((scalar << 1) | prev_scalar));
+        prev_scalar = scalar >> 63;
+        while (tokens != 0) {
+            x->pos[x->n++] = (uint32_t)(off + JSON_CTZ64(tokens));
+            tokens &= tokens - 1;
+        }
+    }
+    return 1;
+}
+
+#define JSON_INDEX_PEEK(x) ((x)->i < (x)->n ? (x)->base[(x)->pos[(x)->i]] : '\0')
+
+// After a scalar or string, only whitespace may precede the next token.
+static int json_index_gap(json_context* c, json_index* x) {
+    const char* next = x->i < x->n ? x->base + x->pos[x->i] : c->end;
+    const char* p;
+    for (p = c->json; p < next; p++)
+        if (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+            return JSON_PARSE_INVALID_VALUE;
+    return p == next ? JSON_PARSE_OK : JSON_PARSE_INVALID_VALUE;
+}
+
+static int json_index_value(json_context* c, json_index* x, json_value* v); // Forward declare
+
+static int json_index_array(json_context* c, json_index* x, json_value* v) {
+    size_t i, size = 0;
+    int ret;
+    if (JSON_INDEX_PEEK(x) == ']') {
+        x->i++;
+        v->type = JSON_ARRAY;
+        v->flags = JSON_CONTEXT_FLAGS(c) & JSON_FLAG_BORROWED;
+        v->u.a.size = 0;
+        v->u.a.capacity = 0;
+        v->u.a.e = (json_value*)json_context_items(c, v, 0);
+        return JSON_PARSE_OK;
+    }
+    while (1) {
+        json_value e;
+        json_init(&e);
+        if ((ret = json_index_value(c, x, &e)) != JSON_PARSE_OK)
+            break;
+        memcpy(json_context_push(c, sizeof(json_value)), &e, sizeof(json_value));
+        size++;
+        if (JSON_INDEX_PEEK(x) == ',')
+            x->i++;
+        else if (JSON_INDEX_PEEK(x) == ']') {
+            x->i++;
+            v->type = JSON_ARRAY;
+            v->flags = JSON_CONTEXT_FLAGS(c) & JSON_FLAG_BORROWED;
+            v->u.a.size = size;
+            v->u.a.capacity = size;
+            size *= sizeof(json_value);
+            memcpy(v->u.a.e = (json_value*)json_context_items(c, v, size), json_context_pop(c, size), size);
+            return JSON_PARSE_OK;
+        }
+        else {
+            ret = JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            break;
+        }
+    }
+    for (i = 0; i < size; i++)
+        json_free((json_value*)json_context_pop(c, sizeof(json_value)));
+    return ret;
+}
+
+static int json_index_object(json_context* c, json_index* x, json_value* v) {
+    size_t i, size = 0;
+    json_member m;
+    int ret;
+    if (JSON_INDEX_PEEK(x) == '}') {
+        x->i++;
+        v->type = JSON_OBJECT;
+        v->flags = JSON_CONTEXT_FLAGS(c);
+        v->u.o.m = (json_member*)json_context_items(c, v, 0);
+        v->u.o.size = 0;
+        v->u.o.capacity = 0;
+        v->u.o.index = NULL;
+        return JSON_PARSE_OK;
+    }
+    m.k = NULL;
+    while (1) {
+        char* str;
+        json_init(&m.v);
+        if (JSON_INDEX_PEEK(x) != '"') {
+            ret = JSON_PARSE_MISS_KEY;
+            break;
+        }
+        c->json = x->base + x->pos[x->i++];
+        if ((ret = json_parse_string_raw(c, &str, &m.klen)) != JSON_PARSE_OK)
+            break;
+        m.k = json_context_key(c, str, m.klen);
+        if ((ret = json_index_gap(c, x)) != JSON_PARSE_OK)
+            break;
+        if (JSON_INDEX_PEEK(x) != ':') {
+            ret = JSON_PARSE_MISS_COLON;
+            break;
+        }
+        x->i++;
+        if ((ret = json_index_value(c, x, &m.v)) != JSON_PARSE_OK)
+            break;
+        memcpy(json_context_push(c, sizeof(json_member)), &m, sizeof(json_member));
+        size++;
+        m.k = NULL; // ownership is transferred to member on stack
+        if (JSON_INDEX_PEEK(x) == ',')
+            x->i++;
+        else if (JSON_INDEX_PEEK(x) == '}') {
+            size_t s = sizeof(json_member) * size;
+            x->i++;
+            v->type = JSON_OBJECT;
+            v->flags = JSON_CONTEXT_FLAGS(c);
+            v->u.o.size = size;
+            v->u.o.capacity = size;
+            memcpy(v->u.o.m = (json_member*)json_context_items(c, v, s), json_context_pop(c, s), s);
+            v->u.o.index = json_context_index(c, v);
+            return JSON_PARSE_OK;
+        }
+        else {
+            ret = JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        }
+    }
+    if (!(JSON_CONTEXT_FLAGS(c) & JSON_FLAG_KEYS_BORROWED))
+        JSON_FREE(json_heap, m.k);
+    for (i = 0; i < size; i++) {
+        json_member* m = (json_member*)json_context_pop(c, sizeof(json_member));
+        if (!(JSON_CONTEXT_FLAGS(c) & JSON_FLAG_KEYS_BORROWED))
+            JSON_FREE(json_heap, m->k);
+        json_free(&m->v);
+    }
+    v->type = JSON_NULL;
+    return ret;
+}
+
+// Stage 2
+static int json_index_value(json_context* c, json_index* x, json_value* v) {
+    int ret;
+    if (x->i == x->n)
+        return JSON_PARSE_EXPECT_VALUE;
+    c->json = x->base + x->pos[x->i++];
+    switch (*c->json) {
+        case '[': return json_index_array(c, x, v);
+        case '{': return json_index_object(c, x, v);
+        case ']': case '}': case ':': case ',':
+            return JSON_PARSE_INVALID_VALUE;
+        default:
+            if ((ret = json_parse_value(c, v)) == JSON_PARSE_OK && (ret = json_index_gap(c, x)) != JSON_PARSE_OK)
+                json_free(v);
+            return ret;
+    }
+}
+
+static int json_parse_structural(json_value* v, const char* json, size_t len) {
+    int ret;
+    json_context c;
+    json_index x;
+    json_init(v);
+    if (!json_index_build(&x, json, len))
+        return json_parse_descent(v, json, len);
+    json_context_init(&c, json, len);
+    if ((ret = json_index_value(&c, &x, v)) == JSON_PARSE_OK && x.i != x.n) {
+        json_free(v);
+        ret = JSON_PARSE_ROOT_NOT_SINGULAR;
+    }
+    assert(c.top == 0);
+    JSON_FREE(c.alloc, c.stack);
+    JSON_FREE(json_heap, x.pos);
+    if (ret != JSON_PARSE_OK)
+        return json_parse_descent(v, json, len);
+    return ret;
+}
+// Structural End
+
+// SAX Begin
+// Event-driven parse over the same tokenizer, no json_value tree is built.
+#define JSON_SAX_EMIT(h, cb, args) \
+    do { if ((h)->cb != NULL && (h)->cb args != 0) return JSON_PARSE_ABORTED; } while(0)
+
+static int json_sax_value(json_context* c, const json_handler* h, void* user); // Forward declare
+
+static int json_sax_array(json_context* c, const json_handler* h, void* user) {
+    size_t size = 0;
+    int ret;
+    EXPECT(c, '[');
+    JSON_SAX_EMIT(h, on_start_array, (user));
+    json_parse_whitespace(c);
+    if (PEEK(c) == ']') {
+        c->json++;
+        JSON_SAX_EMIT(h, on_end_array, (user, 0));
+        return JSON_PARSE_OK;
+    }
+    while (1) {
+        if ((ret = json_sax_value(c, h, user)) != JSON_PARSE_OK)
+            return ret;
+        size++;
+        json_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            json_parse_whitespace(c);
+        }
+        else if (PEEK(c) == ']') {
+            c->json++;
+            JSON_SAX_EMIT(h, on_end_array, (user, size));
+            return JSON_PARSE_OK;
+        }
+        else
+            return JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+    }
+}
+
+static int json_sax_object(json_context* c, const json_handler* h, void* user) {
+    size_t size = 0;
+    int ret;
+    EXPECT(c, '{');
+    JSON_SAX_EMIT(h, on_start_object, (user));
+    json_parse_whitespace(c);
+    if (PEEK(c) == '}') {
+        c->json++;
+        JSON_SAX_EMIT(h, on_end_object, (user, 0));
+        return JSON_PARSE_OK;
+    }
+    while (1) {
+        char* str;
+        size_t len;
+
+        // parse key
+        if (PEEK(c) != '"')
+            return JSON_PARSE_MISS_KEY;
+        if ((ret = json_parse_string_raw(c, &str, &len)) != JSON_PARSE_OK)
+            return ret;
+        if (len > 0)
+            str[len] = '\0'; // The stack always has room for it
+        JSON_SAX_EMIT(h, on_key, (user, len > 0 ? str : "", len));
+
+        // parse ws colon ws
+        json_parse_whitespace(c);
+        if (PEEK(c) != ':')
+            return JSON_PARSE_MISS_COLON;
+        c->json++;
+        json_parse_whitespace(c);
+
+        // parse value
+        if ((ret = json_sax_value(c, h, user)) != JSON_PARSE_OK)
+            return ret;
+        size++;
+
+        // parse comma or right-curly-brace
+        json_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            json_parse_whitespace(c);
+        }
+        else if (PEEK(c) == '}') {
+            c->json++;
+            JSON_SAX_EMIT(h, on_end_object, (user, size));
+            return JSON_PARSE_OK;
+        }
+        else
+            return JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    }
+}
+
+static int json_sax_value(json_context* c, const json_handler* h, void* user) {
+    json_value v;
+    char* str;
+    size_t len;
+    int ret;
+    json_init(&v);
+    switch (PEEK(c)) {
+        case 'n':
+            if ((ret = json_parse_literal(c, &v, "null", JSON_NULL)) == JSON_PARSE_OK)
+                JSON_SAX_EMIT(h, on_null, (user));
+            return ret;
+        case 't':
+            if ((ret = json_parse_literal(c, &v, "true", JSON_TRUE)) == JSON_PARSE_OK)
+                JSON_SAX_EMIT(h, on_bool, (user, 1));
+            return ret;
+        case 'f':
+            if ((ret = json_parse_literal(c, &v, "false", JSON_FALSE)) == JSON_PARSE_OK)
+                JSON_SAX_EMIT(h, on_bool, (user, 0));
+            return ret;
+        case '\"':
+            if ((ret = json_parse_string_raw(c, &str, &len)) == JSON_PARSE_OK) {
+                if (len > 0)
+                    str[len] = '\0';
+                JSON_SAX_EMIT(h, on_string, (user, len > 0 ? str : "", len));
+            }
+            return ret;
+        case '\0': return JSON_PARSE_EXPECT_VALUE;
+        case '[':  return json_sax_array(c, h, user);
+        case '{':  return json_sax_object(c, h, user);
+        default:
+            if ((ret = json_parse_number(c, &v)) == JSON_PARSE_OK)
+                JSON_SAX_EMIT(h, on_number, (user, &v));
+            return ret;
+    }
+}
+
+int json_parse_sax(const char* json, const json_handler* h, void* user) {
+    assert(json != NULL);
+    return json_parse_sax_n(json, strlen(json), h, user);
+}
+
+int json_parse_sax_n(const char* json, size_t len, const json_handler* h, void* user) {
+    assert((json != NULL || len == 0) && h != NULL);
+
+    int ret;
+    json_context c;
+    json_context_init(&c, json, len);
+    json_parse_whitespace(&c);
+    if ((ret = json_sax_value(&c, h, user)) == JSON_PARSE_OK) {
+        json_parse_whitespace(&c);
+        if (c.json != c.end)
+            ret = JSON_PARSE_ROOT_NOT_SINGULAR;
+    }
+    JSON_FREE(c.alloc, c.stack);
+    return ret;
+}
+// SAX End
+
+// Incremental Begin
+// Push parser. Nesting is kept in explicit frames and values wait on the
+// context stack exactly as in json_parse_array() / json_parse_object(), so
+// parsing can stop at any byte. Only a token that straddles two chunks is
+// copied aside; complete tokens are decoded by the regular scanners.
+enum {
+    JSON_PARSER_VALUE,        // Expect a value
+    JSON_PARSER_ARRAY_FIRST,  // After '[', expect a value or ']'
+    JSON_PARSER_OBJECT_FIRST, // After '{', expect a key or '}'
+    JSON_PARSER_KEY,          // After ',' in an object
+    JSON_PARSER_COLON,        // After a key
+    JSON_PARSER_COMMA,        // After a value inside a container
+    JSON_PARSER_DONE          // Root value complete
+};
+
+enum { JSON_TOKEN_NONE, JSON_TOKEN_STRING, JSON_TOKEN_NUMBER, JSON_TOKEN_LITERAL };
+
+// Number grammar as a DFA, so that the end of a number is known exactly.
+enum {
+    JSON_NUM_MINUS, JSON_NUM_ZERO, JSON_NUM_INT, JSON_NUM_DOT, JSON_NUM_FRAC,
+    JSON_NUM_E, JSON_NUM_ESIGN, JSON_NUM_EXP, JSON_NUM_END
+};
+
+#define JSON_NUM_ACCEPTS(s) \
+    ((s) == JSON_NUM_ZERO || (s) == JSON_NUM_INT || (s) == JSON_NUM_FRAC || (s) == JSON_NUM_EXP)
+
+typedef struct {
+    json_type type; // JSON_ARRAY or JSON_OBJECT
+    size_t size;    // Elements or members pushed on the context stack
+} json_parser_frame;
+
+struct json_parser {
+    json_context c;            // Pending values and string scratch
+    json_value root;
+    json_parser_frame* frames;
+    size_t depth, frame_cap;
+    int state;
+    int error;                 // Sticky until json_parser_finish()
+    // Token straddling chunks
+    char* tok;
+    size_t tok_len, tok_cap;
+    int tok_type, tok_key;
+    int tok_state;             // Escape pending, DFA state or literal bytes matched
+    const char* tok_literal;
+    // Policy and one-shot parse
+    size_t max_size, fed;      // Input bytes allowed and fed so far
+    int use_arena;
+    int own_alloc;             // Created with an allocator, the arena is always used
+    json_arena arena;          // Storage of the results when use_arena is set
+};
+
+static void json_parser_clear(json_parser* p) {
+    // Pop and free every pending element and member, innermost first
+    while (p->depth > 0) {
+        json_parser_frame* f = &p->frames[--p->depth];
+        size_t i;
+        for (i = 0; i < f->size; i++) {
+            if (f->type == JSON_ARRAY)
+                json_free((json_value*)json_context_pop(&p->c, sizeof(json_value)));
+            else {
+                json_member* m = (json_member*)json_context_pop(&p->c, sizeof(json_member));
+                if (p->c.arena == NULL)
+                    JSON_FREE(json_heap, m->k);
+                json_free(&m->v);
+            }
+        }
+    }
+    assert(p->c.top == 0);
+    json_free(&p->root);
+    p->state = JSON_PARSER_VALUE;
+    p->error = JSON_PARSE_OK;
+    p->tok_type = JSON_TOKEN_NONE;
+    p->tok_len = 0;
+    p->fed = 0;
+}
+
+static int json_parser_fail(json_parser* p, int error) {
+    json_parser_clear(p);
+    return p->error = error;
+}
+
+static void json_parser_append(json_parser* p, const char* s, size_t len) {
+    if (p->tok_len + len >= p->tok_cap) {
+        if (p->tok_cap == 0)
+            p->tok_cap = JSON_PARSE_STACK_INIT_SIZE;
+        while (p->tok_len + len >= p->tok_cap)
+            p->tok_cap += p->tok_cap >> 1;
+        p->tok = (char*)JSON_REALLOC(p->c.alloc, p->tok, p->tok_cap);
+    }
+    memcpy(p->tok + p->tok_len, s, len);
+    p->tok[p->tok_len += len] = '\0';
+}
+
+// Store a completed value in its slot and move to the next state.
+static void json_parser_put(json_parser* p, const json_value* v) {
+    json_parser_frame* f;
+    if (p->depth == 0) {
+        p->root = *v;
+        p->state = JSON_PARSER_DONE;
+        return;
+    }
+    f = &p->frames[p->depth - 1];
+    if (f->type == JSON_ARRAY) {
+        memcpy(json_context_push(&p->c, sizeof(json_value)), v, sizeof(json_value));
+        f->size++;
+    }
+    else // The member was pushed with its key
+        ((json_member*)(p->c.stack + p->c.top - sizeof(json_member)))->v = *v;
+    p->state = JSON_PARSER_COMMA;
+}
+
+static void json_parser_open(json_parser* p, json_type type) {
+    if (p->depth == p->frame_cap) {
+        p->frame_cap = p->frame_cap == 0 ? 16 : p->frame_cap + (p->frame_cap >> 1);
+        p->frames = (json_parser_frame*)JSON_REALLOC(p->c.alloc, p->frames, p->frame_cap * sizeof(json_parser_frame));
+    }
+    p->frames[p->depth].type = type;
+    p->frames[p->depth].size = 0;
+    p->depth++;
+    p->state = type == JSON_ARRAY ? JSON_PARSER_ARRAY_FIRST : JSON_PARSER_OBJECT_FIRST;
+}
+
+static void json_parser_close(json_parser* p) {
+    json_parser_frame f = p->frames[--p->depth];
+    size_t s;
+    json_value v;
+    json_init(&v);
+    v.type = f.type;
+    if (f.type == JSON_ARRAY) {
+        v.flags = JSON_CONTEXT_FLAGS(&p->c) & JSON_FLAG_BORROWED;
+        v.u.a.size = f.size;
+        v.u.a.capacity = f.size;
+        s = f.size * sizeof(json_value);
+        v.u.a.e = (json_value*)json_context_items(&p->c, &v, s);
+        if (s > 0)
+            memcpy(v.u.a.e, json_context_pop(&p->c, s), s);
+    }
+    else {
+        v.flags = JSON_CONTEXT_FLAGS(&p->c);
+        v.u.o.size = f.size;
+        v.u.o.capacity = f.size;
+        s = f.size * sizeof(json_member);
+        v.u.o.m = (json_member*)json_context_items(&p->c, &v, s);
+        if (s > 0)
+            memcpy(v.u.o.m, json_context_pop(&p->c, s), s);
+        v.u.o.index = json_context_index(&p->c, &v);
+    }
+    json_parser_put(p, &v);
+}
+
+// Bind the storage of the document about to start, the arena is rewound.
+static void json_parser_begin(json_parser* p) {
+    p->c.arena = NULL;
+    if (p->use_arena) {
+        json_arena_reset(&p->arena);
+        p->c.arena = &p->arena;
+    }
+}
+
+// Scan the current token from s. Returns the position right after it, or
+// NULL when end came first and the token may continue in the next chunk.
+static const char* json_parser_scan(json_parser* p, const char* s, const char* end) {
+    switch (p->tok_type) {
+        case JSON_TOKEN_STRING:
+            while (1) {
+                if (p->tok_state) {
+                    // Escaped character, the decoder takes care of it
+                    if (s == end)
+                        return NULL;
+                    s++;
+                    p->tok_state = 0;
+                }
+                s = json_scan_string(s, end);
+                if (s == end)
+                    return NULL;
+                switch (*s++) {
+                    case '\"': return s;
+                    case '\\': p->tok_state = 1; break;
+                    case '\0': p->error = JSON_PARSE_MISS_QUOTATION_MARK; return s;
+                    default: break;
+                }
+            }
+        case JSON_TOKEN_NUMBER:
+            for (; s != end; s++) {
+                int ch = *s, st = p->tok_state;
+                switch (st) {
+                    case JSON_NUM_MINUS: st = ch == '0' ? JSON_NUM_ZERO : ISDIGIT1TO9(ch) ? JSON_NUM_INT : JSON_NUM_END; break;
+                    case JSON_NUM_ZERO:  st = ch == '.' ? JSON_NUM_DOT : ch == 'e' || ch == 'E' ? JSON_NUM_E : JSON_NUM_END; break;
+                    case JSON_NUM_INT:   st = ISDIGIT(ch) ? JSON_NUM_INT : ch == '.' ? JSON_NUM_DOT : ch == 'e' || ch == 'E' ? JSON_NUM_E : JSON_NUM_END; break;
+                    case JSON_NUM_DOT:   st = ISDIGIT(ch) ? JSON_NUM_FRAC : JSON_NUM_END; break;
+                    case JSON_NUM_FRAC:  st = ISDIGIT(ch) ? JSON_NUM_FRAC : ch == 'e' || ch == 'E' ? JSON_NUM_E : JSON_NUM_END; break;
+                    case JSON_NUM_E:     st = ISDIGIT(ch) ? JSON_NUM_EXP : ch == '+' || ch == '-' ? JSON_NUM_ESIGN : JSON_NUM_END; break;
+                    case JSON_NUM_ESIGN: st = ISDIGIT(ch) ? JSON_NUM_EXP : JSON_NUM_END; break;
+                    default:             st = ISDIGIT(ch) ? JSON_NUM_EXP : JSON_NUM_END; break;
+                }
+                if (st == JSON_NUM_END) {
+                    if (!JSON_NUM_ACCEPTS(p->tok_state))
+                        p->error = JSON_PARSE_INVALID_VALUE;
+                    return s;
+                }
+                p->tok_state = st;
+            }
+            return NULL;
+        default:
+            for (; s != end; s++) {
+                if (p->tok_literal[p->tok_state] == '\0')
+                    return s;
+                if (*s != p->tok_literal[p->tok_state++]) {
+                    p->error = JSON_PARSE_INVALID_VALUE;
+                    return s;
+                }
+            }
+            return p->tok_literal[p->tok_state] == '\0' ? s : NULL;
+    }
+}
+
+// Decode a complete token of n bytes at t with the regular scanners.
+static int json_parser_token(json_parser* p, const char* t, size_t n) {
+    json_context* c = &p->c;
+    json_value v;
+    char* str;
+    size_t len;
+    int ret;
+    json_init(&v);
+    c->json = t;
+    c->end = t + n;
+    switch (p->tok_type) {
+        case JSON_TOKEN_STRING:
+            if ((ret = json_parse_string_raw(c, &str, &len)) != JSON_PARSE_OK)
+                return ret;
+            if (p->tok_key) {
+                json_member* m;
+                char* k = json_context_key(c, str, len);
+                m = (json_member*)json_context_push(c, sizeof(json_member));
+                m->k = k;
+                m->klen = len;
+                json_init(&m->v);
+                p->frames[p->depth - 1].size++;
+                p->state = JSON_PARSER_COLON;
+                return JSON_PARSE_OK;
+            }
+            json_context_set_string(c, &v, str, len);
+            break;
+        case JSON_TOKEN_NUMBER:
+            if ((ret = json_parse_number(c, &v)) != JSON_PARSE_OK)
+                return ret;
+            break;
+        default:
+            if ((ret = json_parse_literal(c, &v, p->tok_literal,
+                    p->tok_literal[0] == 'n' ? JSON_NULL : p->tok_literal[0] == 't' ? JSON_TRUE : JSON_FALSE)) != JSON_PARSE_OK)
+                return ret;
+            break;
+    }
+    assert(c->json == t + n);
+    json_parser_put(p, &v);
+    return JSON_PARSE_OK;
+}
+
+json_parser* json_parser_create(void) {
+    return json_parser_create_with(NULL);
+}
+
+json_parser* json_parser_create_with(const json_allocator* a) {
+    json_parser* p;
+    int own = a != NULL;
+    if (a == NULL)
+        a = json_heap;
+    p = (json_parser*)JSON_MALLOC(a, sizeof(json_parser));
+    json_context_init(&p->c, NULL, 0);
+    p->c.alloc = a;
+    json_init(&p->root);
+    p->frames = NULL;
+    p->depth = p->frame_cap = 0;
+    p->tok = NULL;
+    p->tok_cap = 0;
+    p->max_size = (size_t)-1;
+    // Trees would come from the default allocator otherwise
+    p->use_arena = p->own_alloc = own;
+    json_arena_init(&p->arena, a);
+    json_parser_clear(p);
+    return p;
+}
+
+void json_parser_destroy(json_parser* p) {
+    if (p == NULL)
+        return;
+    json_parser_clear(p);
+    JSON_FREE(p->c.alloc, p->c.stack);
+    JSON_FREE(p->c.alloc, p->frames);
+    JSON_FREE(p->c.alloc, p->tok);
+    json_arena_release(&p->arena);
+    JSON_FREE(p->c.alloc, p);
+}
+
+void json_parser_set_limits(json_parser* p, size_t max_depth, size_t max_size) {
+    assert(p != NULL);
+    p->c.max_depth = max_depth != 0 ? max_depth : (size_t)-1;
+    p->max_size = max_size != 0 ? max_size : (size_t)-1;
+}
+
+void json_parser_use_arena(json_parser* p, int enable) {
+    assert(p != NULL);
+    p->use_arena = enable || p->own_alloc;
+}
+
+int json_parser_parse(json_parser* p, json_value* v, const char* json, size_t len) {
+    assert(p != NULL && v != NULL && (json != NULL || len == 0));
+
+    json_parser_clear(p);
+    if (len > p->max_size) {
+        json_init(v);
+        return JSON_PARSE_SIZE_EXCEEDED;
+    }
+    // The stack keeps the capacity it grew to, and the arena its chunks
+    p->c.json = json;
+    p->c.end = json + len;
+    json_parser_begin(p);
+    return json_parse_root(&p->c, v);
+}
+
+int json_parser_feed(json_parser* p, const char* chunk, size_t len) {
+    assert(p != NULL && (chunk != NULL || len == 0));
+
+    const char* s = chunk;
+    const char* end = chunk + len;
+    const char* q;
+    int ret;
+    if (p->error != JSON_PARSE_OK)
+        return p->error;
+    if (len > p->max_size - p->fed)
+        return json_parser_fail(p, JSON_PARSE_SIZE_EXCEEDED);
+    if (p->fed == 0)
+        json_parser_begin(p);
+    p->fed += len;
+
+    // Complete the token left over by the previous chunk
+    if (p->tok_type != JSON_TOKEN_NONE) {
+        q = json_parser_scan(p, s, end);
+        if (p->error != JSON_PARSE_OK)
+            return json_parser_fail(p, p->error);
+        json_parser_append(p, s, (q != NULL ? q : end) - s);
+        if (q == NULL)
+            return JSON_PARSE_OK;
+        if ((ret = json_parser_token(p, p->tok, p->tok_len)) != JSON_PARSE_OK)
+            return json_parser_fail(p, ret);
+        p->tok_type = JSON_TOKEN_NONE;
+        p->tok_len = 0;
+        s = q;
+    }
+
+    while (1) {
+        while (s != end && (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r'))
+            s++;
+        if (s == end)
+            return JSON_PARSE_OK;
+
+        switch (p->state) {
+            case JSON_PARSER_DONE:
+                return json_parser_fail(p, JSON_PARSE_ROOT_NOT_SINGULAR);
+            case JSON_PARSER_COLON:
+                if (*s++ != ':')
+                    return json_parser_fail(p, JSON_PARSE_MISS_COLON);
+                p->state = JSON_PARSER_VALUE;
+                continue;
+            case JSON_PARSER_COMMA:
+                if (p->frames[p->depth - 1].type == JSON_ARRAY) {
+                    if (*s == ',')
+                        p->state = JSON_PARSER_VALUE;
+                    else if (*s == ']')
+                        json_parser_close(p);
+                    else
+                        return json_parser_fail(p, JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+                }
+                else {
+                    if (*s == ',')
+                        p->state = JSON_PARSER_KEY;
+                    else if (*s == '}')
+                        json_parser_close(p);
+                    else
+                        return json_parser_fail(p, JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET);
+                }
+                s++;
+                continue;
+            case JSON_PARSER_OBJECT_FIRST:
+                if (*s == '}') {
+                    s++;
+                    json_parser_close(p);
+                    continue;
+                }
+                /* Fall through */
+            case JSON_PARSER_KEY:
+                if (*s != '\"')
+                    return json_parser_fail(p, JSON_PARSE_MISS_KEY);
+                p->tok_type = JSON_TOKEN_STRING;
+                p->tok_key = 1;
+                break;
+            case JSON_PARSER_ARRAY_FIRST:
+                if (*s == ']') {
+                    s++;
+                    json_parser_close(p);
+                    continue;
+                }
+                /* Fall through */
+            default:
+                p->tok_key = 0;
+                switch (*s) {
+                    case '[':
+                    case '{':
+                        if (p->depth == p->c.max_depth)
+                            return json_parser_fail(p, JSON_PARSE_DEPTH_EXCEEDED);
+                        json_parser_open(p, *s++ == '[' ? JSON_ARRAY : JSON_OBJECT);
+                        continue;
+                    case '\"': p->tok_type = JSON_TOKEN_STRING; break;
+                    case 'n':  p->tok_type = JSON_TOKEN_LITERAL; p->tok_literal = "null"; break;
+                    case 't':  p->tok_type = JSON_TOKEN_LITERAL; p->tok_literal = "true"; break;
+                    case 'f':  p->tok_type = JSON_TOKEN_LITERAL; p->tok_literal = "false"; break;
+                    case '\0': return json_parser_fail(p, JSON_PARSE_EXPECT_VALUE);
+                    default:
+                        if (*s != '-' && !ISDIGIT(*s))
+                            return json_parser_fail(p, JSON_PARSE_INVALID_VALUE);
+                        p->tok_type = JSON_TOKEN_NUMBER;
+                        break;
+                }
+        }
+
+        // A token starts at s
+        p->tok_state = p->tok_type == JSON_TOKEN_NUMBER ?
+            (*s == '-' ? JSON_NUM_MINUS : *s == '0' ? JSON_NUM_ZERO : JSON_NUM_INT) :
+            p->tok_type == JSON_TOKEN_LITERAL ? 1 : 0;
+        q = json_parser_scan(p, s + 1, end);
+        if (p->error != JSON_PARSE_OK)
+            return json_parser_fail(p, p->error);
+        if (q == NULL) {
+            json_parser_append(p, s, end - s);
+            return JSON_PARSE_OK;
+        }
+        if ((ret = json_parser_token(p, s, q - s)) != JSON_PARSE_OK)
+            return json_parser_fail(p, ret);
+        p->tok_type = JSON_TOKEN_NONE;
+        s = q;
+    }
+}
+
+int json_parser_finish(json_parser* p, json_value* v) {
+    assert(p != NULL && v != NULL);
+
+    int ret = p->error;
+    json_init(v);
+    // A number only ends with the input
+    if (ret == JSON_PARSE_OK && p->tok_type != JSON_TOKEN_NONE) {
+        if (p->tok_type == JSON_TOKEN_STRING)
+            ret = JSON_PARSE_MISS_QUOTATION_MARK;
+        else if (p->tok_type == JSON_TOKEN_LITERAL || !JSON_NUM_ACCEPTS(p->tok_state))
+            ret = JSON_PARSE_INVALID_VALUE;
+        else
+            ret = json_parser_token(p, p->tok, p->tok_len);
+    }
+    if (ret == JSON_PARSE_OK) {
+        switch (p->state) {
+            case JSON_PARSER_DONE:
+                *v = p->root;
+                json_init(&p->root);
+                break;
+            case JSON_PARSER_OBJECT_FIRST:
+            case JSON_PARSER_KEY:
+                ret = JSON_PARSE_MISS_KEY;
+                break;
+            case JSON_PARSER_COLON:
+                ret = JSON_PARSE_MISS_COLON;
+                break;
+            case JSON_PARSER_COMMA:
+                ret = p->frames[p->depth - 1].type == JSON_ARRAY ?
+                    JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+                break;
+            default:
+                ret = JSON_PARSE_EXPECT_VALUE;
+                break;
+        }
+    }
+    // Ready for the next document
+    json_parser_clear(p);
+    return ret;
+}
+// Incremental End
+
+// Document Begin
+json_document* json_document_create(void) {
+    return json_document_create_with(NULL);
+}
+
+json_document* json_document_create_with(const json_allocator* a) {
+    json_document* d;
+    if (a == NULL)
+        a = json_heap;
+    d = (json_document*)JSON_MALLOC(a, sizeof(json_document));
+    json_init(&d->root);
+    json_arena_init(&d->arena, a);
+    json_symbols_init(&d->symbols, a);
+    return d;
+}
+
+void json_document_destroy(json_document* d) {
+    if (d == NULL)
+        return;
+    json_arena_release(&d->arena);
+    json_symbols_release(&d->symbols);
+    JSON_FREE(d->arena.alloc, d);
+}
+
+void json_document_reset(json_document* d) {
+    assert(d != NULL);
+    json_init(&d->root);
+    json_arena_reset(&d->arena);
+    json_symbols_clear(&d->symbols);
+}
+
+int json_document_parse(json_document* d, const char* json) {
+    assert(d != NULL && json != NULL);
+
+    int ret;
+    json_context c;
+    json_document_reset(d);
+    json_context_init(&c, json, strlen(json));
+    c.alloc = d->arena.alloc;
+    c.arena = &d->arena;
+    c.symbols = &d->symbols;
+    ret = json_parse_root(&c, &d->root);
+    JSON_FREE(c.alloc, c.stack);
+    return ret;
+}
+
+json_value* json_document_root(json_document* d) {
+    assert(d != NULL);
+    return &d->root;
+}
+// Document End
+
+// Tape Begin
+// A node is the index of its first word. The high byte of a word holds the
+// json_type and, for numbers, the json_number_type above it; the low 56
+// bits hold the payload:
+//   null, false, true  [tag]
+//   number             [tag] [double, int64 or uint64 bits]
+//   string             [tag | offset in strings] [length]
+//   array, object      [tag | index of the next sibling] [size] children...
+// Object children alternate between a key string and its value.
+#define JSON_TAPE_TAG(type, ntype)  ((uint64_t)((type) | ((ntype) << 4)) << 56)
+#define JSON_TAPE_PAYLOAD_MASK      (((uint64_t)1 << 56) - 1)
+#define JSON_TAPE_TYPE(w)           ((json_type)(((w) >> 56) & 0x0F))
+#define JSON_TAPE_NUMBER_TYPE(w)    ((json_number_type)((w) >> 60))
+#define JSON_TAPE_PAYLOAD(w)        ((size_t)((w) & JSON_TAPE_PAYLOAD_MASK))
+
+struct json_tape {
+    uint64_t* words;
+    size_t count, capacity;
+    char* strings;      // Every string and key, each NUL-terminated
+    size_t slen, scapacity;
+    size_t* open;       // Containers still being filled during a parse
+    size_t depth, open_capacity;
+};
+
+static uint64_t* json_tape_push(json_tape* t, size_t n) {
+    if (t->count + n > t->capacity) {
+        if (t->capacity == 0)
+            t->capacity = JSON_PARSE_STACK_INIT_SIZE;
+        while (t->count + n > t->capacity)
+            t->capacity += t->capacity >> 1;
+        t->words = (uint64_t*)JSON_REALLOC(json_heap, t->words, t->capacity * sizeof(uint64_t));
+    }
+    t->count += n;
+    return t->words + t->count - n;
+}
+
+static int json_tape_on_scalar(json_tape* t, json_type type) {
+    *json_tape_push(t, 1) = JSON_TAPE_TAG(type, 0);
+    return 0;
+}
+
+static int json_tape_on_null(void* user) {
+    return json_tape_on_scalar((json_tape*)user, JSON_NULL);
+}
+
+static int json_tape_on_bool(void* user, int b) {
+    return json_tape_on_scalar((json_tape*)user, b ? JSON_TRUE : JSON_FALSE);
+}
+
+static int json_tape_on_number(void* user, const json_value* v) {
+    json_number_type ntype = json_get_number_type(v);
+    uint64_t* w = json_tape_push((json_tape*)user, 2);
+    w[0] = JSON_TAPE_TAG(JSON_NUMBER, ntype);
+    if (ntype == JSON_NUMBER_DOUBLE)
+        memcpy(&w[1], &v->u.n, sizeof(double));
+    else
+        w[1] = v->u.ui; // Same bits as u.i
+    return 0;
+}
+
+static int json_tape_on_string(void* user, const char* s, size_t len) {
+    json_tape* t = (json_tape*)user;
+    uint64_t* w;
+    if (t->slen + len + 1 > t->scapacity) {
+        if (t->scapacity == 0)
+            t->scapacity = JSON_PARSE_STACK_INIT_SIZE;
+        while (t->slen + len + 1 > t->scapacity)
+            t->scapacity += t->scapacity >> 1;
+        t->strings = (char*)JSON_REALLOC(json_heap, t->strings, t->scapacity);
+    }
+    memcpy(t->strings + t->slen, s, len + 1);
+    w = json_tape_push(t, 2);
+    w[0] = JSON_TAPE_TAG(JSON_STRING, 0) | t->slen;
+    w[1] = len;
+    t->slen += len + 1;
+    return 0;
+}
+
+static int json_tape_on_start(json_tape* t, json_type type) {
+    if (t->depth == t->open_capacity) {
+        t->open_capacity = t->open_capacity == 0 ? 32 : t->open_capacity * 2;
+        t->open = (size_t*)JSON_REALLOC(json_heap, t->open, t->open_capacity * sizeof(size_t));
+    }
+    t->open[t->depth++] = t->count;
+    *json_tape_push(t, 2) = JSON_TAPE_TAG(type, 0);
+    return 0;
+}
+
+static int json_tape_on_end(json_tape* t, size_t size) {
+    size_t n = t->open[--t->depth];
+    t->words[n] |= t->count;
+    t->words[n + 1] = size;
+    return 0;
+}
+
+static int json_tape_on_start_array(void* user) {
+    return json_tape_on_start((json_tape*)user, JSON_ARRAY);
+}
+
+static int json_tape_on_end_array(void* user, size_t size) {
+    return json_tape_on_end((json_tape*)user, size);
+}
+
+static int json_tape_on_start_object(void* user) {
+    return json_tape_on_start((json_tape*)user, JSON_OBJECT);
+}
+
+static int json_tape_on_end_object(void* user, size_t size) {
+    return json_tape_on_end((json_tape*)user, size);
+}
+
+json_tape* json_tape_create(void) {
+    json_tape* t = (json_tape*)JSON_MALLOC(json_heap, sizeof(json_tape));
+    memset(t, 0, sizeof(json_tape));
+    return t;
+}
+
+void json_tape_destroy(json_tape* t) {
+    if (t == NULL)
+        return;
+    JSON_FREE(json_heap, t->words);
+    JSON_FREE(json_heap, t->strings);
+    JSON_FREE(json_heap, t->open);
+    JSON_FREE(json_heap, t);
+}
+
+int json_tape_parse(json_tape* t, const char* json) {
+    static const json_handler h = {
+        json_tape_on_null, json_tape_on_bool, json_tape_on_number, json_tape_on_string,
+        json_tape_on_string, // Keys are string nodes
+        json_tape_on_start_object, json_tape_on_end_object,
+        json_tape_on_start_array, json_tape_on_end_array
+    };
+    int ret;
+    assert(t != NULL && json != NULL);
+    t->count = t->slen = t->depth = 0;
+    if ((ret = json_parse_sax(json, &h, t)) != JSON_PARSE_OK)
+        t->count = t->slen = t->depth = 0;
+    return ret;
+}
+
+size_t json_tape_root(const json_tape* t) {
+    assert(t != NULL && t->count > 0);
+    return 0;
+}
+
+size_t json_tape_next(const json_tape* t, size_t n) {
+    uint64_t w;
+    assert(t != NULL && n < t->count);
+    w = t->words[n];
+    switch (JSON_TAPE_TYPE(w)) {
+        case JSON_ARRAY:
+        case JSON_OBJECT: return JSON_TAPE_PAYLOAD(w);
+        case JSON_NUMBER:
+        case JSON_STRING: return n + 2;
+        default:          return n + 1;
+    }
+}
+
+size_t json_tape_child(const json_tape* t, size_t n) {
+    assert(t != NULL && n < t->count);
+    assert(JSON_TAPE_TYPE(t->words[n]) == JSON_ARRAY || JSON_TAPE_TYPE(t->words[n]) == JSON_OBJECT);
+    return n + 2;
+}
+
+json_type json_tape_get_type(const json_tape* t, size_t n) {
+    assert(t != NULL && n < t->count);
+    return JSON_TAPE_TYPE(t->words[n]);
+}
+
+json_number_type json_tape_get_number_type(const json_tape* t, size_t n) {
+    assert(json_tape_get_type(t, n) == JSON_NUMBER);
+    return JSON_TAPE_NUMBER_TYPE(t->words[n]);
+}
+
+double json_tape_get_number(const json_tape* t, size_t n) {
+    double d;
+    switch (json_tape_get_number_type(t, n)) {
+        case JSON_NUMBER_INT64:  return (double)(int64_t)t->words[n + 1];
+        case JSON_NUMBER_UINT64: return (double)t->words[n + 1];
+        default:
+            memcpy(&d, &t->words[n + 1], sizeof(double));
+            return d;
+    }
+}
+
+int64_t json_tape_get_int64(const json_tape* t, size_t n) {
+    assert(json_tape_get_number_type(t, n) == JSON_NUMBER_INT64 ||
+        (json_tape_get_number_type(t, n) == JSON_NUMBER_UINT64 && t->words[n + 1] <= INT64_MAX));
+    return (int64_t)t->words[n + 1];
+}
+
+uint64_t json_tape_get_uint64(const json_tape* t, size_t n) {
+    assert(json_tape_get_number_type(t, n) == JSON_NUMBER_UINT64 ||
+        (json_tape_get_number_type(t, n) == JSON_NUMBER_INT64 && (int64_t)t->words[n + 1] >= 0));
+    return t->words[n + 1];
+}
+
+int json_tape_get_boolean(const json_tape* t, size_t n) {
+    assert(json_tape_get_type(t, n) == JSON_TRUE || json_tape_get_type(t, n) == JSON_FALSE);
+    return json_tape_get_type(t, n) == JSON_TRUE;
+}
+
+const char* json_tape_get_string(const json_tape* t, size_t n) {
+    assert(json_tape_get_type(t, n) == JSON_STRING);
+    return t->strings + JSON_TAPE_PAYLOAD(t->words[n]);
+}
+
+size_t json_tape_get_string_length(const json_tape* t, size_t n) {
+    assert(json_tape_get_type(t, n) == JSON_STRING);
+    return (size_t)t->words[n + 1];
+}
+
+size_t json_tape_get_array_size(const json_tape* t, size_t n) {
+    assert(json_tape_get_type(t, n) == JSON_ARRAY);
+    return (size_t)t->words[n + 1];
+}
+
+size_t json_tape_get_array_element(const json_tape* t, size_t n, size_t index) {
+    size_t e;
+    assert(index < json_tape_get_array_size(t, n));
+    for (e = n + 2; index > 0; index--)
+        e = json_tape_next(t, e);
+    return e;
+}
+
+size_t json_tape_get_object_size(const json_tape* t, size_t n) {
+    assert(json_tape_get_type(t, n) == JSON_OBJECT);
+    return (size_t)t->words[n + 1];
+}
+
+// Key node of member index.
+static size_t json_tape_member(const json_tape* t, size_t n, size_t index) {
+    size_t k;
+    assert(index < json_tape_get_object_size(t, n));
+    for (k = n + 2; index > 0; index--)
+        k = json_tape_next(t, k + 2);
+    return k;
+}
+
+const char* json_tape_get_object_key(const json_tape* t, size_t n, size_t index) {
+    return json_tape_get_string(t, json_tape_member(t, n, index));
+}
+
+size_t json_tape_get_object_key_length(const json_tape* t, size_t n, size_t index) {
+    return json_tape_get_string_length(t, json_tape_member(t, n, index));
+}
+
+size_t json_tape_get_object_value(const json_tape* t, size_t n, size_t index) {
+    return json_tape_member(t, n, index) + 2;
+}
+// Tape End
+
+// Lazy Begin
+// On-demand access over the raw input. Values are only located by skipping:
+// strings up to their closing quote, containers by bracket matching over the
+// same 64-byte masks as the structural engine. Decoding happens in
+// json_lazy_get_value() with the regular parser.
+static const char* json_lazy_skip_string(const char* p, const char* end) {
+    for (p++; ; p++) {
+        p = json_scan_string(p, end);
+        if (p == end)
+            return NULL;
+        if (*p == '\"')
+            return p + 1;
+        if (*p == '\\' && ++p == end)
+            return NULL;
+    }
+}
+
+static const char* json_lazy_skip_container(const char* p, const char* end) {
+    uint64_t prev_escaped = 0, prev_in_string = 0;
+    size_t depth = 0;
+    for (; p < end; p += 64) {
+        json_block b;
+        uint64_t quote, in_string, op;
+        if (end - p >= 64)
+            json_classify(p, &b);
+        else {
+            char tail[64];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, p, end - p);
+            json_classify(tail, &b);
+        }
+        quote = b.quote & ~json_escaped(b.backslash, &prev_escaped);
+        in_string = json_prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = (uint64_t)0 - (in_string >> 63);
+        // Only brackets matter, ':' and ',' are checked when iterating
+        for (op = b.op & ~in_string; op != 0; op &= op - 1) {
+            const char* q = p + JSON_CTZ64(op);
+            if (*q == '[' || *q == '{')
+                depth++;
+            else if ((*q == ']' || *q == '}') && --depth == 0)
+                return q + 1;
+        }
+    }
+    return NULL;
+}
+
+// Past the value at p, NULL when it is unterminated.
+static const char* json_lazy_skip(const char* p, const char* end) {
+    switch (*p) {
+        case '\"': return json_lazy_skip_string(p, end);
+        case '[':
+        case '{':  return json_lazy_skip_container(p, end);
+        default:
+            while (p < end && *p != ',' && *p != ']' && *p != '}' && *p != ':' && *p != '\"' &&
+                *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+                p++;
+            return p;
+    }
+}
+
+static const char* json_lazy_whitespace(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    return p;
+}
+
+int json_lazy_parse(json_lazy* v, const char* json, size_t len) {
+    assert(v != NULL && (json != NULL || len == 0));
+
+    const char* end = json + len;
+    const char* p = json_lazy_whitespace(json, end);
+    const char* q;
+    v->json = p;
+    v->end = end;
+    if (p == end)
+        return JSON_PARSE_EXPECT_VALUE;
+    if ((q = json_lazy_skip(p, end)) == NULL) {
+        switch (*p) {
+            case '[': return JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            case '{': return JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            default:  return JSON_PARSE_MISS_QUOTATION_MARK;
+        }
+    }
+    if (q == p)
+        return JSON_PARSE_INVALID_VALUE;
+    if (json_lazy_whitespace(q, end) != end)
+        return JSON_PARSE_ROOT_NOT_SINGULAR;
+    return JSON_PARSE_OK;
+}
+
+json_type json_lazy_get_type(const json_lazy* v) {
+    assert(v != NULL && v->json < v->end);
+    switch (*v->json) {
+        case 'n':  return JSON_NULL;
+        case 't':  return JSON_TRUE;
+        case 'f':  return JSON_FALSE;
+        case '\"': return JSON_STRING;
+        case '[':  return JSON_ARRAY;
+        case '{':  return JSON_OBJECT;
+        default:   return JSON_NUMBER;
+    }
+}
+
+int json_lazy_get_value(const json_lazy* v, json_value* out) {
+    assert(v != NULL && out != NULL);
+
+    int ret;
+    json_context c;
+    json_init(out);
+    json_context_init(&c, v->json, v->end - v->json);
+    ret = json_parse_value(&c, out);
+    assert(c.top == 0);
+    JSON_FREE(c.alloc, c.stack);
+    return ret;
+}
+
+void json_lazy_iterate(const json_lazy* v, json_lazy_iter* it) {
+    assert(v != NULL && it != NULL);
+    assert(json_lazy_get_type(v) == JSON_ARRAY || json_lazy_get_type(v) == JSON_OBJECT);
+    it->p = v->json + 1;
+    it->end = v->end;
+    it->close = *v->json == '[' ? ']' : '}';
+    it->first = 1;
+    it->error = JSON_PARSE_OK;
+}
+
+// Stop the iteration, ret is JSON_PARSE_OK at the closing bracket.
+static int json_lazy_stop(json_lazy_iter* it, int ret) {
+    it->error = ret;
+    it->p = it->end;
+    it->first = 0;
+    it->close = '\0';
+    return 0;
+}
+
+int json_lazy_next(json_lazy_iter* it, json_lazy* key, json_lazy* value) {
+    assert(it != NULL && value != NULL);
+
+    const char* p = json_lazy_whitespace(it->p, it->end);
+    const char* q;
+    int miss = it->close == ']' ? JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    if (it->close == '\0')
+        return 0;
+    if (p == it->end)
+        return json_lazy_stop(it, miss);
+    if (*p == it->close && it->first)
+        return json_lazy_stop(it, JSON_PARSE_OK);
+    if (!it->first) {
+        if (*p == it->close)
+            return json_lazy_stop(it, JSON_PARSE_OK);
+        if (*p != ',')
+            return json_lazy_stop(it, miss);
+        p = json_lazy_whitespace(p + 1, it->end);
+    }
+    it->first = 0;
+    if (it->close == '}') {
+        if (p == it->end || *p != '\"')
+            return json_lazy_stop(it, JSON_PARSE_MISS_KEY);
+        if ((q = json_lazy_skip_string(p, it->end)) == NULL)
+            return json_lazy_stop(it, JSON_PARSE_MISS_QUOTATION_MARK);
+        if (key != NULL) {
+            key->json = p;
+            key->end = it->end;
+        }
+        p = json_lazy_whitespace(q, it->end);
+        if (p == it->end || *p != ':')
+            return json_lazy_stop(it, JSON_PARSE_MISS_COLON);
+        p = json_lazy_whitespace(p + 1, it->end);
+    }
+    if (p == it->end)
+        return json_lazy_stop(it, JSON_PARSE_EXPECT_VALUE);
+    if ((q = json_lazy_skip(p, it->end)) == NULL || q == p)
+        return json_lazy_stop(it, JSON_PARSE_INVALID_VALUE);
+    value->json = p;
+    value->end = it->end;
+    it->p = q;
+    return 1;
+}
+
+// Compare the key string at k with key, decoding it only when it has escapes.
+static int json_lazy_key_equal(const json_lazy* k, const char* key, size_t klen) {
+    const char* q = json_lazy_skip_string(k->json, k->end);
+    const char* raw = k->json + 1;
+    size_t rlen = q - 1 - raw;
+    json_context c;
+    char* str;
+    size_t len;
+    int equal;
+    if (memchr(raw, '\\', rlen) == NULL)
+        return rlen == klen && memcmp(raw, key, klen) == 0;
+    json_context_init(&c, k->json, k->end - k->json);
+    equal = json_parse_string_raw(&c, &str, &len) == JSON_PARSE_OK && len == klen && memcmp(str, key, klen) == 0;
+    JSON_FREE(c.alloc, c.stack);
+    return equal;
+}
+
+int json_lazy_find(const json_lazy* v, const char* key, size_t klen, json_lazy* value) {
+    assert(v != NULL && (key != NULL || klen == 0) && value != NULL);
+    assert(json_lazy_get_type(v) == JSON_OBJECT);
+
+    json_lazy_iter it;
+    json_lazy k;
+    json_lazy_iterate(v, &it);
+    while (json_lazy_next(&it, &k, value))
+        if (json_lazy_key_equal(&k, key, klen))
+            return 1;
+    return 0;
+}
+
+int json_lazy_index(const json_lazy* v, size_t index, json_lazy* value) {
+    assert(v != NULL && value != NULL);
+    assert(json_lazy_get_type(v) == JSON_ARRAY);
+
+    json_lazy_iter it;
+    json_lazy_iterate(v, &it);
+    while (json_lazy_next(&it, NULL, value))
+        if (index-- == 0)
+            return 1;
+    return 0;
+}
+// Lazy End
+
+// Projection Begin
+// Paths are compiled into a trie. A wildcard's subtree is merged into every
+// specific sibling, so one step only looks at the children of one node:
+// the specific match if any, else the wildcard.
+typedef struct {
+    char* key;          // Unescaped token, NULL for "*"
+    size_t klen;
+    size_t index;       // Token as an array index, (size_t)-1 when it is not one
+    size_t child, next; // First child and next sibling, 0 for none
+    int keep;           // A path ends here, the whole subtree is kept
+} json_projection_node;
+
+struct json_projection {
+    json_projection_node* nodes; // nodes[0] is the document root
+    size_t count, cap;
+};
+
+static size_t json_projection_add(json_projection* p, size_t parent, char* key, size_t klen) {
+    json_projection_node* n;
+    size_t i;
+    if (p->count == p->cap) {
+        p->cap += p->cap >> 1;
+        p->nodes = (json_projection_node*)JSON_REALLOC(json_heap, p->nodes, p->cap * sizeof(json_projection_node));
+    }
+    n = &p->nodes[p->count];
+    n->key = key;
+    n->klen = klen;
+    n->index = (size_t)-1;
+    n->child = n->next = 0;
+    n->keep = 0;
+    // Array indexes are 0 or digits without a leading zero
+    if (key != NULL && klen > 0 && klen < 20 && (key[0] != '0' || klen == 1)) {
+        n->index = 0;
+        for (i = 0; i < klen && ISDIGIT(key[i]); i++)
+            n->index = n->index * 10 + (key[i] - '0');
+        if (i < klen)
+            n->index = (size_t)-1;
+    }
+    // The root is its own parent
+    if (parent != p->count) {
+        n->next = p->nodes[parent].child;
+        p->nodes[parent].child = p->count;
+    }
+    return p->count++;
+}
+
+static size_t json_projection_find(const json_projection* p, size_t n, const char* key, size_t klen) {
+    size_t c;
+    for (c = p->nodes[n].child; c != 0; c = p->nodes[c].next) {
+        const json_projection_node* k = &p->nodes[c];
+        if (key == NULL ? k->key == NULL : k->key != NULL && k->klen == klen && memcmp(k->key, key, klen) == 0)
+            return c;
+    }
+    return 0;
+}
+
+static char* json_projection_strdup(const char* s, size_t len) {
+    char* d = (char*)JSON_MALLOC(json_heap, len + 1);
+    if (len > 0)
+        memcpy(d, s, len);
+    d[len] = '\0';
+    return d;
+}
+
+// Copy the children of from under to.
+static void json_projection_clone(json_projection* p, size_t from, size_t to) {
+    size_t c;
+    p->nodes[to].keep |= p->nodes[from].keep;
+    for (c = p->nodes[from].child; c != 0; c = p->nodes[c].next) {
+        char* key = p->nodes[c].key != NULL ? json_projection_strdup(p->nodes[c].key, p->nodes[c].klen) : NULL;
+        json_projection_clone(p, c, json_projection_add(p, to, key, p->nodes[c].klen));
+    }
+}
+
+// Insert the rest of a checked path, which is empty or starts with '/'.
+static void json_projection_insert(json_projection* p, size_t n, const char* path) {
+    const char* end;
+    const char* s;
+    char* key;
+    size_t klen, c;
+    if (p->nodes[n].keep)
+        return;
+    if (*path == '\0') {
+        p->nodes[n].keep = 1;
+        return;
+    }
+    for (end = path + 1; *end != '\0' && *end != '/'; end++)
+        ;
+    if (end - path == 2 && path[1] == '*') {
+        if ((c = json_projection_find(p, n, NULL, 0)) == 0)
+            c = json_projection_add(p, n, NULL, 0);
+        json_projection_insert(p, c, end);
+        for (c = p->nodes[n].child; c != 0; c = p->nodes[c].next)
+            if (p->nodes[c].key != NULL)
+                json_projection_insert(p, c, end);
+        return;
+    }
+    // ~1 is '/' and ~0 is '~'
+    key = (char*)JSON_MALLOC(json_heap, end - path);
+    for (s = path + 1, klen = 0; s != end; s++)
+        key[klen++] = *s == '~' ? (*++s == '1' ? '/' : '~') : *s;
+    key[klen] = '\0';
+    if ((c = json_projection_find(p, n, key, klen)) != 0)
+        JSON_FREE(json_heap, key);
+    else {
+        size_t w = json_projection_find(p, n, NULL, 0);
+        c = json_projection_add(p, n, key, klen);
+        if (w != 0)
+            json_projection_clone(p, w, c);
+    }
+    json_projection_insert(p, c, end);
+}
+
+json_projection* json_projection_create(const char* const* paths, size_t count) {
+    json_projection* p;
+    size_t i;
+    const char* s;
+    assert(paths != NULL || count == 0);
+    for (i = 0; i < count; i++) {
+        if (paths[i][0] != '\0' && paths[i][0] != '/')
+            return NULL;
+        for (s = paths[i]; *s != '\0'; s++)
+            if (*s == '~' && s[1] != '0' && s[1] != '1')
+                return NULL;
+    }
+    p = (json_projection*)JSON_MALLOC(json_heap, sizeof(json_projection));
+    p->cap = 16;
+    p->count = 0;
+    p->nodes = (json_projection_node*)JSON_MALLOC(json_heap, p->cap * sizeof(json_projection_node));
+    json_projection_add(p, 0, NULL, 0);
+    for (i = 0; i < count; i++)
+        json_projection_insert(p, 0, paths[i]);
+    return p;
+}
+
+void json_projection_destroy(json_projection* p) {
+    size_t i;
+    if (p == NULL)
+        return;
+    for (i = 0; i < p->count; i++)
+        JSON_FREE(json_heap, p->nodes[i].key);
+    JSON_FREE(json_heap, p->nodes);
+    JSON_FREE(json_heap, p);
+}
+
+// Node for a member named key, or for array element index when key is NULL.
+// 0 when nothing below n asks for it.
+static size_t json_projection_match(const json_projection* p, size_t n, const char* key, size_t klen, size_t index) {
+    size_t c, wildcard = 0;
+    for (c = p->nodes[n].child; c != 0; c = p->nodes[c].next) {
+        const json_projection_node* k = &p->nodes[c];
+        if (k->key == NULL)
+            wildcard = c;
+        else if (key != NULL ? k->klen == klen && memcmp(k->key, key, klen) == 0 : k->index == index)
+            return c;
+    }
+    return wildcard;
+}
+
+// Whether a value projected through node n is part of the result: all of a
+// kept subtree, containers on the way to one, no scalar off the paths.
+#define JSON_PROJECTION_KEPT(p, n, v) \
+    ((p)->nodes[n].keep || (v)->type == JSON_ARRAY || (v)->type == JSON_OBJECT)
+
+// Step over a value without building it. Strings and containers are only
+// checked for termination, literals and numbers are parsed, which does not
+// allocate.
+static int json_parse_skip(json_context* c) {
+    const char* q;
+    json_value v;
+    switch (PEEK(c)) {
+        case '\"':
+            if ((q = json_lazy_skip_string(c->json, c->end)) == NULL)
+                return JSON_PARSE_MISS_QUOTATION_MARK;
+            break;
+        case '[':
+            if ((q = json_lazy_skip_container(c->json, c->end)) == NULL)
+                return JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            break;
+        case '{':
+            if ((q = json_lazy_skip_container(c->json, c->end)) == NULL)
+                return JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        default:
+            json_init(&v);
+            return json_parse_value(c, &v);
+    }
+    c->json = q;
+    return JSON_PARSE_OK;
+}
+
+static int json_parse_projected_value(json_context* c, json_value* v, const json_projection* p, size_t n);
+
+static int json_parse_projected_array(json_context* c, json_value* v, const json_projection* p, size_t n) {
+    size_t size = 0, i = 0, k;
+    int ret;
+    EXPECT(c, '[');
+    json_parse_whitespace(c);
+    if (PEEK(c) == ']') {
+        c->json++;
+        v->type = JSON_ARRAY;
+        v->u.a.size = 0;
+        v->u.a.capacity = 0;
+        v->u.a.e = NULL;
+        return JSON_PARSE_OK;
+    }
+    while (1) {
+        if ((k = json_projection_match(p, n, NULL, 0, i++)) == 0)
+            ret = json_parse_skip(c);
+        else {
+            json_value e;
+            json_init(&e);
+            if ((ret = json_parse_projected_value(c, &e, p, k)) == JSON_PARSE_OK && JSON_PROJECTION_KEPT(p, k, &e)) {
+                memcpy(json_context_push(c, sizeof(json_value)), &e, sizeof(json_value));
+                size++;
+            }
+        }
+        if (ret != JSON_PARSE_OK)
+            break;
+        json_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            json_parse_whitespace(c);
+        }
+        else if (PEEK(c) == ']') {
+            c->json++;
+            v->type = JSON_ARRAY;
+            v->flags = 0;
+            v->u.a.size = size;
+            v->u.a.capacity = size;
+            v->u.a.e = NULL;
+            if (size > 0) {
+                size *= sizeof(json_value);
+                memcpy(v->u.a.e = (json_value*)json_context_alloc(c, size), json_context_pop(c, size), size);
+            }
+            return JSON_PARSE_OK;
+        }
+        else {
+            ret = JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            break;
+        }
+    }
+    while (size-- > 0)
+        json_free((json_value*)json_context_pop(c, sizeof(json_value)));
+    return ret;
+}
+
+static int json_parse_projected_object(json_context* c, json_value* v, const json_projection* p, size_t n) {
+    size_t size = 0, k;
+    json_member m;
+    int ret;
+    EXPECT(c, '{');
+    json_parse_whitespace(c);
+    if (PEEK(c) == '}') {
+        c->json++;
+        v->type = JSON_OBJECT;
+        v->flags = 0;
+        v->u.o.m = NULL;
+        v->u.o.size = 0;
+        v->u.o.capacity = 0;
+        v->u.o.index = NULL;
+        return JSON_PARSE_OK;
+    }
+    while (1) {
+        char* str;
+        if (PEEK(c) != '\"') {
+            ret = JSON_PARSE_MISS_KEY;
+            break;
+        }
+        if ((ret = json_parse_string_raw(c, &str, &m.klen)) != JSON_PARSE_OK)
+            break;
+        // The key only lives until the next push, copy it if it matches
+        k = json_projection_match(p, n, str, m.klen, 0);
+        m.k = k != 0 ? json_context_key(c, str, m.klen) : NULL;
+        json_parse_whitespace(c);
+        if (PEEK(c) != ':') {
+            ret = JSON_PARSE_MISS_COLON;
+            JSON_FREE(json_heap, m.k);
+            break;
+        }
+        c->json++;
+        json_parse_whitespace(c);
+        if (k == 0)
+            ret = json_parse_skip(c);
+        else {
+            json_init(&m.v);
+            if ((ret = json_parse_projected_value(c, &m.v, p, k)) == JSON_PARSE_OK && JSON_PROJECTION_KEPT(p, k, &m.v)) {
+                memcpy(json_context_push(c, sizeof(json_member)), &m, sizeof(json_member));
+                size++;
+            }
+            else
+                JSON_FREE(json_heap, m.k);
+        }
+        if (ret != JSON_PARSE_OK)
+            break;
+        json_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            json_parse_whitespace(c);
+        }
+        else if (PEEK(c) == '}') {
+            size_t s = sizeof(json_member) * size;
+            c->json++;
+            v->type = JSON_OBJECT;
+            v->flags = 0;
+            v->u.o.size = size;
+            v->u.o.capacity = size;
+            v->u.o.m = NULL;
+            v->u.o.index = NULL;
+            if (size > 0)
+                memcpy(v->u.o.m = (json_member*)json_context_alloc(c, s), json_context_pop(c, s), s);
+            return JSON_PARSE_OK;
+        }
+        else {
+            ret = JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        }
+    }
+    while (size-- > 0) {
+        json_member* e = (json_member*)json_context_pop(c, sizeof(json_member));
+        JSON_FREE(json_heap, e->k);
+        json_free(&e->v);
+    }
+    return ret;
+}
+
+static int json_parse_projected_value(json_context* c, json_value* v, const json_projection* p, size_t n) {
+    int ret;
+    if (p->nodes[n].keep)
+        return json_parse_value(c, v);
+    switch (PEEK(c)) {
+        case '[':
+        case '{':
+            if (c->depth == c->max_depth)
+                return JSON_PARSE_DEPTH_EXCEEDED;
+            c->depth++;
+            if (*c->json == '[')
+                ret = json_parse_projected_array(c, v, p, n);
+            else
+                ret = json_parse_projected_object(c, v, p, n);
+            c->depth--;
+            return ret;
+        default:
+            // Nothing below a scalar can match
+            return json_parse_skip(c);
+    }
+}
+
+int json_parse_projected(json_value* v, const char* json, size_t len, const json_projection* p) {
+    assert(v != NULL && (json != NULL || len == 0) && p != NULL);
+
+    int ret;
+    json_context c;
+    json_context_init(&c, json, len);
+    json_init(v);
+    json_parse_whitespace(&c);
+    if ((ret = json_parse_projected_value(&c, v, p, 0)) == JSON_PARSE_OK) {
+        json_parse_whitespace(&c);
+        if (c.json != c.end) {
+            json_free(v);
+            ret = JSON_PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    assert(c.top == 0);
+    JSON_FREE(c.alloc, c.stack);
+    return ret;
+}
+// Projection End
+
+static int json_cpu_count(void) {
+#if defined(JSON_THREADS) && defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+
+// NDJSON Begin
+// The input is cut into batches of whole lines. The worker threads are
+// started once and make two passes over the batches, taking the next one
+// from a shared counter: first they count the newlines of every batch, then,
+// after a barrier where the last one to finish turns the counts into first
+// line numbers, they parse. A worker keeps one context stack and one arena
+// for all its lines, and rewinds the arena after every callback.
+typedef struct {
+    const char* buf;
+    size_t* bounds;   // Batch i is [bounds[i], bounds[i + 1])
+    size_t* lines;    // Line number of the first line of batch i
+    size_t count;     // Number of batches
+    size_t next;      // Next batch to take
+    int counting;     // First pass
+    int workers;      // Threads taking part, the caller included
+    int arrived;      // Workers done counting
+    int stop;         // The callback asked to stop
+    json_ndjson_callback cb;
+    void* user;
+#if defined(JSON_THREADS)
+    pthread_mutex_t lock;
+    pthread_cond_t counted;
+#endif
+} json_ndjson_job;
+
+// Checked before every line, so other workers stop within one line of the
+// callback that asked for it. Relaxed is enough, nothing else is published.
+static int json_ndjson_stopped(json_ndjson_job* job) {
+#if defined(JSON_THREADS) && defined(__GNUC__)
+    return __atomic_load_n(&job->stop, __ATOMIC_RELAXED);
+#elif defined(JSON_THREADS)
+    int stop;
+    pthread_mutex_lock(&job->lock);
+    stop = job->stop;
+    pthread_mutex_unlock(&job->lock);
+    return stop;
+#else
+    return job->stop;
+#endif
+}
+
+static void json_ndjson_stop(json_ndjson_job* job) {
+#if defined(JSON_THREADS) && defined(__GNUC__)
+    __atomic_store_n(&job->stop, 1, __ATOMIC_RELAXED);
+#elif defined(JSON_THREADS)
+    pthread_mutex_lock(&job->lock);
+    job->stop = 1;
+    pthread_mutex_unlock(&job->lock);
+#else
+    job->stop = 1;
+#endif
+}
+
+static size_t json_ndjson_take(json_ndjson_job* job) {
+    size_t i;
+#if defined(JSON_THREADS)
+    pthread_mutex_lock(&job->lock);
+#endif
+    i = job->next;
+    if (i < job->count)
+        job->next++;
+#if defined(JSON_THREADS)
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return i;
+}
+
+// Called with the lock held once every worker has counted.
+static void json_ndjson_open_parse(json_ndjson_job* job) {
+    size_t i;
+    for (i = 1; i <= job->count; i++)
+        job->lines[i] += job->lines[i - 1];
+    job->next = 0;
+    job->counting = 0;
+#if defined(JSON_THREADS)
+    pthread_cond_broadcast(&job->counted);
+#endif
+}
+
+static void json_ndjson_barrier(json_ndjson_job* job) {
+#if defined(JSON_THREADS)
+    pthread_mutex_lock(&job->lock);
+    if (++job->arrived == job->workers)
+        json_ndjson_open_parse(job);
+    else
+        while (job->counting)
+            pthread_cond_wait(&job->counted, &job->lock);
+    pthread_mutex_unlock(&job->lock);
+#else
+    json_ndjson_open_parse(job);
+#endif
+}
+
+static void json_ndjson_count_batch(json_ndjson_job* job, size_t i) {
+    const char* p = job->buf + job->bounds[i];
+    const char* end = job->buf + job->bounds[i + 1];
+    size_t n = 0;
+    while ((p = (const char*)memchr(p, '\n', end - p)) != NULL) {
+        n++;
+        p++;
+    }
+    job->lines[i + 1] = n; // Turned into line numbers at the barrier
+}
+
+static void json_ndjson_parse_batch(json_ndjson_job* job, size_t i, json_context* c) {
+    const char* p = job->buf + job->bounds[i];
+    const char* end = job->buf + job->bounds[i + 1];
+    size_t line = job->lines[i];
+    for (; p < end && !json_ndjson_stopped(job); line++) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        const char* q;
+        json_value v;
+        int ret;
+        if (eol == NULL)
+            eol = end;
+        // Blank lines are allowed and skipped
+        for (q = p; q < eol && (*q == ' ' || *q == '\t' || *q == '\r'); q++)
+            ;
+        if (q < eol) {
+            c->json = p;
+            c->end = eol;
+            ret = json_parse_root(c, &v);
+            if (job->cb(job->user, line, ret, &v) != 0) {
+                json_ndjson_stop(job);
+                return;
+            }
+            json_arena_reset(c->arena);
+        }
+        p = eol + 1;
+    }
+}
+
+static void* json_ndjson_worker(void* arg) {
+    json_ndjson_job* job = (json_ndjson_job*)arg;
+    json_arena arena;
+    json_context c;
+    size_t i;
+    while ((i = json_ndjson_take(job)) < job->count)
+        json_ndjson_count_batch(job, i);
+    json_ndjson_barrier(job);
+    json_arena_init(&arena, json_heap);
+    json_context_init(&c, NULL, 0);
+    c.arena = &arena;
+    while (!json_ndjson_stopped(job) && (i = json_ndjson_take(job)) < job->count)
+        json_ndjson_parse_batch(job, i, &c);
+    JSON_FREE(c.alloc, c.stack);
+    json_arena_release(&arena);
+    return NULL;
+}
+
+int json_parse_ndjson(const char* buf, size_t len, int nthreads, json_ndjson_callback cb, void* user) {
+    assert((buf != NULL || len == 0) && cb != NULL);
+
+    json_ndjson_job job;
+    size_t cap = len / JSON_NDJSON_BATCH_SIZE + 2, pos = 0;
+    if (nthreads <= 0)
+        nthreads = json_cpu_count();
+    job.buf = buf;
+    job.bounds = (size_t*)JSON_MALLOC(json_heap, sizeof(size_t) * cap);
+    job.count = 0;
+    job.bounds[0] = 0;
+    while (pos < len) {
+        const char* eol;
+        pos = len - pos > JSON_NDJSON_BATCH_SIZE ? pos + JSON_NDJSON_BATCH_SIZE : len;
+        if (pos < len && (eol = (const char*)memchr(buf + pos, '\n', len - pos)) != NULL)
+            pos = eol - buf + 1;
+        else
+            pos = len;
+        job.bounds[++job.count] = pos;
+    }
+    job.lines = (size_t*)JSON_MALLOC(json_heap, sizeof(size_t) * (job.count + 1));
+    job.lines[0] = 0;
+    job.next = 0;
+    job.counting = 1;
+    job.arrived = 0;
+    job.stop = 0;
+    job.cb = cb;
+    job.user = user;
+#if defined(JSON_THREADS)
+    {
+        // No more threads than batches, the caller being one of them
+        int i, started = 0;
+        pthread_t* threads;
+        if ((size_t)nthreads > job.count)
+            nthreads = job.count > 0 ? (int)job.count : 1;
+        threads = (pthread_t*)JSON_MALLOC(json_heap, sizeof(pthread_t) * nthreads);
+        pthread_mutex_init(&job.lock, NULL);
+        pthread_cond_init(&job.counted, NULL);
+        job.workers = nthreads;
+        for (i = 1; i < nthreads; i++) {
+            if (pthread_create(&threads[started], NULL, json_ndjson_worker, &job) == 0)
+                started++;
+            else {
+                // The barrier must not wait for a thread that never ran. The
+                // caller has not arrived yet, so it cannot be complete here.
+                pthread_mutex_lock(&job.lock);
+                job.workers--;
+                pthread_mutex_unlock(&job.lock);
+            }
+        }
+        json_ndjson_worker(&job);
+        for (i = 0; i < started; i++)
+            pthread_join(threads[i], NULL);
+        pthread_cond_destroy(&job.counted);
+        pthread_mutex_destroy(&job.lock);
+        JSON_FREE(json_heap, threads);
+    }
+#else
+    (void)nthreads;
+    job.workers = 1;
+    json_ndjson_worker(&job);
+#endif
+    JSON_FREE(json_heap, job.bounds);
+    JSON_FREE(json_heap, job.lines);
+    return job.stop ? JSON_PARSE_ABORTED : JSON_PARSE_OK;
+}
+// NDJSON End
+
+// Parallel Begin
+// A top-level array is cut at top-level commas into one slice per thread,
+// found with the structural engine's block masks. Every slice is parsed on
+// its own context stack, then the stacks are copied one after another into
+// the final element array. Any error, and anything that is not a large
+// array, goes through the serial parser, which reports the exact error.
+typedef struct {
+    const char* json;
+    const char* end;  // Slice of elements without the brackets
+    json_context c;   // Parsed elements are left on c.stack
+    size_t size;
+    int ret;
+#if defined(JSON_THREADS)
+    pthread_t thread;
+    int threaded;     // Parsed on its own thread
+#endif
+} json_slice;
+
+// Cut the array opening at p into at most parts slices. cuts[i] is where
+// slice i starts, *close receives the closing bracket. Returns the number
+// of slices, 0 when the array is not closed.
+static size_t json_split_array(const char* p, const char* end, size_t parts, const char** cuts, const char** close) {
+    uint64_t prev_escaped = 0, prev_in_string = 0;
+    size_t depth = 0, n = 1;
+    const char* block;
+    const char* target = p + (end - p) / parts;
+    cuts[0] = p + 1;
+    for (block = p; block < end; block += 64) {
+        json_block b;
+        uint64_t quote, in_string, op;
+        if (end - block >= 64)
+            json_classify(block, &b);
+        else {
+            char tail[64];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, end - block);
+            json_classify(tail, &b);
+        }
+        quote = b.quote & ~json_escaped(b.backslash, &prev_escaped);
+        in_string = json_prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = (uint64_t)0 - (in_string >> 63);
+        for (op = b.op & ~in_string; op != 0; op &= op - 1) {
+            const char* q = block + JSON_CTZ64(op);
+            switch (*q) {
+                case '[':
+                case '{':
+                    depth++;
+                    break;
+                case ']':
+                case '}':
+                    if (--depth == 0) {
+                        *close = q;
+                        return n;
+                    }
+                    break;
+                case ',':
+                    if (depth == 1 && q >= target && n < parts) {
+                        cuts[n++] = q + 1;
+                        target = p + (end - p) / parts * n;
+                    }
+                    break;
+            }
+        }
+    }
+    return 0;
+}
+
+// Elements separated by commas up to s->end, as in json_parse_array().
+static void json_parse_slice(json_slice* s) {
+    json_context* c = &s->c;
+    json_context_init(c, s->json, s->end - s->json);
+    s->size = 0;
+    while (1) {
+        json_value e;
+        json_init(&e);
+        json_parse_whitespace(c);
+        if ((s->ret = json_parse_value(c, &e)) != JSON_PARSE_OK)
+            return;
+        memcpy(json_context_push(c, sizeof(json_value)), &e, sizeof(json_value));
+        s->size++;
+        json_parse_whitespace(c);
+        if (c->json == c->end)
+            return;
+        if (*c->json++ != ',') {
+            s->ret = JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            return;
+        }
+    }
+}
+
+#if defined(JSON_THREADS)
+static void* json_parse_slice_thread(void* arg) {
+    json_parse_slice((json_slice*)arg);
+    return NULL;
+}
+#endif
+
+int json_parse_parallel(json_value* v, const char* json, size_t len, int nthreads) {
+    assert(v != NULL && (json != NULL || len == 0));
+
+#if defined(JSON_THREADS)
+    const char* end = json + len;
+    const char* p = json;
+    const char* close;
+    const char** cuts;
+    json_slice* slices;
+    size_t n, i, size = 0;
+    int ret = JSON_PARSE_OK;
+    if (nthreads <= 0)
+        nthreads = json_cpu_count();
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    if (nthreads < 2 || len < JSON_PARALLEL_MIN_SIZE || p == end || *p != '[')
+        return json_parse_n(v, json, len);
+
+    cuts = (const char**)JSON_MALLOC(json_heap, sizeof(const char*) * nthreads);
+    if ((n = json_split_array(p, end, (size_t)nthreads, cuts, &close)) < 2) {
+        JSON_FREE(json_heap, cuts);
+        return json_parse_n(v, json, len);
+    }
+    slices = (json_slice*)JSON_MALLOC(json_heap, sizeof(json_slice) * n);
+    for (i = 0; i < n; i++) {
+        slices[i].json = cuts[i];
+        slices[i].end = i + 1 < n ? cuts[i + 1] - 1 : close;
+    }
+    // Slice 0 runs on the calling thread, as does any slice without a thread
+    for (i = 1; i < n; i++)
+        slices[i].threaded = pthread_create(&slices[i].thread, NULL, json_parse_slice_thread, &slices[i]) == 0;
+    json_parse_slice(&slices[0]);
+    for (i = 1; i < n; i++) {
+        if (slices[i].threaded)
+            pthread_join(slices[i].thread, NULL);
+        else
+            json_parse_slice(&slices[i]);
+    }
+
+    for (i = 0; i < n; i++) {
+        if (slices[i].ret != JSON_PARSE_OK)
+            ret = slices[i].ret;
+        size += slices[i].size;
+    }
+    for (p = close + 1; p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'); p++)
+        ;
+    if (ret == JSON_PARSE_OK && p == end) {
+        json_value* e = (json_value*)JSON_MALLOC(json_heap, size * sizeof(json_value));
+        v->type = JSON_ARRAY;
+        v->flags = 0;
+        v->u.a.e = e;
+        v->u.a.size = size;
+        v->u.a.capacity = size;
+        for (i = 0; i < n; i++) {
+            memcpy(e, slices[i].c.stack, slices[i].size * sizeof(json_value));
+            e += slices[i].size;
+        }
+    }
+    else {
+        for (i = 0; i < n; i++)
+            while (slices[i].size-- > 0)
+                json_free((json_value*)json_context_pop(&slices[i].c, sizeof(json_value)));
+        ret = JSON_PARSE_INVALID_VALUE;
+    }
+    for (i = 0; i < n; i++)
+        JSON_FREE(slices[i].c.alloc, slices[i].c.stack);
+    JSON_FREE(json_heap, cuts);
+    JSON_FREE(json_heap, slices);
+    return ret == JSON_PARSE_OK ? ret : json_parse_n(v, json, len);
+#else
+    (void)nthreads;
+    return json_parse_n(v, json, len);
+#endif
+}
+// Parallel End
+
+// Stringify Begin
+#define PUTS(c, s, len)     memcpy(json_context_push(c, len), s, len)
+
+// Grisu2 (Florian Loitsch), shortest digits that round-trip in nearly all
+// cases and always round-trip, after Milo Yip's implementation.
+typedef struct {
+    uint64_t f;
+    int e;
+} json_diyfp;
+
+// Normalized 10^(-348 + 8 * i) for the Grisu cached powers.
+static const uint64_t json_cached_powers_f[] = {
+    0xfa8fd5a0081c0288u, 0xbaaee17fa23ebf76u, 0x8b16fb203055ac76u, 0xcf42894a5dce35eau,
+    0x9a6bb0aa55653b2du, 0xe61acf033d1a45dfu, 0xab70fe17c79ac6cau, 0xff77b1fcbebcdc4fu,
+    0xbe5691ef416bd60cu, 0x8dd01fad907ffc3cu, 0xd3515c2831559a83u, 0x9d71ac8fada6c9b5u,
+    0xea9c227723ee8bcbu, 0xaecc49914078536du, 0x823c12795db6ce57u, 0xc21094364dfb5637u,
+    0x9096ea6f3848984fu, 0xd77485cb25823ac7u, 0xa086cfcd97bf97f4u, 0xef340a98172aace5u,
+    0xb23867fb2a35b28eu, 0x84c8d4dfd2c63f3bu, 0xc5dd44271ad3cdbau, 0x936b9fcebb25c996u,
+    0xdbac6c247d62a584u, 0xa3ab66580d5fdaf6u, 0xf3e2f893dec3f126u, 0xb5b5ada8aaff80b8u,
+    0x87625f056c7c4a8bu, 0xc9bcff6034c13053u, 0x964e858c91ba2655u, 0xdff9772470297ebdu,
+    0xa6dfbd9fb8e5b88fu, 0xf8a95fcf88747d94u, 0xb94470938fa89bcfu, 0x8a08f0f8bf0f156bu,
+    0xcdb02555653131b6u, 0x993fe2c6d07b7facu, 0xe45c10c42a2b3b06u, 0xaa242499697392d3u,
+    0xfd87b5f28300ca0eu, 0xbce5086492111aebu, 0x8cbccc096f5088ccu, 0xd1b71758e219652cu,
+    0x9c40000000000000u, 0xe8d4a51000000000u, 0xad78ebc5ac620000u, 0x813f3978f8940984u,
+    0xc097ce7bc90715b3u, 0x8f7e32ce7bea5c70u, 0xd5d238a4abe98068u, 0x9f4f2726179a2245u,
+    0xed63a231d4c4fb27u, 0xb0de65388cc8ada8u, 0x83c7088e1aab65dbu, 0xc45d1df942711d9au,
+    0x924d692ca61be758u, 0xda01ee641a708deau, 0xa26da3999aef774au, 0xf209787bb47d6b85u,
+    0xb454e4a179dd1877u, 0x865b86925b9bc5c2u, 0xc83553c5c8965d3du, 0x952ab45cfa97a0b3u,
+    0xde469fbd99a05fe3u, 0xa59bc234db398c25u, 0xf6c69a72a3989f5cu, 0xb7dcbf5354e9beceu,
+    0x88fcf317f22241e2u, 0xcc20ce9bd35c78a5u, 0x98165af37b2153dfu, 0xe2a0b5dc971f303au,
+    0xa8d9d1535ce3b396u, 0xfb9b7cd9a4a7443cu, 0xbb764c4ca7a44410u, 0x8bab8eefb6409c1au,
+    0xd01fef10a657842cu, 0x9b10a4e5e9913129u, 0xe7109bfba19c0c9du, 0xac2820d9623bf429u,
+    0x80444b5e7aa7cf85u, 0xbf21e44003acdd2du, 0x8e679c2f5e44ff8fu, 0xd433179d9c8cb841u,
+    0x9e19db92b4e31ba9u, 0xeb96bf6ebadf77d9u, 0xaf87023b9bf0ee6bu
+};
+static const short json_cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066
+};
+
+static const uint32_t json_pow10_u32[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static json_diyfp json_diyfp_make(uint64_t f, int e) {
+    json_diyfp r;
+    r.f = f;
+    r.e = e;
+    return r;
+}
+
+static json_diyfp json_diyfp_mul(json_diyfp a, json_diyfp b) {
+    uint64_t hi, lo = json_mul128(a.f, b.f, &hi);
+    hi += lo >> 63; // Round
+    return json_diyfp_make(hi, a.e + b.e + 64);
+}
+
+static json_diyfp json_diyfp_normalize(json_diyfp a) {
+    int s = json_clz64(a.f);
+    return json_diyfp_make(a.f << s, a.e - s);
+}
+
+static void json_grisu_round(char* buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static void json_grisu_digits(json_diyfp w, json_diyfp mp, uint64_t delta, char* buf, int* len, int* k) {
+    json_diyfp one = json_diyfp_make((uint64_t)1 << -mp.e, mp.e);
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+    uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = 1;
+    while (kappa < 10 && p1 >= json_pow10_u32[kappa])
+        kappa++;
+    *len = 0;
+    while (kappa > 0) {
+        uint32_t d = p1 / json_pow10_u32[kappa - 1];
+        uint64_t tmp;
+        p1 %= json_pow10_u32[kappa - 1];
+        if (d || *len)
+            buf[(*len)++] = (char)('0' + d);
+        kappa--;
+        tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *k += kappa;
+            json_grisu_round(buf, *len, delta, tmp, (uint64_t)json_pow10_u32[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+    while (1) {
+        char d;
+        p2 *= 10;
+        delta *= 10;
+        wp_w *= 10;
+        d = (char)(p2 >> -one.e);
+        if (d || *len)
+            buf[(*len)++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            json_grisu_round(buf, *len, delta, p2, one.f, wp_w);
+            return;
+        }
+    }
+}
+
+// Digits of a positive finite d into buf, d == buf * 10^k.
+static void json_grisu2(double d, char* buf, int* len, int* k) {
+    uint64_t bits, f;
+    int e, ck, index;
+    double dk;
+    json_diyfp v, plus, minus, c;
+    memcpy(&bits, &d, sizeof(d));
+    f = bits & (((uint64_t)1 << 52) - 1);
+    e = (int)(bits >> 52 & 0x7FF);
+    if (e != 0)
+        v = json_diyfp_make(f | (uint64_t)1 << 52, e - 1075);
+    else
+        v = json_diyfp_make(f, -1074);
+
+    // Boundaries m- and m+ of the rounding interval, on the same exponent
+    plus = json_diyfp_make((v.f << 1) + 1, v.e - 1);
+    while (!(plus.f & ((uint64_t)1 << 53))) {
+        plus.f <<= 1;
+        plus.e--;
+    }
+    plus.f <<= 10;
+    plus.e -= 10;
+    if (v.f == (uint64_t)1 << 52)
+        minus = json_diyfp_make((v.f << 2) - 1, v.e - 2);
+    else
+        minus = json_diyfp_make((v.f << 1) - 1, v.e - 1);
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    // Cached power that brings m+ into [-60, -32]
+    dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    ck = (int)dk;
+    if (dk - ck > 0.0)
+        ck++;
+    index = (ck >> 3) + 1;
+    *k = -(-348 + index * 8);
+    c = json_diyfp_make(json_cached_powers_f[index], json_cached_powers_e[index]);
+
+    v = json_diyfp_mul(json_diyfp_normalize(v), c);
+    plus = json_diyfp_mul(plus, c);
+    minus = json_diyfp_mul(minus, c);
+    minus.f++;
+    plus.f--;
+    json_grisu_digits(v, plus, plus.f - minus.f, buf, len, k);
+}
+
+static char* json_write_exponent(int k, char* p) {
+    if (k < 0) {
+        *p++ = '-';
+        k = -k;
+    }
+    if (k >= 100) {
+        *p++ = (char)('0' + k / 100);
+        k %= 100;
+        *p++ = (char)('0' + k / 10);
+    }
+    else if (k >= 10)
+        *p++ = (char)('0' + k / 10);
+    *p++ = (char)('0' + k % 10);
+    return p;
+}
+
+// Shortest round-trip text of a finite double, at most 25 bytes.
+// Integral values keep a ".0" so they read back as doubles.
+static char* json_dtoa(double d, char* p) {
+    int len, k, kk, i;
+    if (d == 0.0) {
+        if (signbit(d))
+            *p++ = '-';
+        memcpy(p, "0.0", 3);
+        return p + 3;
+    }
+    if (d < 0) {
+        *p++ = '-';
+        d = -d;
+    }
+    json_grisu2(d, p, &len, &k);
+    kk = len + k; // 10^(kk - 1) <= d < 10^kk
+    if (k >= 0 && kk <= 21) {
+        // 1234e7 -> 12340000000.0
+        for (i = len; i < kk; i++)
+            p[i] = '0';
+        p[kk] = '.';
+        p[kk + 1] = '0';
+        return p + kk + 2;
+    }
+    if (kk > 0 && kk <= 21) {
+        // 1234e-2 -> 12.34
+        memmove(p + kk + 1, p + kk, len - kk);
+        p[kk] = '.';
+        return p + len + 1;
+    }
+    if (kk > -6 && kk <= 0) {
+        // 1234e-6 -> 0.001234
+        int offset = 2 - kk;
+        memmove(p + offset, p, len);
+        p[0] = '0';
+        p[1] = '.';
+        for (i = 2; i < offset; i++)
+            p[i] = '0';
+        return p + len + offset;
+    }
+    if (len == 1) {
+        // 1e30
+        p[1] = 'e';
+        return json_write_exponent(kk - 1, p + 2);
+    }
+    // 1234e30 -> 1.234e33
+    memmove(p + 2, p + 1, len - 1);
+    p[1] = '.';
+    p[len + 1] = 'e';
+    return json_write_exponent(kk - 1, p + len + 2);
+}
+
+static const char json_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static char* json_u64toa(uint64_t n, char* p) {
+    char tmp[20];
+    char* t = tmp + sizeof(tmp);
+    while (n >= 100) {
+        unsigned i = (unsigned)(n % 100) * 2;
+        n /= 100;
+        *--t = json_digit_pairs[i + 1];
+        *--t = json_digit_pairs[i];
+    }
+    if (n >= 10) {
+        *--t = json_digit_pairs[n * 2 + 1];
+        *--t = json_digit_pairs[n * 2];
+    }
+    else
+        *--t = (char)('0' + n);
+    memcpy(p, t, tmp + sizeof(tmp) - t);
+    return p + (tmp + sizeof(tmp) - t);
+}
+
+static void json_stringify_number(json_context* c, const json_value* v) {
+    char* buf = (char*)json_context_push(c, 32);
+    char* end;
+    if (v->flags & JSON_FLAG_INT64) {
+        end = buf;
+        if (v->u.i < 0)
+            *end++ = '-';
+        end = json_u64toa(v->u.i < 0 ? 0 - (uint64_t)v->u.i : (uint64_t)v->u.i, end);
+    }
+    else if (v->flags & JSON_FLAG_UINT64)
+        end = json_u64toa(v->u.ui, buf);
+    else if (isfinite(v->u.n))
+        end = json_dtoa(v->u.n, buf);
+    else {
+        // Same as JSON.stringify(), JSON has no NaN or Infinity
+        memcpy(buf, "null", 4);
+        end = buf + 4;
+    }
+    c->top -= 32 - (end - buf);
+}
+
+static void json_stringify_string(json_context* c, const char* s, size_t len) {
+    static const char hex_digits[] = "0123456789ABCDEF";
+    const char* p = s;
+    const char* end = s + len;
+    PUTC(c, '"');
+    while (1) {
+        // Clean runs are copied as they are
+        const char* q = json_scan_string(p, end);
+        char ch;
+        if (q != p)
+            PUTS(c, p, q - p);
+        if (q == end)
+            break;
+        switch (ch = *q) {
+            case '\"': PUTS(c, "\\\"", 2); break;
+            case '\\': PUTS(c, "\\\\", 2); break;
+            case '\b': PUTS(c, "\\b", 2); break;
+            case '\f': PUTS(c, "\\f", 2); break;
+            case '\n': PUTS(c, "\\n", 2); break;
+            case '\r': PUTS(c, "\\r", 2); break;
+            case '\t': PUTS(c, "\\t", 2); break;
+            default: {
+                char* u = (char*)json_context_push(c, 6);
+                memcpy(u, "\\u00", 4);
+                u[4] = hex_digits[(unsigned char)ch >> 4];
+                u[5] = hex_digits[(unsigned char)ch & 15];
+            }
+        }
+        p = q + 1;
+    }
+    PUTC(c, '"');
+}
+
+static void json_stringify_indent(json_context* c, int flags, int depth) {
+    if (flags & JSON_STRINGIFY_PRETTY) {
+        PUTC(c, '\n');
+        if (depth > 0)
+            memset(json_context_push(c, depth * 4), ' ', depth * 4);
+    }
+}
+
+static void json_stringify_value(json_context* c, const json_value* v, int flags, int depth) {
+    size_t i;
+    switch (v->type) {
+        case JSON_NULL:   PUTS(c, "null", 4); break;
+        case JSON_FALSE:  PUTS(c, "false", 5); break;
+        case JSON_TRUE:   PUTS(c, "true", 4); break;
+        case JSON_NUMBER: json_stringify_number(c, v); break;
+        case JSON_STRING: json_stringify_string(c, v->u.s.s, v->u.s.len); break;
+        case JSON_ARRAY:
+            PUTC(c, '[');
+            for (i = 0; i < v->u.a.size; i++) {
+                if (i > 0)
+                    PUTC(c, ',');
+                json_stringify_indent(c, flags, depth + 1);
+                json_stringify_value(c, &v->u.a.e[i], flags, depth + 1);
+            }
+            if (v->u.a.size > 0)
+                json_stringify_indent(c, flags, depth);
+            PUTC(c, ']');
+            break;
+        case JSON_OBJECT:
+            PUTC(c, '{');
+            for (i = 0; i < v->u.o.size; i++) {
+                if (i > 0)
+                    PUTC(c, ',');
+                json_stringify_indent(c, flags, depth + 1);
+                json_stringify_string(c, v->u.o.m[i].k, v->u.o.m[i].klen);
+                if (flags & JSON_STRINGIFY_PRETTY)
+                    PUTS(c, ": ", 2);
+                else
+                    PUTC(c, ':');
+                json_stringify_value(c, &v->u.o.m[i].v, flags, depth + 1);
+            }
+            if (v->u.o.size > 0)
+                json_stringify_indent(c, flags, depth);
+            PUTC(c, '}');
+            break;
+    }
+}
+
+size_t json_stringify_to(const json_value* v, char** buf, size_t* size, int flags) {
+    assert(v != NULL && buf != NULL && size != NULL);
+
+    size_t length;
+    json_context c;
+    json_context_init(&c, NULL, 0);
+    c.stack = *buf;
+    c.size = *buf != NULL ? *size : 0;
+    json_stringify_value(&c, v, flags, 0);
+    length = c.top;
+    PUTC(&c, '\0');
+    *buf = c.stack;
+    *size = c.size;
+    return length;
+}
+
+char* json_stringify(const json_value* v, size_t* length) {
+    char* buf = NULL;
+    size_t size = 0;
+    size_t len = json_stringify_to(v, &buf, &size, 0);
+    if (length != NULL)
+        *length = len;
+    return buf;
+}
+// Stringify End
+
+// CBOR Begin
+// RFC 8949 subset that covers json_value: unsigned and negative integers
+// (major 0, 1), text strings (3), definite arrays (4) and maps (5) with
+// text keys, false, true, null and floats (7). Doubles are written as
+// single precision when that is exact, lengths and integers in the
+// shortest form.
+#define JSON_CBOR_UINT   0
+#define JSON_CBOR_NINT   1
+#define JSON_CBOR_TEXT   3
+#define JSON_CBOR_ARRAY  4
+#define JSON_CBOR_MAP    5
+#define JSON_CBOR_SIMPLE 7
+
+static void json_cbor_put_uint(json_context* c, unsigned major, uint64_t n) {
+    unsigned char* p;
+    int i, bytes;
+    if (n < 24) {
+        PUTC(c, (char)(major << 5 | (unsigned)n));
+        return;
+    }
+    if (n <= 0xFF)
+        bytes = 1;
+    else if (n <= 0xFFFF)
+        bytes = 2;
+    else if (n <= 0xFFFFFFFFu)
+        bytes = 4;
+    else
+        bytes = 8;
+    p = (unsigned char*)json_context_push(c, 1 + bytes);
+    // 24, 25, 26, 27 for 1, 2, 4, 8 bytes, big endian after it
+    p[0] = (unsigned char)(major << 5 | (bytes == 1 ? 24 : bytes == 2 ? 25 : bytes == 4 ? 26 : 27));
+    for (i = bytes; i > 0; i--, n >>= 8)
+        p[i] = (unsigned char)n;
+}
+
+static void json_cbor_put_double(json_context* c, double d) {
+    float f = (float)d;
+    unsigned char* p;
+    int i;
+    if ((double)f == d || d != d) {
+        uint32_t bits;
+        if (d != d)
+            f = NAN;
+        memcpy(&bits, &f, sizeof(f));
+        p = (unsigned char*)json_context_push(c, 5);
+        p[0] = 0xFA;
+        for (i = 4; i > 0; i--, bits >>= 8)
+            p[i] = (unsigned char)bits;
+    }
+    else {
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(d));
+        p = (unsigned char*)json_context_push(c, 9);
+        p[0] = 0xFB;
+        for (i = 8; i > 0; i--, bits >>= 8)
+            p[i] = (unsigned char)bits;
+    }
+}
+
+static void json_cbor_encode_value(json_context* c, const json_value* v) {
+    size_t i;
+    switch (v->type) {
+        case JSON_NULL:   PUTC(c, (char)0xF6); break;
+        case JSON_FALSE:  PUTC(c, (char)0xF4); break;
+        case JSON_TRUE:   PUTC(c, (char)0xF5); break;
+        case JSON_NUMBER:
+            if (v->flags & JSON_FLAG_INT64) {
+                if (v->u.i < 0)
+                    json_cbor_put_uint(c, JSON_CBOR_NINT, ~(uint64_t)v->u.i);
+                else
+                    json_cbor_put_uint(c, JSON_CBOR_UINT, (uint64_t)v->u.i);
+            }
+            else if (v->flags & JSON_FLAG_UINT64)
+                json_cbor_put_uint(c, JSON_CBOR_UINT, v->u.ui);
+            else
+                json_cbor_put_double(c, v->u.n);
+            break;
+        case JSON_STRING:
+            json_cbor_put_uint(c, JSON_CBOR_TEXT, v->u.s.len);
+            if (v->u.s.len > 0)
+                PUTS(c, v->u.s.s, v->u.s.len);
+            break;
+        case JSON_ARRAY:
+            json_cbor_put_uint(c, JSON_CBOR_ARRAY, v->u.a.size);
+            for (i = 0; i < v->u.a.size; i++)
+                json_cbor_encode_value(c, &v->u.a.e[i]);
+            break;
+        case JSON_OBJECT:
+            json_cbor_put_uint(c, JSON_CBOR_MAP, v->u.o.size);
+            for (i = 0; i < v->u.o.size; i++) {
+                json_cbor_put_uint(c, JSON_CBOR_TEXT, v->u.o.m[i].klen);
+                if (v->u.o.m[i].klen > 0)
+                    PUTS(c, v->u.o.m[i].k, v->u.o.m[i].klen);
+                json_cbor_encode_value(c, &v->u.o.m[i].v);
+            }
+            break;
+    }
+}
+
+size_t json_cbor_encode_to(const json_value* v, char** buf, size_t* size) {
+    assert(v != NULL && buf != NULL && size != NULL);
+
+    json_context c;
+    json_context_init(&c, NULL, 0);
+    c.stack = *buf;
+    c.size = *buf != NULL ? *size : 0;
+    json_cbor_encode_value(&c, v);
+    *buf = c.stack;
+    *size = c.size;
+    return c.top;
+}
+
+char* json_cbor_encode(const json_value* v, size_t* length) {
+    char* buf = NULL;
+    size_t size = 0;
+    size_t len = json_cbor_encode_to(v, &buf, &size);
+    if (length != NULL)
+        *length = len;
+    return buf;
+}
+
+// Initial byte and argument of the next item, major type in *major.
+static int json_cbor_get_head(json_context* c, unsigned* major, uint64_t* n) {
+    const unsigned char* p = (const unsigned char*)c->json;
+    unsigned info, bytes, i;
+    if (c->json == c->end)
+        return JSON_PARSE_EXPECT_VALUE;
+    *major = p[0] >> 5;
+    info = p[0] & 31;
+    if (info < 24) {
+        *n = info;
+        c->json++;
+        return JSON_PARSE_OK;
+    }
+    // Reserved values and indefinite lengths are not supported
+    if (info > 27)
+        return JSON_PARSE_INVALID_VALUE;
+    bytes = 1u << (info - 24);
+    if ((size_t)(c->end - c->json) <= bytes)
+        return JSON_PARSE_INVALID_VALUE;
+    *n = 0;
+    for (i = 1; i <= bytes; i++)
+        *n = *n << 8 | p[i];
+    c->json += 1 + bytes;
+    return JSON_PARSE_OK;
+}
+
+// Half precision, only ever read.
+static double json_cbor_half(unsigned h) {
+    unsigned e = (h >> 10) & 31, m = h & 1023;
+    uint64_t bits;
+    double d;
+    if (e == 0)
+        d = m / 16777216.0; // m * 2^-24, exact
+    else if (e == 31)
+        d = m == 0 ? INFINITY : NAN;
+    else {
+        bits = (uint64_t)(e - 15 + 1023) << 52 | (uint64_t)m << 42;
+        memcpy(&d, &bits, sizeof(d));
+    }
+    return h & 0x8000 ? -d : d;
+}
+
+static int json_cbor_decode_value(json_context* c, json_value* v) {
+    unsigned major;
+    uint64_t n;
+    size_t i;
+    int ret;
+    const char* head = c->json;
+    if ((ret = json_cbor_get_head(c, &major, &n)) != JSON_PARSE_OK)
+        return ret;
+    switch (major) {
+        case JSON_CBOR_UINT:
+            if (n <= INT64_MAX) {
+                v->u.i = (int64_t)n;
+                v->flags = JSON_FLAG_INT64;
+            }
+            else {
+                v->u.ui = n;
+                v->flags = JSON_FLAG_UINT64;
+            }
+            v->type = JSON_NUMBER;
+            return JSON_PARSE_OK;
+        case JSON_CBOR_NINT:
+            // Below INT64_MIN text parsing falls back to a double as well
+            if (n <= INT64_MAX) {
+                v->u.i = -1 - (int64_t)n;
+                v->flags = JSON_FLAG_INT64;
+            }
+            else {
+                v->u.n = -1.0 - (double)n;
+                v->flags = 0;
+            }
+            v->type = JSON_NUMBER;
+            return JSON_PARSE_OK;
+        case JSON_CBOR_TEXT:
+            if (n > (uint64_t)(c->end - c->json))
+                return JSON_PARSE_INVALID_VALUE;
+            if (!json_utf8_valid(c->json, c->json + n))
+                return JSON_PARSE_INVALID_STRING_CHAR;
+            json_context_set_string(c, v, (char*)c->json, (size_t)n);
+            c->json += n;
+            return JSON_PARSE_OK;
+        case JSON_CBOR_ARRAY: {
+            json_value* e;
+            // Every element takes at least one byte
+            if (n > (uint64_t)(c->end - c->json))
+                return JSON_PARSE_INVALID_VALUE;
+            v->type = JSON_ARRAY;
+            v->flags = JSON_CONTEXT_FLAGS(c) & JSON_FLAG_BORROWED;
+            v->u.a.size = (size_t)n;
+            v->u.a.capacity = (size_t)n;
+            v->u.a.e = NULL;
+            if (n == 0)
+                return JSON_PARSE_OK;
+            e = (json_value*)json_context_alloc(c, (size_t)n * sizeof(json_value));
+            for (i = 0; i < n; i++) {
+                json_init(&e[i]);
+                if ((ret = json_cbor_decode_value(c, &e[i])) != JSON_PARSE_OK)
+                    break;
+            }
+            if (i == n) {
+                v->u.a.e = e;
+                return JSON_PARSE_OK;
+            }
+            while (i > 0)
+                json_free(&e[--i]);
+            if (c->arena == NULL)
+                JSON_FREE(json_heap, e);
+            break;
+        }
+        case JSON_CBOR_MAP: {
+            json_member* m;
+            if (n > (uint64_t)(c->end - c->json) / 2)
+                return JSON_PARSE_INVALID_VALUE;
+            v->type = JSON_OBJECT;
+            v->flags = JSON_CONTEXT_FLAGS(c);
+            v->u.o.size = (size_t)n;
+            v->u.o.capacity = (size_t)n;
+            v->u.o.m = NULL;
+            v->u.o.index = NULL;
+            if (n == 0)
+                return JSON_PARSE_OK;
+            m = (json_member*)json_context_alloc(c, (size_t)n * sizeof(json_member));
+            for (i = 0; i < n; i++) {
+                uint64_t klen;
+                json_init(&m[i].v);
+                if ((ret = json_cbor_get_head(c, &major, &klen)) != JSON_PARSE_OK)
+                    break;
+                if (major != JSON_CBOR_TEXT || klen > (uint64_t)(c->end - c->json)) {
+                    ret = major != JSON_CBOR_TEXT ? JSON_PARSE_MISS_KEY : JSON_PARSE_INVALID_VALUE;
+                    break;
+                }
+                if (!json_utf8_valid(c->json, c->json + klen)) {
+                    ret = JSON_PARSE_INVALID_STRING_CHAR;
+                    break;
+                }
+                m[i].klen = (size_t)klen;
+                m[i].k = json_context_key(c, (char*)c->json, m[i].klen);
+                c->json += klen;
+                if ((ret = json_cbor_decode_value(c, &m[i].v)) != JSON_PARSE_OK) {
+                    if (!(v->flags & JSON_FLAG_KEYS_BORROWED))
+                        JSON_FREE(json_heap, m[i].k);
+                    break;
+                }
+            }
+            if (i == n) {
+                v->u.o.m = m;
+                return JSON_PARSE_OK;
+            }
+            while (i > 0) {
+                i--;
+                json_free(&m[i].v);
+                if (!(v->flags & JSON_FLAG_KEYS_BORROWED))
+                    JSON_FREE(json_heap, m[i].k);
+            }
+            if (c->arena == NULL)
+                JSON_FREE(json_heap, m);
+            break;
+        }
+        case JSON_CBOR_SIMPLE: {
+            const unsigned char* p = (const unsigned char*)head;
+            switch (p[0]) {
+                case 0xF4: v->type = JSON_FALSE; return JSON_PARSE_OK;
+                case 0xF5: v->type = JSON_TRUE; return JSON_PARSE_OK;
+                case 0xF6: v->type = JSON_NULL; return JSON_PARSE_OK;
+                case 0xF9: v->u.n = json_cbor_half((unsigned)n); break;
+                case 0xFA: {
+                    uint32_t bits = (uint32_t)n;
+                    float f;
+                    memcpy(&f, &bits, sizeof(f));
+                    v->u.n = f;
+                    break;
+                }
+                case 0xFB: memcpy(&v->u.n, &n, sizeof(n)); break;
+                default: return JSON_PARSE_INVALID_VALUE;
+            }
+            v->type = JSON_NUMBER;
+            v->flags = 0;
+            return JSON_PARSE_OK;
+        }
+        default:
+            // Byte strings and tags have no JSON counterpart
+            return JSON_PARSE_INVALID_VALUE;
+    }
+    json_init(v);
+    return ret;
+}
+
+int json_cbor_decode(json_value* v, const void* data, size_t len) {
+    assert(v != NULL && (data != NULL || len == 0));
+
+    int ret;
+    json_context c;
+    json_context_init(&c, (const char*)data, len);
+    json_init(v);
+    if ((ret = json_cbor_decode_value(&c, v)) == JSON_PARSE_OK && c.json != c.end) {
+        json_free(v);
+        ret = JSON_PARSE_ROOT_NOT_SINGULAR;
+    }
+    return ret;
+}
+// CBOR End
+
+// Snapshot Begin
+// Image layout, native byte order, every offset is from the image start and
+// every item 8-byte aligned:
+//   header  "MJSS", version, byte order mark, reserved, image size
+//   node    [type | number type << 4 | size << 8] [data], root at 32
+// Node data by type:
+//   number  the double, int64 or uint64 bits
+//   string  offset of the bytes, NUL-terminated, size is the length
+//   array   offset of size consecutive nodes
+//   object  offset of [mask] [mask + 1 slots if mask != 0] [members], a slot
+//           is hash << 32 | (index + 1) and a member is [key offset]
+//           [key length] [node]
+#define JSON_SNAPSHOT_MAGIC      "MJSS"
+#define JSON_SNAPSHOT_VERSION    1
+#define JSON_SNAPSHOT_BOM        0x01020304u
+#define JSON_SNAPSHOT_HEADER     32
+#define JSON_SNAPSHOT_NODE       16
+#define JSON_SNAPSHOT_MEMBER     32
+
+struct json_snapshot {
+    const char* base;
+    size_t size;
+    int mapped; // base is a mapping of size bytes owned by the snapshot
+};
+
+#define JSON_SNAPSHOT_WORD(s, at)  (*(const uint64_t*)((s)->base + (at)))
+#define JSON_SNAPSHOT_TYPE(s, n)   ((json_type)(JSON_SNAPSHOT_WORD(s, n) & 0x0F))
+#define JSON_SNAPSHOT_SIZE(s, n)   ((size_t)(JSON_SNAPSHOT_WORD(s, n) >> 8))
+#define JSON_SNAPSHOT_DATA(s, n)   JSON_SNAPSHOT_WORD(s, (n) + 8)
+
+// Zeroed room for size bytes at the end of the image, returns its offset.
+static size_t json_snapshot_reserve(json_context* c, size_t size) {
+    size_t at = c->top;
+    size = (size + 7) & ~(size_t)7;
+    memset(json_context_push(c, size), 0, size);
+    return at;
+}
+
+static void json_snapshot_put(json_context* c, size_t at, uint64_t w) {
+    memcpy(c->stack + at, &w, sizeof(w));
+}
+
+static uint64_t json_snapshot_get(const json_context* c, size_t at) {
+    uint64_t w;
+    memcpy(&w, c->stack + at, sizeof(w));
+    return w;
+}
+
+static size_t json_snapshot_put_string(json_context* c, const char* s, size_t len) {
+    size_t at = json_snapshot_reserve(c, len + 1);
+    if (len > 0)
+        memcpy(c->stack + at, s, len);
+    return at;
+}
+
+static void json_snapshot_put_value(json_context* c, size_t n, const json_value* v) {
+    uint64_t tag = (uint64_t)v->type, data = 0;
+    size_t i, at;
+    switch (v->type) {
+        case JSON_NUMBER:
+            tag |= (uint64_t)json_get_number_type(v) << 4;
+            memcpy(&data, &v->u, sizeof(data));
+            break;
+        case JSON_STRING:
+            tag |= (uint64_t)v->u.s.len << 8;
+            data = json_snapshot_put_string(c, v->u.s.s, v->u.s.len);
+            break;
+        case JSON_ARRAY:
+            tag |= (uint64_t)v->u.a.size << 8;
+            if (v->u.a.size == 0)
+                break;
+            data = at = json_snapshot_reserve(c, v->u.a.size * JSON_SNAPSHOT_NODE);
+            for (i = 0; i < v->u.a.size; i++)
+                json_snapshot_put_value(c, at + i * JSON_SNAPSHOT_NODE, &v->u.a.e[i]);
+            break;
+        case JSON_OBJECT: {
+            size_t slots = 0, mask = 0;
+            tag |= (uint64_t)v->u.o.size << 8;
+            // Large objects carry the same hash index as json_find_object_index()
+            if (v->u.o.size > JSON_OBJECT_INDEX_THRESHOLD && v->u.o.size <= UINT32_MAX) {
+                for (slots = 2; slots < v->u.o.size * 2; slots <<= 1)
+                    ;
+                mask = slots - 1;
+            }
+            data = json_snapshot_reserve(c, 8 + slots * 8 + v->u.o.size * JSON_SNAPSHOT_MEMBER);
+            json_snapshot_put(c, (size_t)data, mask);
+            at = (size_t)data + 8 + slots * 8;
+            for (i = 0; i < v->u.o.size; i++) {
+                const json_member* m = &v->u.o.m[i];
+                size_t k = at + i * JSON_SNAPSHOT_MEMBER;
+                json_snapshot_put(c, k, json_snapshot_put_string(c, m->k, m->klen));
+                json_snapshot_put(c, k + 8, m->klen);
+                json_snapshot_put_value(c, k + 16, &m->v);
+                if (mask != 0) {
+                    uint32_t h = json_hash_key(m->k, m->klen);
+                    size_t j = h & mask;
+                    // First come first served, so duplicates resolve to the first one
+                    while (json_snapshot_get(c, (size_t)data + 8 + j * 8) != 0)
+                        j = (j + 1) & mask;
+                    json_snapshot_put(c, (size_t)data + 8 + j * 8, (uint64_t)h << 32 | (i + 1));
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    json_snapshot_put(c, n, tag);
+    json_snapshot_put(c, n + 8, data);
+}
+
+char* json_snapshot_encode(const json_value* v, size_t* length) {
+    assert(v != NULL);
+
+    json_context c;
+    uint32_t head[4] = { 0, JSON_SNAPSHOT_VERSION, JSON_SNAPSHOT_BOM, 0 };
+    json_context_init(&c, NULL, 0);
+    memcpy(head, JSON_SNAPSHOT_MAGIC, 4);
+    json_snapshot_reserve(&c, JSON_SNAPSHOT_HEADER + JSON_SNAPSHOT_NODE);
+    memcpy(c.stack, head, sizeof(head));
+    json_snapshot_put_value(&c, JSON_SNAPSHOT_HEADER, v);
+    json_snapshot_put(&c, 16, c.top);
+    if (length != NULL)
+        *length = c.top;
+    return c.stack;
+}
+
+int json_snapshot_write(const json_value* v, const char* path) {
+    assert(v != NULL && path != NULL);
+
+    size_t len;
+    char* image = json_snapshot_encode(v, &len);
+    FILE* f = fopen(path, "wb");
+    int ret = JSON_PARSE_IO_ERROR;
+    if (f != NULL) {
+        if (fwrite(image, 1, len, f) == len)
+            ret = JSON_PARSE_OK;
+        if (fclose(f) != 0)
+            ret = JSON_PARSE_IO_ERROR;
+    }
+    JSON_FREE(json_heap, image);
+    return ret;
+}
+
+// Only the header is checked, the rest of the image is trusted.
+static int json_snapshot_valid(const char* image, size_t len) {
+    uint32_t head[4];
+    uint64_t size;
+    if (len < JSON_SNAPSHOT_HEADER + JSON_SNAPSHOT_NODE)
+        return 0;
+    memcpy(head, image, sizeof(head));
+    memcpy(&size, image + 16, sizeof(size));
+    return memcmp(head, JSON_SNAPSHOT_MAGIC, 4) == 0 && head[1] == JSON_SNAPSHOT_VERSION &&
+        head[2] == JSON_SNAPSHOT_BOM && size == len;
+}
+
+json_snapshot* json_snapshot_open_buffer(const void* image, size_t len) {
+    json_snapshot* s;
+    assert(image != NULL && ((uintptr_t)image & 7) == 0);
+    if (!json_snapshot_valid((const char*)image, len))
+        return NULL;
+    s = (json_snapshot*)JSON_MALLOC(json_heap, sizeof(json_snapshot));
+    s->base = (const char*)image;
+    s->size = len;
+    s->mapped = 0;
+    return s;
+}
+
+#if !defined(_WIN32)
+json_snapshot* json_snapshot_open(const char* path) {
+    assert(path != NULL);
+
+    struct stat st;
+    json_snapshot* s;
+    void* map;
+    int fd;
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return NULL;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < JSON_SNAPSHOT_HEADER + JSON_SNAPSHOT_NODE) {
+        close(fd);
+        return NULL;
     }
-    // Free allocated memory when parsing failed
-    for (size_t i = 0; i < size; i++)
-        json_free((json_value*)json_context_pop(c, sizeof(json_value)));
+    // Shared so every process opening the image reads the same page cache
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+    if ((s = json_snapshot_open_buffer(map, (size_t)st.st_size)) == NULL) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    s->mapped = 1;
+    return s;
+}
 
-    return ret;
+void json_snapshot_close(json_snapshot* s) {
+    if (s == NULL)
+        return;
+    if (s->mapped)
+        munmap((void*)s->base, s->size);
+    JSON_FREE(json_heap, s);
 }
+#else
+// No mmap(), read the image in one go instead.
+json_snapshot* json_snapshot_open(const char* path) {
+    assert(path != NULL);
 
-static int json_parse_object(json_context* c, json_value* v) {
-    size_t i, size;
-    json_member m;
-    int ret;
-    EXPECT(c, '{');
-    json_parse_whitespace(c);
-    if (*c->json == '}') {
-        c->json++;
-        v->type = JSON_OBJECT;
-        v->u.o.m = 0;
-        v->u.o.size = 0;
-        return JSON_PARSE_OK;
+    FILE* f;
+    char* buf;
+    long size;
+    json_snapshot* s = NULL;
+    if ((f = fopen(path, "rb")) == NULL)
+        return NULL;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0) {
+        buf = (char*)JSON_MALLOC(json_heap, (size_t)size);
+        if (fread(buf, 1, (size_t)size, f) == (size_t)size && (s = json_snapshot_open_buffer(buf, (size_t)size)) != NULL)
+            s->mapped = 1;
+        else
+            JSON_FREE(json_heap, buf);
     }
-    m.k = NULL;
-    size = 0;
-    while(1) {
-        char* str;
-        json_init(&m.v);
+    fclose(f);
+    return s;
+}
 
-        // parse key
-        if (*c->json != '"') {
-            ret = JSON_PARSE_MISS_KEY;
-            break;
-        }
-        if ((ret = json_parse_string_raw(c, &str, &m.klen)) != JSON_PARSE_OK)
-            break;
-        memcpy(m.k = (char*)malloc(m.klen + 1), str, m.klen);
-        m.k[m.klen] = '\0';
+void json_snapshot_close(json_snapshot* s) {
+    if (s == NULL)
+        return;
+    if (s->mapped)
+        JSON_FREE(json_heap, (void*)s->base);
+    JSON_FREE(json_heap, s);
+}
+#endif
 
-        // parse ws colon ws
-        json_parse_whitespace(c);
-        if (*c->json != ':') {
-            ret = JSON_PARSE_MISS_COLON;
-            break;
-        }
-        c->json++;
-        json_parse_whitespace(c);
+size_t json_snapshot_root(const json_snapshot* s) {
+    assert(s != NULL);
+    return JSON_SNAPSHOT_HEADER;
+}
 
-        // parse value
-        if ((ret = json_parse_value(c, &m.v)) != JSON_PARSE_OK)
-            break;
-        memcpy(json_context_push(c, sizeof(json_member)), &m, sizeof(json_member));
-        size++;
-        m.k = NULL; // ownership is transferred to member on stack
+json_type json_snapshot_get_type(const json_snapshot* s, size_t n) {
+    assert(s != NULL && n + JSON_SNAPSHOT_NODE <= s->size);
+    return JSON_SNAPSHOT_TYPE(s, n);
+}
 
-        // parse comma or right-curly-brace
-        json_parse_whitespace(c);
-        if (*c->json == ',') {
-            c->json++;
-            json_parse_whitespace(c);
-        }
-        else if (*c->json == '}') {
-            size_t s = sizeof(json_member) * size;
-            c->json++;
-            v->type = JSON_OBJECT;
-            v->u.o.size = size;
-            memcpy(v->u.o.m = (json_member*)malloc(s), json_context_pop(c, s), s);
-            return JSON_PARSE_OK;
-        }
-        else {
-            ret = JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
-            break;
-        }
-    }
-    // Pop and free members on the stack
-    free(m.k);
-    for (i = 0; i < size; i++) {
-        json_member* m = (json_member*)json_context_pop(c, sizeof(json_member));
-        free(m->k);
-        json_free(&m->v);
+json_number_type json_snapshot_get_number_type(const json_snapshot* s, size_t n) {
+    assert(json_snapshot_get_type(s, n) == JSON_NUMBER);
+    return (json_number_type)((JSON_SNAPSHOT_WORD(s, n) >> 4) & 0x0F);
+}
+
+double json_snapshot_get_number(const json_snapshot* s, size_t n) {
+    uint64_t w = JSON_SNAPSHOT_DATA(s, n);
+    double d;
+    switch (json_snapshot_get_number_type(s, n)) {
+        case JSON_NUMBER_INT64:  return (double)(int64_t)w;
+        case JSON_NUMBER_UINT64: return (double)w;
+        default:
+            memcpy(&d, &w, sizeof(d));
+            return d;
     }
-    v->type = JSON_NULL;
-    return ret;
 }
 
-static int json_parse_value(json_context* c, json_value* v) {
-    switch (*c->json) { // Equals to c->json[0]
-        case 'n':  return json_parse_literal(c, v, "null", JSON_NULL);
-        case 't':  return json_parse_literal(c, v, "true", JSON_TRUE);
-        case 'f':  return json_parse_literal(c, v, "false", JSON_FALSE);
-        case '\"': return json_parse_string(c, v);
-        case '\0': return JSON_PARSE_EXPECT_VALUE;
-        case '[':  return json_parse_array(c, v);
-        case '{':  return json_parse_object(c, v);
-        default:   return json_parse_number(c, v);
+int64_t json_snapshot_get_int64(const json_snapshot* s, size_t n) {
+    assert(json_snapshot_get_number_type(s, n) == JSON_NUMBER_INT64 ||
+        (json_snapshot_get_number_type(s, n) == JSON_NUMBER_UINT64 && JSON_SNAPSHOT_DATA(s, n) <= INT64_MAX));
+    return (int64_t)JSON_SNAPSHOT_DATA(s, n);
+}
+
+uint64_t json_snapshot_get_uint64(const json_snapshot* s, size_t n) {
+    assert(json_snapshot_get_number_type(s, n) == JSON_NUMBER_UINT64 ||
+        (json_snapshot_get_number_type(s, n) == JSON_NUMBER_INT64 && (int64_t)JSON_SNAPSHOT_DATA(s, n) >= 0));
+    return JSON_SNAPSHOT_DATA(s, n);
+}
+
+int json_snapshot_get_boolean(const json_snapshot* s, size_t n) {
+    assert(json_snapshot_get_type(s, n) == JSON_TRUE || json_snapshot_get_type(s, n) == JSON_FALSE);
+    return json_snapshot_get_type(s, n) == JSON_TRUE;
+}
+
+const char* json_snapshot_get_string(const json_snapshot* s, size_t n) {
+    assert(json_snapshot_get_type(s, n) == JSON_STRING);
+    return s->base + JSON_SNAPSHOT_DATA(s, n);
+}
+
+size_t json_snapshot_get_string_length(const json_snapshot* s, size_t n) {
+    assert(json_snapshot_get_type(s, n) == JSON_STRING);
+    return JSON_SNAPSHOT_SIZE(s, n);
+}
+
+size_t json_snapshot_get_array_size(const json_snapshot* s, size_t n) {
+    assert(json_snapshot_get_type(s, n) == JSON_ARRAY);
+    return JSON_SNAPSHOT_SIZE(s, n);
+}
+
+size_t json_snapshot_get_array_element(const json_snapshot* s, size_t n, size_t index) {
+    assert(index < json_snapshot_get_array_size(s, n));
+    return (size_t)JSON_SNAPSHOT_DATA(s, n) + index * JSON_SNAPSHOT_NODE;
+}
+
+size_t json_snapshot_get_object_size(const json_snapshot* s, size_t n) {
+    assert(json_snapshot_get_type(s, n) == JSON_OBJECT);
+    return JSON_SNAPSHOT_SIZE(s, n);
+}
+
+// Offset of member index.
+static size_t json_snapshot_member(const json_snapshot* s, size_t n, size_t index) {
+    size_t at = (size_t)JSON_SNAPSHOT_DATA(s, n);
+    size_t mask = (size_t)JSON_SNAPSHOT_WORD(s, at);
+    return at + 8 + (mask != 0 ? (mask + 1) * 8 : 0) + index * JSON_SNAPSHOT_MEMBER;
+}
+
+const char* json_snapshot_get_object_key(const json_snapshot* s, size_t n, size_t index) {
+    assert(index < json_snapshot_get_object_size(s, n));
+    return s->base + JSON_SNAPSHOT_WORD(s, json_snapshot_member(s, n, index));
+}
+
+size_t json_snapshot_get_object_key_length(const json_snapshot* s, size_t n, size_t index) {
+    assert(index < json_snapshot_get_object_size(s, n));
+    return (size_t)JSON_SNAPSHOT_WORD(s, json_snapshot_member(s, n, index) + 8);
+}
+
+size_t json_snapshot_get_object_value(const json_snapshot* s, size_t n, size_t index) {
+    assert(index < json_snapshot_get_object_size(s, n));
+    return json_snapshot_member(s, n, index) + 16;
+}
+
+size_t json_snapshot_find_object_index(const json_snapshot* s, size_t n, const char* key, size_t klen) {
+    size_t size = json_snapshot_get_object_size(s, n), at, mask, i;
+    if (size == 0)
+        return JSON_KEY_NOT_EXIST;
+    at = (size_t)JSON_SNAPSHOT_DATA(s, n);
+    mask = (size_t)JSON_SNAPSHOT_WORD(s, at);
+    if (mask != 0) {
+        uint32_t h = json_hash_key(key, klen);
+        uint64_t w;
+        for (i = h & mask; (w = JSON_SNAPSHOT_WORD(s, at + 8 + i * 8)) != 0; i = (i + 1) & mask) {
+            size_t index = (size_t)(w & 0xFFFFFFFFu) - 1;
+            if ((uint32_t)(w >> 32) == h && json_snapshot_get_object_key_length(s, n, index) == klen &&
+                memcmp(json_snapshot_get_object_key(s, n, index), key, klen) == 0)
+                return index;
+        }
+        return JSON_KEY_NOT_EXIST;
     }
+    for (i = 0; i < size; i++)
+        if (json_snapshot_get_object_key_length(s, n, i) == klen &&
+            memcmp(json_snapshot_get_object_key(s, n, i), key, klen) == 0)
+            return i;
+    return JSON_KEY_NOT_EXIST;
 }
+// Snapshot End
 
-int json_parse(json_value* v, const char* json) {
-    assert(v != NULL);
+// Object Index Begin
+// Open addressing table over the members of one object, filled on the first
+// lookup. Each slot holds the key hash and the member index + 1, 0 marks an
+// empty slot. Heap objects allocate it then and json_free() drops it.
+// Objects parsed into an arena have it reserved in the same arena during
+// the parse, since nothing would free a heap table before a reset, and
+// lookups then never allocate.
+typedef struct {
+    uint32_t hash;
+    uint32_t index;
+} json_object_slot;
 
-    int ret;
-    json_context c;
-    c.json = json;
-    c.stack = NULL;
-    c.size = c.top = 0;
-    json_init(v);
+struct json_object_index {
+    json_arena* arena; // Owner of the table, NULL for the heap
+    size_t mask;       // Slot count - 1, the slot count is a power of two
+    int filled;        // Slots match the members
+    json_object_slot slots[1];
+};
 
-    json_parse_whitespace(&c);
-    if ((ret = json_parse_value(&c, v)) == JSON_PARSE_OK) {
-        json_parse_whitespace(&c);
-        // Has extra chars at the end of the value, fail it
-        if (*(c.json) != '\0') {
-            v->type = JSON_NULL;
-            ret = JSON_PARSE_ROOT_NOT_SINGULAR;
+// Empty table with room for the members of v.
+static json_object_index* json_object_index_create(const json_value* v, json_arena* arena) {
+    json_object_index* x;
+    size_t n = 2, size;
+    // Keep the load factor at or below one half
+    while (n < v->u.o.size * 2)
+        n <<= 1;
+    size = sizeof(json_object_index) + (n - 1) * sizeof(json_object_slot);
+    x = (json_object_index*)(arena != NULL ? json_arena_alloc(arena, size) : JSON_MALLOC(json_heap, size));
+    x->arena = arena;
+    x->mask = n - 1;
+    x->filled = 0;
+    return x;
+}
+
+static void json_object_index_fill(const json_value* v, json_object_index* x) {
+    size_t i;
+    memset(x->slots, 0, (x->mask + 1) * sizeof(json_object_slot));
+    for (i = 0; i < v->u.o.size; i++) {
+        const json_member* m = &v->u.o.m[i];
+        uint32_t h = json_hash_key(m->k, m->klen);
+        size_t j = h & x->mask;
+        for (; x->slots[j].index != 0; j = (j + 1) & x->mask) {
+            const json_member* o = &v->u.o.m[x->slots[j].index - 1];
+            if (x->slots[j].hash == h && o->klen == m->klen && memcmp(o->k, m->k, m->klen) == 0)
+                break; // Duplicate key, the first one wins as in a linear scan
+        }
+        if (x->slots[j].index == 0) {
+            x->slots[j].hash = h;
+            x->slots[j].index = (uint32_t)(i + 1);
         }
     }
-    assert(c.top == 0);
-    free(c.stack);
-    return ret;
+    x->filled = 1;
 }
 
+// Drop the table of v, arena tables go away with their arena.
+static void json_object_index_drop(json_value* v) {
+    if (v->u.o.index != NULL && v->u.o.index->arena == NULL)
+        JSON_FREE(json_heap, v->u.o.index);
+    v->u.o.index = NULL;
+}
+
+// Add the member at index, which has a key not in the table yet. A table
+// that would pass a load factor of one half is replaced by a larger one,
+// so appends keep lookups O(1) amortized.
+static void json_object_index_insert(json_value* v, size_t index) {
+    json_object_index* x = v->u.o.index;
+    const json_member* m = &v->u.o.m[index];
+    uint32_t h;
+    size_t j;
+    if (v->u.o.size * 2 > x->mask + 1 || index >= UINT32_MAX) {
+        json_arena* arena = x->arena;
+        json_object_index_drop(v);
+        if (arena != NULL)
+            v->u.o.index = json_object_index_create(v, arena);
+        return;
+    }
+    if (!x->filled)
+        return;
+    h = json_hash_key(m->k, m->klen);
+    for (j = h & x->mask; x->slots[j].index != 0; j = (j + 1) & x->mask)
+        ;
+    x->slots[j].hash = h;
+    x->slots[j].index = (uint32_t)(index + 1);
+}
+// Object Index End
+
 void json_free(json_value* v) {
     // TODO: fix memory leak
     assert(v != NULL);
-    // Free allocated memory only when v is string type
+    // Free allocated memory only when v owns it
     switch (v->type) {
         case JSON_STRING:
-            free(v->u.s.s);
+            if (!(v->flags & JSON_FLAG_BORROWED))
+                JSON_FREE(json_heap, v->u.s.s);
             break;
         case JSON_ARRAY:
             for (size_t i = 0; i < v->u.a.size; i++)
                 json_free(&v->u.a.e[i]);
-            free(v->u.a.e);
+            if (!(v->flags & JSON_FLAG_BORROWED))
+                JSON_FREE(json_heap, v->u.a.e);
             break;
         case JSON_OBJECT:
             for (size_t i = 0; i < v->u.o.size; i++) {
-                free(v->u.o.m[i].k);
+                if (!(v->flags & JSON_FLAG_KEYS_BORROWED))
+                    JSON_FREE(json_heap, v->u.o.m[i].k);
                 json_free(&v->u.o.m[i].v);
             }
-            free(v->u.o.m);
+            if (!(v->flags & JSON_FLAG_BORROWED))
+                JSON_FREE(json_heap, v->u.o.m);
+            json_object_index_drop(v);
             break;
         default: break;
     }
     v->type = JSON_NULL;
+    v->flags = 0;
 }
 
 // Getter Begin
@@ -322,11 +5384,36 @@ json_type json_get_type(const json_value* v) {
     return v->type;
 }
 
+json_number_type json_get_number_type(const json_value* v) {
+    assert(v != NULL && v->type == JSON_NUMBER);
+    if (v->flags & JSON_FLAG_INT64)
+        return JSON_NUMBER_INT64;
+    if (v->flags & JSON_FLAG_UINT64)
+        return JSON_NUMBER_UINT64;
+    return JSON_NUMBER_DOUBLE;
+}
+
 double json_get_number(const json_value* v) {
     assert(v != NULL && v->type == JSON_NUMBER);
+    if (v->flags & JSON_FLAG_INT64)
+        return (double)v->u.i;
+    if (v->flags & JSON_FLAG_UINT64)
+        return (double)v->u.ui;
     return v->u.n;
 }
 
+int64_t json_get_int64(const json_value* v) {
+    assert(v != NULL && v->type == JSON_NUMBER);
+    assert((v->flags & JSON_FLAG_INT64) || ((v->flags & JSON_FLAG_UINT64) && v->u.ui <= INT64_MAX));
+    return v->u.i;
+}
+
+uint64_t json_get_uint64(const json_value* v) {
+    assert(v != NULL && v->type == JSON_NUMBER);
+    assert(((v->flags & JSON_FLAG_INT64) && v->u.i >= 0) || (v->flags & JSON_FLAG_UINT64));
+    return v->u.ui;
+}
+
 int json_get_boolean(const json_value* v) {
     assert(v != NULL && (v->type == JSON_TRUE || v->type == JSON_FALSE));
     return v->type == JSON_TRUE;
@@ -347,6 +5434,11 @@ size_t json_get_array_size(const json_value* v) {
     return v->u.a.size;
 }
 
+size_t json_get_array_capacity(const json_value* v) {
+    assert(v != NULL && v->type == JSON_ARRAY);
+    return v->u.a.capacity;
+}
+
 json_value* json_get_array_element(const json_value* v, size_t index) {
     assert(v != NULL && v->type == JSON_ARRAY);
     assert(index < v->u.a.size);
@@ -358,6 +5450,11 @@ size_t json_get_object_size(const json_value* v) {
     return v->u.o.size;
 }
 
+size_t json_get_object_capacity(const json_value* v) {
+    assert(v != NULL && v->type == JSON_OBJECT);
+    return v->u.o.capacity;
+}
+
 const char* json_get_object_key(const json_value* v, size_t index) {
     assert(v != NULL && v->type == JSON_OBJECT);
     assert(index < v->u.o.size);
@@ -375,6 +5472,41 @@ json_value* json_get_object_value(const json_value* v, size_t index) {
     assert(index < v->u.o.size);
     return &v->u.o.m[index].v;
 }
+
+size_t json_find_object_index(const json_value* v, const char* key, size_t klen) {
+    size_t i;
+    assert(v != NULL && v->type == JSON_OBJECT && (key != NULL || klen == 0));
+    // Small objects are searched linearly, and so are borrowed ones that
+    // came without a table and have no arena to put one in: one from the
+    // heap would never be freed
+    if (v->u.o.size <= JSON_OBJECT_INDEX_THRESHOLD || v->u.o.size > UINT32_MAX
+        || (v->u.o.index == NULL && (v->flags & (JSON_FLAG_BORROWED | JSON_FLAG_ARENA)) == JSON_FLAG_BORROWED)) {
+        for (i = 0; i < v->u.o.size; i++)
+            if (v->u.o.m[i].klen == klen && (v->u.o.m[i].k == key || memcmp(v->u.o.m[i].k, key, klen) == 0))
+                return i;
+        return JSON_KEY_NOT_EXIST;
+    }
+    else {
+        json_object_index* x = v->u.o.index;
+        uint32_t h = json_hash_key(key, klen);
+        if (x == NULL) // Lazily built, the index is a cache and not part of the value
+            x = ((json_value*)v)->u.o.index = json_object_index_create(v,
+                v->flags & JSON_FLAG_ARENA ? JSON_ITEMS_ARENA(v->u.o.m) : NULL);
+        if (!x->filled)
+            json_object_index_fill(v, x);
+        for (i = h & x->mask; x->slots[i].index != 0; i = (i + 1) & x->mask) {
+            const json_member* m = &v->u.o.m[x->slots[i].index - 1];
+            if (x->slots[i].hash == h && m->klen == klen && (m->k == key || memcmp(m->k, key, klen) == 0))
+                return x->slots[i].index - 1;
+        }
+        return JSON_KEY_NOT_EXIST;
+    }
+}
+
+json_value* json_find_object_value(const json_value* v, const char* key, size_t klen) {
+    size_t i = json_find_object_index(v, key, klen);
+    return i != JSON_KEY_NOT_EXIST ? &v->u.o.m[i].v : NULL;
+}
 // Getter End
 
 // Setter Begin
@@ -392,13 +5524,355 @@ void json_set_number(json_value* v, double n) {
     v->type = JSON_NUMBER;
 }
 
+void json_set_int64(json_value* v, int64_t n) {
+    json_free(v);
+    v->u.i = n;
+    v->type = JSON_NUMBER;
+    v->flags = JSON_FLAG_INT64;
+}
+
+void json_set_uint64(json_value* v, uint64_t n) {
+    json_free(v);
+    v->u.ui = n;
+    v->type = JSON_NUMBER;
+    v->flags = JSON_FLAG_UINT64;
+}
+
 void json_set_string(json_value* v, const char* s, size_t len) {
     assert(v != NULL && (s != NULL || len == 0));
     json_free(v);
-    v->u.s.s = (char*)malloc(len + 1);
+    v->u.s.s = (char*)JSON_MALLOC(json_heap, len + 1);
     memcpy(v->u.s.s, s, len);
     v->u.s.s[len] = '\0';
     v->u.s.len = len;
     v->type = JSON_STRING;
 }
+
+void json_set_string_owned(json_value* v, char* s, size_t len) {
+    assert(v != NULL && s != NULL && s[len] == '\0');
+    json_free(v);
+    v->u.s.s = s;
+    v->u.s.len = len;
+    v->type = JSON_STRING;
+}
+
+void json_set_string_borrowed(json_value* v, const char* s, size_t len) {
+    assert(v != NULL && s != NULL && s[len] == '\0');
+    json_free(v);
+    v->u.s.s = (char*)s;
+    v->u.s.len = len;
+    v->type = JSON_STRING;
+    v->flags = JSON_FLAG_BORROWED;
+}
+
+char* json_take_string(json_value* v, size_t* len) {
+    char* s;
+    assert(v != NULL && v->type == JSON_STRING);
+    s = v->u.s.s;
+    if (len != NULL)
+        *len = v->u.s.len;
+    if (v->flags & JSON_FLAG_BORROWED) {
+        s = (char*)JSON_MALLOC(json_heap, v->u.s.len + 1);
+        memcpy(s, v->u.s.s, v->u.s.len + 1);
+    }
+    json_init(v);
+    return s;
+}
+
+void json_move(json_value* dst, json_value* src) {
+    json_value tmp;
+    assert(dst != NULL && src != NULL);
+    if (dst == src)
+        return;
+    // Detach src first, it may live inside dst
+    tmp = *src;
+    json_init(src);
+    json_free(dst);
+    *dst = tmp;
+}
+
+static void json_copy_value(json_value* dst, const json_value* src) {
+    size_t i;
+    switch (src->type) {
+        case JSON_STRING:
+            json_set_string(dst, src->u.s.s, src->u.s.len);
+            break;
+        case JSON_ARRAY:
+            dst->u.a.size = src->u.a.size;
+            dst->u.a.capacity = src->u.a.size;
+            dst->u.a.e = NULL;
+            if (src->u.a.size > 0)
+                dst->u.a.e = (json_value*)JSON_MALLOC(json_heap, src->u.a.size * sizeof(json_value));
+            for (i = 0; i < src->u.a.size; i++) {
+                json_init(&dst->u.a.e[i]);
+                json_copy_value(&dst->u.a.e[i], &src->u.a.e[i]);
+            }
+            dst->type = JSON_ARRAY;
+            dst->flags = 0;
+            break;
+        case JSON_OBJECT:
+            dst->u.o.size = src->u.o.size;
+            dst->u.o.capacity = src->u.o.size;
+            dst->u.o.m = NULL;
+            dst->u.o.index = NULL;
+            if (src->u.o.size > 0)
+                dst->u.o.m = (json_member*)JSON_MALLOC(json_heap, src->u.o.size * sizeof(json_member));
+            for (i = 0; i < src->u.o.size; i++) {
+                json_member* m = &dst->u.o.m[i];
+                m->klen = src->u.o.m[i].klen;
+                m->k = (char*)JSON_MALLOC(json_heap, m->klen + 1);
+                memcpy(m->k, src->u.o.m[i].k, m->klen + 1);
+                json_init(&m->v);
+                json_copy_value(&m->v, &src->u.o.m[i].v);
+            }
+            dst->type = JSON_OBJECT;
+            dst->flags = 0;
+            break;
+        default:
+            *dst = *src;
+            break;
+    }
+}
+
+void json_copy(json_value* dst, const json_value* src) {
+    json_value tmp;
+    assert(dst != NULL && src != NULL);
+    if (dst == src)
+        return;
+    // Copy before freeing, src may live inside dst
+    json_init(&tmp);
+    json_copy_value(&tmp, src);
+    json_free(dst);
+    *dst = tmp;
+}
+
+// Take e out of its place, or make a null when there is no e
+static void json_detach(json_value* tmp, json_value* e) {
+    if (e != NULL) {
+        *tmp = *e;
+        json_init(e);
+    }
+    else
+        json_init(tmp);
+}
+
+static size_t json_grow_capacity(size_t capacity, size_t need) {
+    if (capacity < JSON_CONTAINER_INIT_CAPACITY)
+        capacity = JSON_CONTAINER_INIT_CAPACITY;
+    while (capacity < need)
+        capacity += capacity >> 1;  /* capacity * 1.5 */
+    return capacity;
+}
+
+// Resize the element buffer. Arena storage moves to a larger block of its
+// arena, other borrowed storage is copied out.
+static void json_array_resize(json_value* v, size_t capacity) {
+    size_t size = v->u.a.size * sizeof(json_value);
+    if (v->flags & JSON_FLAG_ARENA) {
+        json_value* e = (json_value*)json_arena_items(JSON_ITEMS_ARENA(v->u.a.e), capacity * sizeof(json_value));
+        if (size > 0)
+            memcpy(e, v->u.a.e, size);
+        v->u.a.e = e;
+    }
+    else if (v->flags & JSON_FLAG_BORROWED) {
+        json_value* e = capacity > 0 ? (json_value*)JSON_MALLOC(json_heap, capacity * sizeof(json_value)) : NULL;
+        if (size > 0)
+            memcpy(e, v->u.a.e, size);
+        v->u.a.e = e;
+        v->flags &= ~JSON_FLAG_BORROWED;
+    }
+    else if (capacity == 0) {
+        JSON_FREE(json_heap, v->u.a.e);
+        v->u.a.e = NULL;
+    }
+    else
+        v->u.a.e = (json_value*)JSON_REALLOC(json_heap, v->u.a.e, capacity * sizeof(json_value));
+    v->u.a.capacity = capacity;
+}
+
+void json_set_array(json_value* v, size_t capacity) {
+    assert(v != NULL);
+    json_free(v);
+    v->u.a.e = capacity > 0 ? (json_value*)JSON_MALLOC(json_heap, capacity * sizeof(json_value)) : NULL;
+    v->u.a.size = 0;
+    v->u.a.capacity = capacity;
+    v->type = JSON_ARRAY;
+}
+
+void json_array_reserve(json_value* v, size_t capacity) {
+    assert(v != NULL && v->type == JSON_ARRAY);
+    if (v->u.a.capacity < capacity)
+        json_array_resize(v, capacity);
+}
+
+void json_array_shrink_to_fit(json_value* v) {
+    assert(v != NULL && v->type == JSON_ARRAY);
+    // Borrowed storage cannot be given back, only the count is dropped
+    if (v->flags & JSON_FLAG_BORROWED)
+        v->u.a.capacity = v->u.a.size;
+    else if (v->u.a.capacity > v->u.a.size)
+        json_array_resize(v, v->u.a.size);
+}
+
+json_value* json_array_push_back(json_value* v, json_value* e) {
+    assert(v != NULL && v->type == JSON_ARRAY);
+    return json_array_insert(v, v->u.a.size, e);
+}
+
+void json_array_pop_back(json_value* v) {
+    assert(v != NULL && v->type == JSON_ARRAY && v->u.a.size > 0);
+    json_free(&v->u.a.e[--v->u.a.size]);
+}
+
+json_value* json_array_insert(json_value* v, size_t index, json_value* e) {
+    json_value tmp;
+    assert(v != NULL && v->type == JSON_ARRAY && e != v);
+    assert(index <= v->u.a.size);
+    // Detach before growing, e may be one of the elements
+    json_detach(&tmp, e);
+    if (v->u.a.size == v->u.a.capacity)
+        json_array_resize(v, json_grow_capacity(v->u.a.capacity, v->u.a.size + 1));
+    memmove(&v->u.a.e[index + 1], &v->u.a.e[index], (v->u.a.size - index) * sizeof(json_value));
+    v->u.a.e[index] = tmp;
+    v->u.a.size++;
+    return &v->u.a.e[index];
+}
+
+void json_array_erase(json_value* v, size_t index, size_t count) {
+    size_t i;
+    assert(v != NULL && v->type == JSON_ARRAY);
+    assert(index <= v->u.a.size && count <= v->u.a.size - index);
+    if (count == 0)
+        return;
+    for (i = index; i < index + count; i++)
+        json_free(&v->u.a.e[i]);
+    memmove(&v->u.a.e[index], &v->u.a.e[index + count], (v->u.a.size - index - count) * sizeof(json_value));
+    v->u.a.size -= count;
+}
+
+void json_array_clear(json_value* v) {
+    assert(v != NULL && v->type == JSON_ARRAY);
+    json_array_erase(v, 0, v->u.a.size);
+}
+
+// Resize the member buffer as json_array_resize() does.
+// The index keeps member positions, so it stays valid.
+static void json_object_resize(json_value* v, size_t capacity) {
+    size_t size = v->u.o.size * sizeof(json_member);
+    if (v->flags & JSON_FLAG_ARENA) {
+        json_member* m = (json_member*)json_arena_items(JSON_ITEMS_ARENA(v->u.o.m), capacity * sizeof(json_member));
+        if (size > 0)
+            memcpy(m, v->u.o.m, size);
+        v->u.o.m = m;
+    }
+    else if (v->flags & JSON_FLAG_BORROWED) {
+        json_member* m = capacity > 0 ? (json_member*)JSON_MALLOC(json_heap, capacity * sizeof(json_member)) : NULL;
+        if (size > 0)
+            memcpy(m, v->u.o.m, size);
+        v->u.o.m = m;
+        v->flags &= ~JSON_FLAG_BORROWED;
+    }
+    else if (capacity == 0) {
+        JSON_FREE(json_heap, v->u.o.m);
+        v->u.o.m = NULL;
+    }
+    else
+        v->u.o.m = (json_member*)JSON_REALLOC(json_heap, v->u.o.m, capacity * sizeof(json_member));
+    v->u.o.capacity = capacity;
+}
+
+void json_set_object(json_value* v, size_t capacity) {
+    assert(v != NULL);
+    json_free(v);
+    v->u.o.m = capacity > 0 ? (json_member*)JSON_MALLOC(json_heap, capacity * sizeof(json_member)) : NULL;
+    v->u.o.size = 0;
+    v->u.o.capacity = capacity;
+    v->u.o.index = NULL;
+    v->type = JSON_OBJECT;
+}
+
+void json_object_reserve(json_value* v, size_t capacity) {
+    assert(v != NULL && v->type == JSON_OBJECT);
+    if (v->u.o.capacity < capacity)
+        json_object_resize(v, capacity);
+}
+
+void json_object_shrink_to_fit(json_value* v) {
+    assert(v != NULL && v->type == JSON_OBJECT);
+    if (v->flags & JSON_FLAG_BORROWED)
+        v->u.o.capacity = v->u.o.size;
+    else if (v->u.o.capacity > v->u.o.size)
+        json_object_resize(v, v->u.o.size);
+}
+
+json_value* json_object_set(json_value* v, const char* key, size_t klen, json_value* value) {
+    json_value tmp;
+    json_member* m;
+    char* k;
+    size_t i;
+    assert(v != NULL && v->type == JSON_OBJECT && value != v && (key != NULL || klen == 0));
+    json_detach(&tmp, value);
+    if ((i = json_find_object_index(v, key, klen)) != JSON_KEY_NOT_EXIST) {
+        json_free(&v->u.o.m[i].v);
+        v->u.o.m[i].v = tmp;
+        return &v->u.o.m[i].v;
+    }
+    // Copy the key before growing, it may be one of the keys. Arena objects
+    // keep every key in their arena.
+    if (v->flags & JSON_FLAG_ARENA)
+        k = (char*)json_arena_alloc(JSON_ITEMS_ARENA(v->u.o.m), klen + 1);
+    else
+        k = (char*)JSON_MALLOC(json_heap, klen + 1);
+    memcpy(k, key, klen);
+    k[klen] = '\0';
+    // Every key is owned or none is, so interned keys are copied once
+    if ((v->flags & (JSON_FLAG_KEYS_BORROWED | JSON_FLAG_ARENA)) == JSON_FLAG_KEYS_BORROWED) {
+        for (i = 0; i < v->u.o.size; i++) {
+            char* o = (char*)JSON_MALLOC(json_heap, v->u.o.m[i].klen + 1);
+            memcpy(o, v->u.o.m[i].k, v->u.o.m[i].klen + 1);
+            v->u.o.m[i].k = o;
+        }
+        v->flags &= ~JSON_FLAG_KEYS_BORROWED;
+    }
+    if (v->u.o.size == v->u.o.capacity)
+        json_object_resize(v, json_grow_capacity(v->u.o.capacity, v->u.o.size + 1));
+    m = &v->u.o.m[v->u.o.size++];
+    m->k = k;
+    m->klen = klen;
+    m->v = tmp;
+    if (v->u.o.index != NULL)
+        json_object_index_insert(v, v->u.o.size - 1);
+    return &m->v;
+}
+
+int json_object_remove(json_value* v, const char* key, size_t klen) {
+    size_t i = json_find_object_index(v, key, klen);
+    if (i == JSON_KEY_NOT_EXIST)
+        return 0;
+    json_object_erase(v, i, 1);
+    return 1;
+}
+
+void json_object_erase(json_value* v, size_t index, size_t count) {
+    size_t i;
+    assert(v != NULL && v->type == JSON_OBJECT);
+    assert(index <= v->u.o.size && count <= v->u.o.size - index);
+    if (count == 0)
+        return;
+    for (i = index; i < index + count; i++) {
+        if (!(v->flags & JSON_FLAG_KEYS_BORROWED))
+            JSON_FREE(json_heap, v->u.o.m[i].k);
+        json_free(&v->u.o.m[i].v);
+    }
+    memmove(&v->u.o.m[index], &v->u.o.m[index + count], (v->u.o.size - index - count) * sizeof(json_member));
+    v->u.o.size -= count;
+    // Members after index moved, the table is filled again on the next lookup
+    if (v->u.o.index != NULL)
+        v->u.o.index->filled = 0;
+}
+
+void json_object_clear(json_value* v) {
+    assert(v != NULL && v->type == JSON_OBJECT);
+    json_object_erase(v, 0, v->u.o.size);
+}
 // Setter End
\ No newline at end of file
@@ -2,11 +2,21 @@
 #define MY_JSON_H__
 
 #include <stddef.h> // size_t
+#include <stdint.h> // int64_t, uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef enum { JSON_NULL, JSON_FALSE, JSON_TRUE, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT } json_type;
 
+// Representation of a JSON_NUMBER, integers that fit are kept exactly.
+typedef enum { JSON_NUMBER_DOUBLE, JSON_NUMBER_INT64, JSON_NUMBER_UINT64 } json_number_type;
+
 typedef struct json_value json_value;
 typedef struct json_member json_member;
+typedef struct json_object_index json_object_index;
+typedef struct json_symbols json_symbols;
 
 struct json_value{
     // Use union to make sure that only one element exists(object, array, string, number).
@@ -15,11 +25,14 @@ struct json_value{
         struct {
             json_member* m; // Stores object
             size_t size;    // Indicate size of the object
+            size_t capacity; // Members u.o.m has room for
+            json_object_index* index; // Lazy key index, see json_find_object_index()
         } o;
         // array
         struct {
            json_value* e; // Stores array
            size_t size;   // Indicate size of the array
+           size_t capacity; // Elements u.a.e has room for
         } a;
         // string
         struct {
@@ -28,8 +41,11 @@ struct json_value{
         } s;
         // number
         double n;
+        int64_t i;
+        uint64_t ui;
     } u;
     json_type type;
+    unsigned flags; // Ownership and number bits, see JSON_FLAG_*
 };
 
 struct json_member {
@@ -49,13 +65,173 @@ enum {
     JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET,
     JSON_PARSE_MISS_KEY,
     JSON_PARSE_MISS_COLON,
-    JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET
+    JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET,
+    JSON_PARSE_NUMBER_TOO_BIG,
+    JSON_PARSE_ABORTED,
+    JSON_PARSE_IO_ERROR,
+    JSON_PARSE_DEPTH_EXCEEDED,
+    JSON_PARSE_SIZE_EXCEEDED,
+    JSON_PARSE_INVALID_UNICODE_HEX,
+    JSON_PARSE_INVALID_UNICODE_SURROGATE
+};
+
+// Bits kept in json_value::flags.
+// json_free() leaves storage alone when it is marked as borrowed.
+enum {
+    JSON_FLAG_BORROWED = 1,      // u.s.s, u.a.e or u.o.m is not owned by this value
+    JSON_FLAG_KEYS_BORROWED = 2, // Keys in u.o.m are not owned by this object
+    JSON_FLAG_INT64 = 4,         // Number is stored exactly in u.i
+    JSON_FLAG_UINT64 = 8,        // Number is stored exactly in u.ui
+    JSON_FLAG_ARENA = 16         // u.a.e or u.o.m is carved from an arena, growth stays there
 };
 
-#define json_init(v) do { (v)->type = JSON_NULL; } while(0)
+#define json_init(v) do { (v)->type = JSON_NULL; (v)->flags = 0; } while(0)
 #define json_set_null(v) json_free(v)
 
+// Allocator.
+// Values built by json_parse() and the setters, and stringify output, come
+// from the default allocator, since json_free() takes none. Parsers and
+// documents created with an allocator take everything from it instead: the
+// scratch stack, symbol slots and the arena their trees are carved from,
+// where the containers of those trees also grow and keys added to them go.
+// Such a tree goes away with its parser or document and needs no
+// json_free(), only values attached to it by setters use the default one.
+typedef struct {
+    void* (*malloc)(void* user, size_t size);
+    void* (*realloc)(void* user, void* p, size_t size); // p may be NULL
+    void (*free)(void* user, void* p);                  // p may be NULL
+    void* user;
+} json_allocator;
+
+// Replace the default allocator, NULL restores malloc(). Values allocated
+// before the switch must be freed before it, a must outlive its use.
+void json_set_allocator(const json_allocator* a);
+// Release a buffer the library handed out (json_stringify(), json_take_string(),
+// encoders) through the default allocator, the one installed above.
+void json_free_buffer(void* p);
+
+// Counts what goes through it, then forwards to next (NULL for malloc()).
+// reallocs counts calls that grow an existing block, during a parse that is
+// the scratch stack growing. Not thread-safe.
+typedef struct {
+    json_allocator allocator; // Pass &c.allocator
+    const json_allocator* next;
+    size_t count;    // malloc() and realloc() calls
+    size_t bytes;    // Total bytes requested by them
+    size_t current;  // Bytes live now
+    size_t peak;     // Highest current seen
+    size_t reallocs; // realloc() calls on a non-NULL block
+} json_counting_allocator;
+
+void json_counting_allocator_init(json_counting_allocator* c, const json_allocator* next);
+
+// Strings are decoded to UTF-8, escapes and surrogate pairs included, and
+// have to be valid UTF-8 in the input, JSON_PARSE_INVALID_STRING_CHAR
+// otherwise. An escaped \u0000 stays in the string, use its length.
 int json_parse(json_value* v, const char* json);
+// Parse exactly len bytes, json need not be NUL-terminated.
+// Large inputs that are mostly whitespace, such as pretty-printed files,
+// are first indexed with SIMD so that stage 2 never reads the indentation.
+// The tree and any error are the same either way.
+int json_parse_n(json_value* v, const char* json, size_t len);
+// Parse a file through a read-only memory mapping, without copying it.
+int json_parse_file(json_value* v, const char* path);
+
+// Destructive parse: strings and keys are decoded in place inside buf and
+// point into it, so buf must outlive v. buf content is unspecified on failure.
+int json_parse_insitu(json_value* v, char* buf);
+
+// Parse with object keys interned in a shared symbol table: equal keys,
+// within this parse and across parses with the same table, point to one
+// buffer, so they also compare equal as pointers. Keys are owned by the
+// table, which must outlive v. json_free(v) leaves them alone.
+int json_parse_interned(json_value* v, const char* json, json_symbols* symbols);
+
+json_symbols* json_symbols_create(void);
+void json_symbols_destroy(json_symbols* symbols);
+size_t json_symbols_size(const json_symbols* symbols);
+// Canonical NUL-terminated copy of s, the same pointer for every equal s.
+const char* json_symbols_intern(json_symbols* symbols, const char* s, size_t len);
+
+// Stringify flags
+enum {
+    JSON_STRINGIFY_PRETTY = 1 // Newlines and 4-space indentation
+};
+
+// Compact JSON text of v, NUL-terminated, free with json_free_buffer().
+// length (optional) receives the size without the terminator.
+char* json_stringify(const json_value* v, size_t* length);
+// Write into a caller-owned buffer of *size bytes from the default allocator,
+// grown with it when needed, so a reused buffer stops allocating once warm.
+// *buf may start as NULL. Returns the length without the terminator.
+size_t json_stringify_to(const json_value* v, char** buf, size_t* size, int flags);
+
+// CBOR (RFC 8949) form of a value, for caches of parsed documents.
+// Strings carry their length and numbers keep their json_number_type, so
+// decoding scans no text and reproduces what json_parse() built. Only
+// definite-length items that map onto json_value are decoded, anything
+// else fails with JSON_PARSE_INVALID_VALUE, a non-text key with
+// JSON_PARSE_MISS_KEY, text that is not UTF-8 with
+// JSON_PARSE_INVALID_STRING_CHAR. Buffers behave as with json_stringify_to(), without
+// a terminator.
+size_t json_cbor_encode_to(const json_value* v, char** buf, size_t* size);
+char* json_cbor_encode(const json_value* v, size_t* length);
+int json_cbor_decode(json_value* v, const void* data, size_t len);
+
+// Field projection.
+// A set of JSON Pointer paths (RFC 6901, "" is the whole document) where a
+// "*" token matches every array element and every member. The parse builds
+// only what the paths reach: matched subtrees in full, and the containers
+// on the way to them, even empty ones, holding only the children on a path
+// in document order. A numeric token keeps just that element, so indexes
+// in the result are not those of the input. Everything else is skipped
+// without allocating; skipped strings and containers are only checked for
+// termination.
+typedef struct json_projection json_projection;
+
+// NULL when a path neither is empty nor starts with '/', or has a '~' not
+// followed by '0' or '1'.
+json_projection* json_projection_create(const char* const* paths, size_t count);
+void json_projection_destroy(json_projection* p);
+int json_parse_projected(json_value* v, const char* json, size_t len, const json_projection* p);
+
+// Relocatable snapshot.
+// One position-independent image of a value, offsets instead of pointers,
+// so opening it maps the file and builds nothing: json_snapshot_open() is
+// O(1) in the image size and pages are read on first touch. The mapping is
+// shared and read-only, processes opening the same image share the page
+// cache. Nodes are byte offsets into the image, array elements are O(1) and
+// objects large enough carry a hash index for find. Only the header is
+// checked on open, images must come from json_snapshot_write() on a machine
+// of the same byte order; a mismatching one is refused with NULL.
+typedef struct json_snapshot json_snapshot;
+
+// Image in one default-allocator buffer.
+char* json_snapshot_encode(const json_value* v, size_t* length);
+// JSON_PARSE_OK or JSON_PARSE_IO_ERROR.
+int json_snapshot_write(const json_value* v, const char* path);
+json_snapshot* json_snapshot_open(const char* path);
+// View over an image in memory, 8-byte aligned, which must outlive it.
+json_snapshot* json_snapshot_open_buffer(const void* image, size_t len);
+void json_snapshot_close(json_snapshot* s);
+
+size_t json_snapshot_root(const json_snapshot* s);
+json_type json_snapshot_get_type(const json_snapshot* s, size_t node);
+json_number_type json_snapshot_get_number_type(const json_snapshot* s, size_t node);
+double json_snapshot_get_number(const json_snapshot* s, size_t node);
+int64_t json_snapshot_get_int64(const json_snapshot* s, size_t node);
+uint64_t json_snapshot_get_uint64(const json_snapshot* s, size_t node);
+int json_snapshot_get_boolean(const json_snapshot* s, size_t node);
+const char* json_snapshot_get_string(const json_snapshot* s, size_t node);
+size_t json_snapshot_get_string_length(const json_snapshot* s, size_t node);
+size_t json_snapshot_get_array_size(const json_snapshot* s, size_t node);
+size_t json_snapshot_get_array_element(const json_snapshot* s, size_t node, size_t index);
+size_t json_snapshot_get_object_size(const json_snapshot* s, size_t node);
+const char* json_snapshot_get_object_key(const json_snapshot* s, size_t node, size_t index);
+size_t json_snapshot_get_object_key_length(const json_snapshot* s, size_t node, size_t index);
+size_t json_snapshot_get_object_value(const json_snapshot* s, size_t node, size_t index);
+// Index of the first member named key, or JSON_KEY_NOT_EXIST.
+size_t json_snapshot_find_object_index(const json_snapshot* s, size_t node, const char* key, size_t klen);
 
 void json_free(json_value* v);
 
@@ -64,19 +240,232 @@ json_type json_get_type(const json_value* v);
 int json_get_boolean(const json_value* v);
 void json_set_boolean(json_value* v, int b);
 
+json_number_type json_get_number_type(const json_value* v);
 double json_get_number(const json_value* v);
 void json_set_number(json_value* v, double n);
+int64_t json_get_int64(const json_value* v);
+void json_set_int64(json_value* v, int64_t n);
+uint64_t json_get_uint64(const json_value* v);
+void json_set_uint64(json_value* v, uint64_t n);
 
 const char* json_get_string(const json_value* v);
 size_t json_get_string_length(const json_value* v);
 void json_set_string(json_value* v, const char* s, size_t len);
+// Take ownership of s, s[len] == '\0', a buffer from the allocator installed
+// with json_set_allocator() (malloc() unless one was), since that is what
+// json_free() releases it with.
+void json_set_string_owned(json_value* v, char* s, size_t len);
+// Point at s without copying, s[len] == '\0' and s must outlive v.
+void json_set_string_borrowed(json_value* v, const char* s, size_t len);
+// Hand the string buffer over to the caller, who frees it with the allocator
+// installed with json_set_allocator(), e.g. by json_free_buffer(), and leave
+// v null. A borrowed string is copied first.
+char* json_take_string(json_value* v, size_t* len);
 
+// Move src into dst without copying, src is left null. src may be inside
+// dst, e.g. to replace a value with one of its children.
+void json_move(json_value* dst, json_value* src);
+// Deep copy, the copy owns all of its storage. src may be inside dst.
+void json_copy(json_value* dst, const json_value* src);
+
+// Arrays and objects grow geometrically, so n appends cost O(n) amortized.
+// Values passed in are moved, not copied, and left null; they may live
+// inside the container itself. Containers parsed into an arena (a
+// json_document, a parser's arena) grow inside it, keys added to them
+// too, and still need no json_free(). Other borrowed storage is copied to
+// the default allocator on the first change that needs room.
+void json_set_array(json_value* v, size_t capacity);
 size_t json_get_array_size(const json_value* v);
+size_t json_get_array_capacity(const json_value* v);
 json_value* json_get_array_element(const json_value* v, size_t index);
+void json_array_reserve(json_value* v, size_t capacity);
+void json_array_shrink_to_fit(json_value* v);
+// Append e, or null when e is NULL, and return the new element.
+json_value* json_array_push_back(json_value* v, json_value* e);
+void json_array_pop_back(json_value* v);
+// Insert e, or null when e is NULL, before index and return it.
+json_value* json_array_insert(json_value* v, size_t index, json_value* e);
+// Remove count elements starting at index.
+void json_array_erase(json_value* v, size_t index, size_t count);
+void json_array_clear(json_value* v);
 
+void json_set_object(json_value* v, size_t capacity);
 size_t json_get_object_size(const json_value* v);
+size_t json_get_object_capacity(const json_value* v);
 const char* json_get_object_key(const json_value* v, size_t index);
 size_t json_get_object_key_length(const json_value* v, size_t index);
 json_value* json_get_object_value(const json_value* v, size_t index);
+void json_object_reserve(json_value* v, size_t capacity);
+void json_object_shrink_to_fit(json_value* v);
+// Replace the value of key, or append a member with a copy of key, and
+// return the value. A NULL value sets null. Appending keeps the hash index
+// up to date, removing members has the next lookup refill it.
+json_value* json_object_set(json_value* v, const char* key, size_t klen, json_value* value);
+// Remove the first member with key, return 0 when there is none.
+int json_object_remove(json_value* v, const char* key, size_t klen);
+void json_object_erase(json_value* v, size_t index, size_t count);
+void json_object_clear(json_value* v);
+
+#define JSON_KEY_NOT_EXIST ((size_t)-1)
+
+// Key lookup, the first member with a matching key wins.
+// Large objects build a hash index on the first lookup, so concurrent
+// lookups on the same object need external synchronization. Objects parsed
+// into an arena (json_document, json_parser_use_arena()) have it reserved
+// in the arena during the parse, so lookups on them never allocate; those
+// grown large later take it from the same arena.
+size_t json_find_object_index(const json_value* v, const char* key, size_t klen);
+json_value* json_find_object_value(const json_value* v, const char* key, size_t klen);
+
+// SAX handler, every callback is optional.
+// Callbacks return 0 to continue, anything else stops the parse, which then
+// returns JSON_PARSE_ABORTED. Strings and keys are NUL-terminated and only
+// valid during the call, numbers are passed as a JSON_NUMBER value.
+typedef struct {
+    int (*on_null)(void* user);
+    int (*on_bool)(void* user, int b);
+    int (*on_number)(void* user, const json_value* n);
+    int (*on_string)(void* user, const char* s, size_t len);
+    int (*on_key)(void* user, const char* k, size_t klen);
+    int (*on_start_object)(void* user);
+    int (*on_end_object)(void* user, size_t size);
+    int (*on_start_array)(void* user);
+    int (*on_end_array)(void* user, size_t size);
+} json_handler;
+
+// Stream events of json to h without building a tree, user is passed through.
+int json_parse_sax(const char* json, const json_handler* h, void* user);
+// Same on exactly len bytes, json need not be NUL-terminated.
+int json_parse_sax_n(const char* json, size_t len, const json_handler* h, void* user);
+
+// Incremental push parser.
+// Feed the document in chunks of any size, boundaries may fall anywhere,
+// even inside a token. finish() moves the result into v and makes the
+// parser ready for the next document. After an error, feed() keeps
+// returning it until finish().
+typedef struct json_parser json_parser;
+
+json_parser* json_parser_create(void);
+// The parser itself, its stack and its arena come from a (NULL for default).
+// With an allocator the arena is always on, so results come from a too.
+json_parser* json_parser_create_with(const json_allocator* a);
+void json_parser_destroy(json_parser* p);
+int json_parser_feed(json_parser* p, const char* chunk, size_t len);
+int json_parser_finish(json_parser* p, json_value* v);
+
+// One-shot parse of len bytes through the parser, dropping any document
+// being fed. The scratch stack keeps the capacity it grew to, so repeated
+// small parses do not allocate it again.
+int json_parser_parse(json_parser* p, json_value* v, const char* json, size_t len);
+// Policy for both parse() and feed(), 0 means unlimited. Deeper nesting
+// fails with JSON_PARSE_DEPTH_EXCEEDED, more than max_size input bytes per
+// document with JSON_PARSE_SIZE_EXCEEDED.
+void json_parser_set_limits(json_parser* p, size_t max_depth, size_t max_size);
+// When enabled, parse() and the documents fed from then on carve their
+// values out of an arena owned by the parser, rewound when the next document
+// starts (parse() or its first feed()), so a value is only valid until then.
+// Such values need no json_free(). Parsers with an allocator ignore 0.
+void json_parser_use_arena(json_parser* p, int enable);
+
+// Arena-backed document.
+// Every node, key and string of a parse is carved out of chunks owned by the
+// document, so the whole tree is released at once by reset or destroy.
+// Keys are interned per parse, each distinct key is stored once.
+// Reset keeps the chunks, a long-running worker can reuse them per request.
+// Values inside a document must not outlive it, and heap storage attached to
+// them by setters has to be released with json_free() before reset.
+typedef struct json_document json_document;
+
+json_document* json_document_create(void);
+// The document itself, its chunks and its key table come from a.
+json_document* json_document_create_with(const json_allocator* a);
+void json_document_destroy(json_document* d);
+void json_document_reset(json_document* d);
+int json_document_parse(json_document* d, const char* json);
+json_value* json_document_root(json_document* d);
+
+// Read-only flat document.
+// The whole parse is one array of 64-bit words plus one string buffer, a
+// node is a word index. Containers record where their subtree ends, so
+// json_tape_next() steps over any subtree in O(1); element and member
+// access by index walks the siblings before it. Object children alternate
+// key and value: from a key node k the value is at k + 2. Node indices and
+// string pointers stay valid until the next parse or destroy.
+typedef struct json_tape json_tape;
+
+json_tape* json_tape_create(void);
+void json_tape_destroy(json_tape* t);
+int json_tape_parse(json_tape* t, const char* json);
+size_t json_tape_root(const json_tape* t);
+size_t json_tape_next(const json_tape* t, size_t node);  // Next sibling
+size_t json_tape_child(const json_tape* t, size_t node); // First element or key
+
+json_type json_tape_get_type(const json_tape* t, size_t node);
+json_number_type json_tape_get_number_type(const json_tape* t, size_t node);
+double json_tape_get_number(const json_tape* t, size_t node);
+int64_t json_tape_get_int64(const json_tape* t, size_t node);
+uint64_t json_tape_get_uint64(const json_tape* t, size_t node);
+int json_tape_get_boolean(const json_tape* t, size_t node);
+const char* json_tape_get_string(const json_tape* t, size_t node);
+size_t json_tape_get_string_length(const json_tape* t, size_t node);
+size_t json_tape_get_array_size(const json_tape* t, size_t node);
+size_t json_tape_get_array_element(const json_tape* t, size_t node, size_t index);
+size_t json_tape_get_object_size(const json_tape* t, size_t node);
+const char* json_tape_get_object_key(const json_tape* t, size_t node, size_t index);
+size_t json_tape_get_object_key_length(const json_tape* t, size_t node, size_t index);
+size_t json_tape_get_object_value(const json_tape* t, size_t node, size_t index);
+
+// On-demand view of a JSON text, which is read in place and never copied.
+// json_lazy_parse() only checks that strings close and brackets balance.
+// The rest of the grammar is checked where the input is actually touched:
+// by json_lazy_next() on the containers it walks and by
+// json_lazy_get_value() on the value it decodes. Siblings that are passed
+// over are skipped by bracket matching, without decoding them.
+typedef struct {
+    const char* json; // First byte of the value
+    const char* end;  // End of the whole input
+} json_lazy;
+
+typedef struct {
+    const char* p;
+    const char* end;
+    char close;       // Closing bracket, '\0' once finished
+    int first;
+    int error;        // Why json_lazy_next() stopped, JSON_PARSE_OK at the end
+} json_lazy_iter;
+
+int json_lazy_parse(json_lazy* v, const char* json, size_t len);
+json_type json_lazy_get_type(const json_lazy* v);
+// Decode v, with its whole subtree, so the usual getters apply to out.
+int json_lazy_get_value(const json_lazy* v, json_value* out);
+
+// Walk an array or object: next() returns 1 per element, key receives the
+// member key string (it may be NULL for arrays), and 0 when done.
+void json_lazy_iterate(const json_lazy* v, json_lazy_iter* it);
+int json_lazy_next(json_lazy_iter* it, json_lazy* key, json_lazy* value);
+// 1 and the value when found, 0 when missing or malformed.
+int json_lazy_find(const json_lazy* v, const char* key, size_t klen, json_lazy* value);
+int json_lazy_index(const json_lazy* v, size_t index, json_lazy* value);
+
+// Newline-delimited JSON, one value per line, blank lines are skipped.
+// The callback runs on worker threads, concurrently, and in no particular
+// order: line is the 0-based line number of the record, ret its parse
+// result. v lives in the worker's arena and is only valid during the call,
+// it must not be freed. A non-zero return stops the remaining lines, other
+// workers only finish a call they are already in, and json_parse_ndjson()
+// returns JSON_PARSE_ABORTED, otherwise JSON_PARSE_OK.
+// nthreads <= 0 uses one thread per online CPU.
+typedef int (*json_ndjson_callback)(void* user, size_t line, int ret, json_value* v);
+
+int json_parse_ndjson(const char* buf, size_t len, int nthreads, json_ndjson_callback cb, void* user);
+
+// Same result as json_parse_n(). A large top-level array is split at element
+// boundaries and its parts are parsed on up to nthreads threads (<= 0: one
+// per online CPU). Small inputs and other values are parsed serially.
+int json_parse_parallel(json_value* v, const char* json, size_t len, int nthreads);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* MY_JSON_H__ */
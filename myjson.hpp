@@ -0,0 +1,535 @@
+#ifndef MY_JSON_HPP__
+#define MY_JSON_HPP__
+
+// C++17 binding of JSON objects onto user types.
+//
+// Describe a struct once with its field descriptors:
+//
+//     struct request { int64_t id; std::string method; std::vector<double> params; };
+//     template <> struct myjson::fields<request> {
+//         static constexpr auto value = std::make_tuple(
+//             MYJSON_FIELD(request, id), MYJSON_FIELD(request, method), MYJSON_FIELD(request, params));
+//     };
+//
+// then myjson::parse(text, r) fills r straight from the SAX events of
+// json_parse_sax(), no json_value is built. Supported members are bool,
+// integers, floating point, std::string, std::vector, std::optional and
+// other described structs. Keys are dispatched through a perfect hash
+// computed at compile time from the descriptors; unknown keys are skipped
+// and missing ones leave their member as it was.
+//
+// myjson::value below wraps a json_value for use from C++.
+
+#include "myjson.h"
+#include <array>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace myjson {
+
+// A value of the wrong JSON type or out of range for its member.
+constexpr int PARSE_TYPE_MISMATCH = -1;
+
+template <class C, class M>
+struct field_t {
+    std::string_view name;
+    M C::*member;
+};
+
+template <class C, class M>
+constexpr field_t<C, M> field(std::string_view name, M C::*member) {
+    return field_t<C, M>{ name, member };
+}
+
+#define MYJSON_FIELD(type, name) ::myjson::field(#name, &type::name)
+
+// Specialize with a constexpr tuple of field() descriptors named value.
+template <class T>
+struct fields;
+
+namespace detail {
+
+// Where the next value goes: a target object and how to fill it.
+struct ops;
+struct frame {
+    void* obj;
+    const ops* vt;
+};
+
+struct event {
+    json_type type;
+    const json_value* n;
+    const char* s;
+    size_t len;
+};
+
+// Every callback returns 0 to go on and non-zero on a mismatch.
+struct ops {
+    // Called with the type of every value before it is delivered, may
+    // redirect f, e.g. an optional to its emplaced payload.
+    int (*begin)(frame* f, json_type type);
+    int (*scalar)(void* obj, const event& e);
+    int (*key)(void* obj, const char* k, size_t klen, frame* next);
+    int (*element)(void* obj, frame* next);
+};
+
+template <class T, class = void>
+struct binder;
+
+template <class T>
+frame frame_of(T* obj) {
+    return frame{ obj, &binder<T>::vt };
+}
+
+// Swallows whatever it gets, for unknown keys and null optionals.
+struct skip {
+    static int begin(frame*, json_type) { return 0; }
+    static int scalar(void*, const event&) { return 0; }
+    static int key(void*, const char*, size_t, frame* next) { *next = frame{ nullptr, &vt }; return 0; }
+    static int element(void*, frame* next) { *next = frame{ nullptr, &vt }; return 0; }
+    static constexpr ops vt = { begin, scalar, key, element };
+};
+
+template <>
+struct binder<bool> {
+    static int begin(frame*, json_type type) { return type != JSON_TRUE && type != JSON_FALSE; }
+    static int scalar(void* obj, const event& e) {
+        *static_cast<bool*>(obj) = e.type == JSON_TRUE;
+        return 0;
+    }
+    static constexpr ops vt = { begin, scalar, nullptr, nullptr };
+};
+
+template <class T>
+struct binder<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>> {
+    static int begin(frame*, json_type type) { return type != JSON_NUMBER; }
+    static int scalar(void* obj, const event& e) {
+        using limits = std::numeric_limits<T>;
+        switch (json_get_number_type(e.n)) {
+            case JSON_NUMBER_INT64: {
+                int64_t i = json_get_int64(e.n);
+                if (limits::is_signed ? i < (int64_t)limits::min() || i > (int64_t)limits::max()
+                                      : i < 0 || (uint64_t)i > (uint64_t)limits::max())
+                    return 1;
+                *static_cast<T*>(obj) = (T)i;
+                return 0;
+            }
+            case JSON_NUMBER_UINT64: {
+                uint64_t u = json_get_uint64(e.n);
+                if (u > (uint64_t)limits::max())
+                    return 1;
+                *static_cast<T*>(obj) = (T)u;
+                return 0;
+            }
+            default:
+                return 1;
+        }
+    }
+    static constexpr ops vt = { begin, scalar, nullptr, nullptr };
+};
+
+template <class T>
+struct binder<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+    static int begin(frame*, json_type type) { return type != JSON_NUMBER; }
+    static int scalar(void* obj, const event& e) {
+        *static_cast<T*>(obj) = (T)json_get_number(e.n);
+        return 0;
+    }
+    static constexpr ops vt = { begin, scalar, nullptr, nullptr };
+};
+
+template <>
+struct binder<std::string> {
+    static int begin(frame*, json_type type) { return type != JSON_STRING; }
+    static int scalar(void* obj, const event& e) {
+        static_cast<std::string*>(obj)->assign(e.s, e.len);
+        return 0;
+    }
+    static constexpr ops vt = { begin, scalar, nullptr, nullptr };
+};
+
+template <class T>
+struct binder<std::vector<T>> {
+    static int begin(frame* f, json_type type) {
+        if (type != JSON_ARRAY)
+            return 1;
+        static_cast<std::vector<T>*>(f->obj)->clear();
+        return 0;
+    }
+    // The previous element is complete by now, growing cannot move a target
+    static int element(void* obj, frame* next) {
+        *next = frame_of(&static_cast<std::vector<T>*>(obj)->emplace_back());
+        return 0;
+    }
+    static constexpr ops vt = { begin, nullptr, nullptr, element };
+};
+
+template <class T>
+struct binder<std::optional<T>> {
+    static int begin(frame* f, json_type type) {
+        std::optional<T>* o = static_cast<std::optional<T>*>(f->obj);
+        if (type == JSON_NULL) {
+            o->reset();
+            *f = frame{ nullptr, &skip::vt };
+            return 0;
+        }
+        *f = frame_of(&o->emplace());
+        return f->vt->begin(f, type);
+    }
+    static constexpr ops vt = { begin, nullptr, nullptr, nullptr };
+};
+
+// FNV-1a with a seed, so the compiler can search for a collision-free one.
+constexpr uint32_t hash(const char* s, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+// Perfect hash of the names: a seed and a power-of-two table where
+// every name lands in its own slot, which holds its index + 1.
+template <size_t N, size_t Size>
+struct perfect_hash {
+    uint32_t seed = 0;
+    std::array<unsigned short, Size> slots{};
+};
+
+template <size_t Size, size_t N>
+constexpr bool perfect_hash_try(const std::array<std::string_view, N>& names, perfect_hash<N, Size>& p) {
+    for (size_t i = 0; i < Size; i++)
+        p.slots[i] = 0;
+    for (size_t i = 0; i < N; i++) {
+        size_t j = hash(names[i].data(), names[i].size(), p.seed) & (Size - 1);
+        if (p.slots[j] != 0)
+            return false;
+        p.slots[j] = (unsigned short)(i + 1);
+    }
+    return true;
+}
+
+template <size_t Size, size_t N>
+constexpr perfect_hash<N, Size> perfect_hash_build(const std::array<std::string_view, N>& names) {
+    perfect_hash<N, Size> p;
+    for (p.seed = 0; !perfect_hash_try<Size>(names, p); p.seed++)
+        ;
+    return p;
+}
+
+// Table size with room for the search to succeed quickly.
+constexpr size_t perfect_hash_size(size_t n) {
+    size_t size = 1;
+    while (size < n * 4)
+        size <<= 1;
+    return size;
+}
+
+template <class T>
+struct binder<T, std::void_t<decltype(fields<T>::value)>> {
+    static constexpr auto& descriptors = fields<T>::value;
+    static constexpr size_t count = std::tuple_size<std::decay_t<decltype(descriptors)>>::value;
+    static_assert(count < 65535, "too many fields");
+
+    template <size_t... I>
+    static constexpr std::array<std::string_view, count> make_names(std::index_sequence<I...>) {
+        return { { std::get<I>(descriptors).name... } };
+    }
+    static constexpr std::array<std::string_view, count> names = make_names(std::make_index_sequence<count>());
+    static constexpr size_t size = perfect_hash_size(count);
+    static constexpr perfect_hash<count, size> table = perfect_hash_build<size>(names);
+
+    template <size_t I>
+    static frame member(void* obj) {
+        return frame_of(&(static_cast<T*>(obj)->*std::get<I>(descriptors).member));
+    }
+    template <size_t... I>
+    static constexpr std::array<frame (*)(void*), count> make_members(std::index_sequence<I...>) {
+        return { { &member<I>... } };
+    }
+    static constexpr std::array<frame (*)(void*), count> members = make_members(std::make_index_sequence<count>());
+
+    static int begin(frame*, json_type type) { return type != JSON_OBJECT; }
+    static int key(void* obj, const char* k, size_t klen, frame* next) {
+        unsigned i = count > 0 ? table.slots[hash(k, klen, table.seed) & (size - 1)] : 0;
+        if (i != 0 && names[i - 1].size() == klen && std::memcmp(names[i - 1].data(), k, klen) == 0)
+            *next = members[i - 1](obj);
+        else
+            *next = frame{ nullptr, &skip::vt };
+        return 0;
+    }
+    static constexpr ops vt = { begin, nullptr, key, nullptr };
+};
+
+// SAX driver: the stack holds the open containers, pending the target of
+// the value following a key.
+struct state {
+    struct level {
+        frame f;
+        int array;
+    };
+    std::vector<level> stack;
+    frame root, pending;
+    int mismatch = 0;
+
+    static state* of(void* user) { return static_cast<state*>(user); }
+
+    // Target of the next value, begun with its type.
+    int next(json_type type, frame* f) {
+        if (stack.empty())
+            *f = root;
+        else if (stack.back().array) {
+            if (stack.back().f.vt->element(stack.back().f.obj, f) != 0)
+                return mismatch = 1;
+        }
+        else
+            *f = pending;
+        return mismatch = f->vt->begin(f, type);
+    }
+
+    int scalar(const event& e) {
+        frame f;
+        if (next(e.type, &f) != 0)
+            return 1;
+        return mismatch = f.vt->scalar(f.obj, e);
+    }
+
+    int open(json_type type) {
+        frame f;
+        if (next(type, &f) != 0)
+            return 1;
+        stack.push_back(level{ f, type == JSON_ARRAY });
+        return 0;
+    }
+
+    static int on_null(void* u) { return of(u)->scalar(event{ JSON_NULL, nullptr, nullptr, 0 }); }
+    static int on_bool(void* u, int b) { return of(u)->scalar(event{ b ? JSON_TRUE : JSON_FALSE, nullptr, nullptr, 0 }); }
+    static int on_number(void* u, const json_value* n) { return of(u)->scalar(event{ JSON_NUMBER, n, nullptr, 0 }); }
+    static int on_string(void* u, const char* s, size_t len) { return of(u)->scalar(event{ JSON_STRING, nullptr, s, len }); }
+    static int on_key(void* u, const char* k, size_t klen) {
+        state* s = of(u);
+        return s->mismatch = s->stack.back().f.vt->key(s->stack.back().f.obj, k, klen, &s->pending);
+    }
+    static int on_start_object(void* u) { return of(u)->open(JSON_OBJECT); }
+    static int on_start_array(void* u) { return of(u)->open(JSON_ARRAY); }
+    static int on_end(void* u, size_t) {
+        of(u)->stack.pop_back();
+        return 0;
+    }
+};
+
+} // namespace detail
+
+// Fill out from json, which need not be NUL-terminated. Returns
+// JSON_PARSE_OK, a JSON_PARSE_* error or PARSE_TYPE_MISMATCH; out may be
+// partly filled on failure.
+template <class T>
+int parse(std::string_view json, T& out) {
+    static const json_handler h = {
+        detail::state::on_null, detail::state::on_bool, detail::state::on_number, detail::state::on_string,
+        detail::state::on_key, detail::state::on_start_object, detail::state::on_end,
+        detail::state::on_start_array, detail::state::on_end
+    };
+    detail::state s;
+    int ret;
+    s.root = detail::frame_of(&out);
+    ret = json_parse_sax_n(json.data(), json.size(), &h, &s);
+    return ret == JSON_PARSE_ABORTED && s.mismatch ? PARSE_TYPE_MISMATCH : ret;
+}
+
+template <class T>
+int parse(const char* json, T& out) {
+    return parse(std::string_view(json), out);
+}
+
+// RAII wrapper.
+// myjson::value owns a json_value and frees it on destruction. It is
+// move-only, clone() is the explicit deep copy. myjson::view is a
+// non-owning read-only handle on any json_value, e.g. an element of a
+// value; it must not outlive what it points at. Both share the getters
+// below, strings come back as std::string_view without copying.
+class view;
+
+struct member {
+    std::string_view key;
+    const json_value* value;
+};
+
+template <class T, class Item>
+class iterator {
+public:
+    explicit iterator(const T* p) : p_(p) {}
+    Item operator*() const;
+    iterator& operator++() {
+        ++p_;
+        return *this;
+    }
+    bool operator==(const iterator& o) const { return p_ == o.p_; }
+    bool operator!=(const iterator& o) const { return p_ != o.p_; }
+
+private:
+    const T* p_;
+};
+
+template <class It>
+struct range {
+    It b, e;
+    It begin() const { return b; }
+    It end() const { return e; }
+};
+
+template <class D>
+class accessors {
+public:
+    json_type type() const { return json_get_type(raw()); }
+    bool is_null() const { return type() == JSON_NULL; }
+    bool get_bool() const { return json_get_boolean(raw()) != 0; }
+    json_number_type number_type() const { return json_get_number_type(raw()); }
+    double get_number() const { return json_get_number(raw()); }
+    int64_t get_int64() const { return json_get_int64(raw()); }
+    uint64_t get_uint64() const { return json_get_uint64(raw()); }
+    std::string_view get_string() const {
+        return std::string_view(json_get_string(raw()), json_get_string_length(raw()));
+    }
+
+    // Elements of an array or members of an object.
+    size_t size() const {
+        return type() == JSON_ARRAY ? json_get_array_size(raw()) : json_get_object_size(raw());
+    }
+    view operator[](size_t index) const;
+    std::optional<view> find(std::string_view key) const;
+    range<iterator<json_value, view>> elements() const;
+    range<iterator<json_member, member>> members() const;
+
+    std::string stringify() const {
+        size_t len;
+        char* s = json_stringify(raw(), &len);
+        std::string r(s, len);
+        json_free_buffer(s);
+        return r;
+    }
+
+private:
+    const json_value* raw() const { return static_cast<const D*>(this)->get(); }
+};
+
+class view : public accessors<view> {
+public:
+    explicit view(const json_value* v) : v_(v) {}
+    const json_value* get() const { return v_; }
+
+private:
+    const json_value* v_;
+};
+
+template <>
+inline view iterator<json_value, view>::operator*() const {
+    return view(p_);
+}
+
+template <>
+inline member iterator<json_member, member>::operator*() const {
+    return member{ std::string_view(p_->k, p_->klen), &p_->v };
+}
+
+template <class D>
+view accessors<D>::operator[](size_t index) const {
+    return view(json_get_array_element(raw(), index));
+}
+
+template <class D>
+std::optional<view> accessors<D>::find(std::string_view key) const {
+    const json_value* v = json_find_object_value(raw(), key.data(), key.size());
+    return v != nullptr ? std::optional<view>(view(v)) : std::nullopt;
+}
+
+template <class D>
+range<iterator<json_value, view>> accessors<D>::elements() const {
+    const json_value* e = json_get_array_size(raw()) > 0 ? json_get_array_element(raw(), 0) : nullptr;
+    return { iterator<json_value, view>(e), iterator<json_value, view>(e + json_get_array_size(raw())) };
+}
+
+template <class D>
+range<iterator<json_member, member>> accessors<D>::members() const {
+    const json_member* m = json_get_object_size(raw()) > 0 ? raw()->u.o.m : nullptr;
+    return { iterator<json_member, member>(m), iterator<json_member, member>(m + json_get_object_size(raw())) };
+}
+
+class value : public accessors<value> {
+public:
+    value() noexcept { json_init(&v_); }
+    ~value() { json_free(&v_); }
+    value(const value&) = delete;
+    value& operator=(const value&) = delete;
+    value(value&& o) noexcept {
+        json_init(&v_);
+        json_move(&v_, &o.v_);
+    }
+    value& operator=(value&& o) noexcept {
+        json_move(&v_, &o.v_);
+        return *this;
+    }
+    // Adopt src, which is left null, e.g. a child moved out of a tree.
+    explicit value(json_value* src) noexcept {
+        json_init(&v_);
+        json_move(&v_, src);
+    }
+
+    value clone() const {
+        value r;
+        json_copy(&r.v_, &v_);
+        return r;
+    }
+
+    // JSON_PARSE_OK or a JSON_PARSE_* error, the value is null on failure.
+    int parse(std::string_view json) {
+        json_free(&v_);
+        return json_parse_n(&v_, json.data(), json.size());
+    }
+
+    void set_null() { json_free(&v_); }
+    void set_bool(bool b) { json_set_boolean(&v_, b); }
+    void set_number(double n) { json_set_number(&v_, n); }
+    void set_int64(int64_t n) { json_set_int64(&v_, n); }
+    void set_uint64(uint64_t n) { json_set_uint64(&v_, n); }
+    void set_string(std::string_view s) { json_set_string(&v_, s.data(), s.size()); }
+    // See json_set_string_owned() and json_set_string_borrowed().
+    void set_string_owned(char* s, size_t len) { json_set_string_owned(&v_, s, len); }
+    void set_string_borrowed(const char* s, size_t len) { json_set_string_borrowed(&v_, s, len); }
+
+    // Containers, elements are moved in and e is left null.
+    void set_array(size_t capacity = 0) { json_set_array(&v_, capacity); }
+    void set_object(size_t capacity = 0) { json_set_object(&v_, capacity); }
+    void reserve(size_t capacity) {
+        if (v_.type == JSON_ARRAY)
+            json_array_reserve(&v_, capacity);
+        else
+            json_object_reserve(&v_, capacity);
+    }
+    void push_back(value&& e) { json_array_push_back(&v_, &e.v_); }
+    void set(std::string_view key, value&& e) { json_object_set(&v_, key.data(), key.size(), &e.v_); }
+    bool remove(std::string_view key) { return json_object_remove(&v_, key.data(), key.size()) != 0; }
+
+    json_value* get() noexcept { return &v_; }
+    const json_value* get() const noexcept { return &v_; }
+    // Hand the C value over, this is left null.
+    json_value release() noexcept {
+        json_value r = v_;
+        json_init(&v_);
+        return r;
+    }
+    operator view() const { return view(&v_); }
+
+private:
+    json_value v_;
+};
+
+} // namespace myjson
+
+#endif /* MY_JSON_HPP__ */
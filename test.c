@@ -68,14 +68,31 @@ static void test_parse_expect_value() {
 static void test_parse_invalid_value() {
     TEST_ERROR(JSON_PARSE_INVALID_VALUE, "nul");
     TEST_ERROR(JSON_PARSE_INVALID_VALUE, "?");
+
+    // invalid number
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "+0");
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "+1");
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, ".123"); /* at least one digit before '.' */
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "1.");   /* at least one digit after '.' */
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "1e");
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "1e+");
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "-");
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "INF");
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "inf");
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "NAN");
+    TEST_ERROR(JSON_PARSE_INVALID_VALUE, "nan");
 }
 
 static void test_parse_root_not_singular() {
     TEST_ERROR(JSON_PARSE_ROOT_NOT_SINGULAR, "null x");
+
+    // invalid number
+    TEST_ERROR(JSON_PARSE_ROOT_NOT_SINGULAR, "0123"); /* after zero should be '.' or nothing */
+    TEST_ERROR(JSON_PARSE_ROOT_NOT_SINGULAR, "0x0");
+    TEST_ERROR(JSON_PARSE_ROOT_NOT_SINGULAR, "0x123");
 }
 
 static void test_parse_number() {
-    // TODO: add special number test
     TEST_NUMBER(0.0, "0");
     TEST_NUMBER(0.0, "-0");
     TEST_NUMBER(0.0, "-0.0");
@@ -105,6 +122,56 @@ static void test_parse_number() {
     TEST_NUMBER(-2.2250738585072014e-308, "-2.2250738585072014e-308");
     TEST_NUMBER( 1.7976931348623157e+308, "1.7976931348623157e+308");  /* Max double */
     TEST_NUMBER(-1.7976931348623157e+308, "-1.7976931348623157e+308");
+
+    // Exactly halfway between two doubles, and more than 19 significant digits
+    TEST_NUMBER(9007199254740992.0, "9007199254740993");
+    TEST_NUMBER(9007199254740992.0, "9007199254740993.0");
+    TEST_NUMBER(9007199254740994.0, "9007199254740993.00000000000000000001");
+    TEST_NUMBER(0.1, "0.1000000000000000000000000000000000000000001");
+    TEST_NUMBER(0.1, "0.000000000000000000000000000000000000000001e41");
+    TEST_NUMBER(1e23, "1e23");
+    TEST_NUMBER(0.0, "0e999999999");
+}
+
+#define TEST_INT64(expect, json)\
+    do {\
+        json_value v;\
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, json));\
+        EXPECT_EQ_INT(JSON_NUMBER, json_get_type(&v));\
+        EXPECT_EQ_INT(JSON_NUMBER_INT64, json_get_number_type(&v));\
+        EXPECT_TRUE((expect) == json_get_int64(&v));\
+    } while(0)
+
+static void test_parse_integer() {
+    json_value v;
+
+    TEST_INT64(0, "0");
+    TEST_INT64(-1, "-1");
+    TEST_INT64(9007199254740993LL, "9007199254740993"); /* 2^53 + 1 */
+    TEST_INT64(INT64_MAX, "9223372036854775807");
+    TEST_INT64(INT64_MIN, "-9223372036854775808");
+
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "18446744073709551615"));
+    EXPECT_EQ_INT(JSON_NUMBER_UINT64, json_get_number_type(&v));
+    EXPECT_TRUE(UINT64_MAX == json_get_uint64(&v));
+    EXPECT_EQ_DOUBLE(18446744073709551615.0, json_get_number(&v));
+
+    // Out of integer range, or not written as an integer
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "18446744073709551616"));
+    EXPECT_EQ_INT(JSON_NUMBER_DOUBLE, json_get_number_type(&v));
+    EXPECT_EQ_DOUBLE(18446744073709551616.0, json_get_number(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "-9223372036854775809"));
+    EXPECT_EQ_INT(JSON_NUMBER_DOUBLE, json_get_number_type(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "1.0"));
+    EXPECT_EQ_INT(JSON_NUMBER_DOUBLE, json_get_number_type(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "-0"));
+    EXPECT_EQ_INT(JSON_NUMBER_DOUBLE, json_get_number_type(&v));
+}
+
+static void test_parse_number_too_big() {
+    TEST_ERROR(JSON_PARSE_NUMBER_TOO_BIG, "1e309");
+    TEST_ERROR(JSON_PARSE_NUMBER_TOO_BIG, "-1e309");
+    TEST_ERROR(JSON_PARSE_NUMBER_TOO_BIG, "179769313486231580793728971405303415079934132710037826936173778980444968292764750946649017977587207096330286416692887910946555547851940402630657488671505820681908902000708383676273854845817711531764475730270069855571366959622842914819860834936475292719074168444365510704342711559699508093042880177904174497792");
 }
 
 static void test_parse_true() {
@@ -124,10 +191,106 @@ static void test_parse_false() {
 static void test_parse_string() {
     TEST_STRING("", "\"\"");
     TEST_STRING("Hello", "\"Hello\"");
-    // TODO: add escape characters
-    // json_parse_string()
-//    TEST_STRING("Hello\nWorld", "\"Hello\\nWorld\"");
-//    TEST_STRING("\" \\ / \b \f \n \r \t", "\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t\"");
+    // Runs longer than one SIMD block, ending at every offset inside a block
+    TEST_STRING("0123456789abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+        "\"0123456789abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ\"");
+    TEST_STRING("0123456789abcdefghijklmnopqrstu", "\"0123456789abcdefghijklmnopqrstu\"");
+    TEST_STRING("0123456789abcdefghijklmnopqrstuv", "\"0123456789abcdefghijklmnopqrstuv\"");
+    TEST_STRING("Hello\nWorld", "\"Hello\\nWorld\"");
+    TEST_STRING("\" \\ / \b \f \n \r \t", "\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t\"");
+    TEST_STRING("Hello\0World", "\"Hello\\u0000World\"");
+    TEST_STRING("\x24", "\"\\u0024\"");         /* Dollar sign U+0024 */
+    TEST_STRING("\xC2\xA2", "\"\\u00A2\"");     /* Cents sign U+00A2 */
+    TEST_STRING("\xE2\x82\xAC", "\"\\u20AC\""); /* Euro sign U+20AC */
+    TEST_STRING("\xF0\x9D\x84\x9E", "\"\\uD834\\uDD1E\"");  /* G clef sign U+1D11E */
+    TEST_STRING("\xF0\x9D\x84\x9E", "\"\\ud834\\udd1e\"");  /* G clef sign U+1D11E */
+    // Raw UTF-8 is kept as it is
+    TEST_STRING("\xE4\xB8\xAD\xE6\x96\x87 \xC3\xA9 \xF0\x9F\x98\x80", "\"\xE4\xB8\xAD\xE6\x96\x87 \xC3\xA9 \xF0\x9F\x98\x80\"");
+    // Escapes between runs longer than one SIMD block
+    TEST_STRING("0123456789abcdefghijklmnopqrstuv\"0123456789abcdefghijklmnopqrstuv\xC3\xA9\n",
+        "\"0123456789abcdefghijklmnopqrstuv\\\"0123456789abcdefghijklmnopqrstuv\\u00e9\\n\"");
+}
+
+static void test_parse_invalid_string_escape() {
+    TEST_ERROR(JSON_PARSE_INVALID_STRING_ESCAPE, "\"\\v\"");
+    TEST_ERROR(JSON_PARSE_INVALID_STRING_ESCAPE, "\"\\'\"");
+    TEST_ERROR(JSON_PARSE_INVALID_STRING_ESCAPE, "\"\\0\"");
+    TEST_ERROR(JSON_PARSE_INVALID_STRING_ESCAPE, "\"\\x12\"");
+    TEST_ERROR(JSON_PARSE_INVALID_STRING_ESCAPE, "[\"abc\\U0041\"]");
+}
+
+static void test_parse_invalid_string_char() {
+    TEST_ERROR(JSON_PARSE_INVALID_STRING_CHAR, "\"\x01\"");
+    TEST_ERROR(JSON_PARSE_INVALID_STRING_CHAR, "\"\x1F\"");
+    TEST_ERROR(JSON_PARSE_INVALID_STRING_CHAR, "{\"a\nb\":1}");
+}
+
+static void test_parse_invalid_unicode_hex() {
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u0\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u01\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u012\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u/000\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\uG000\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u0/00\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u0G00\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u00/0\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u00G0\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u000/\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u000G\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\u 123\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_HEX, "\"\\uD800\\u12\"");
+}
+
+static void test_parse_invalid_unicode_surrogate() {
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uDBFF\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\\\\\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\\uDBFF\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\\uE000\"");
+    TEST_ERROR(JSON_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uDC00\"");
+}
+
+// Every sequence at every offset of a SIMD block, followed by the closing
+// quote, by more text and by an escape, and once cut by the end of input.
+static void test_parse_utf8() {
+    static const char* const valid[] = {
+        "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF", "\xEE\x80\x80", "\xEF\xBF\xBF",
+        "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF", "\xE4\xB8\xAD\xE6\x96\x87"
+    };
+    static const char* const invalid[] = {
+        "\x80", "\xBF", "\xC0\xAF", "\xC1\xBF", "\xC2", "\xC2\x41", "\xC2\x80\x80", "\xE0\x80\xAF",
+        "\xE0\x9F\xBF", "\xED\xA0\x80", "\xE4\xB8", "\xE4\xB8\xE4", "\xF0\x8F\xBF\xBF",
+        "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xF0\x90\x80", "\xFE", "\xFF"
+    };
+    static const char* const suffix[] = { "", "0123456789abcdefghij", "\\n" };
+    char json[128];
+    json_value v;
+    size_t i, j, k, n;
+
+    json_init(&v);
+    for (k = 0; k < 40; k++) {
+        for (j = 0; j < sizeof(suffix) / sizeof(suffix[0]); j++) {
+            for (i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+                memset(json, 'a', k + 1);
+                json[0] = '\"';
+                n = (size_t)sprintf(json + k + 1, "%s%s\"", valid[i], suffix[j]) + k + 1;
+                EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, json));
+                EXPECT_EQ_SIZE_T(n - 2 - (j == 2), json_get_string_length(&v));
+                json_free(&v);
+            }
+            for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+                memset(json, 'a', k + 1);
+                json[0] = '\"';
+                sprintf(json + k + 1, "%s%s\"", invalid[i], suffix[j]);
+                TEST_ERROR(JSON_PARSE_INVALID_STRING_CHAR, json);
+            }
+        }
+        memset(json, 'a', k + 1);
+        json[0] = '\"';
+        memcpy(json + k + 1, "\xE4\xB8", 3);
+        TEST_ERROR(JSON_PARSE_INVALID_STRING_CHAR, json);
+    }
 }
 
 static void test_parse_array() {
@@ -177,6 +340,59 @@ static void test_access_string() {
     json_free(&v);
 }
 
+static void test_access_ownership() {
+    json_value v, w;
+    json_document* d;
+    char* s;
+    size_t len;
+    static const char text[] = "borrowed";
+
+    json_init(&v);
+    json_init(&w);
+    s = (char*)malloc(4);
+    memcpy(s, "abc", 4);
+    json_set_string_owned(&v, s, 3);
+    EXPECT_TRUE(json_get_string(&v) == s);
+    EXPECT_TRUE(json_take_string(&v, &len) == s);
+    EXPECT_EQ_SIZE_T(3, len);
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));
+    free(s);
+
+    json_set_string_borrowed(&v, text, 8);
+    EXPECT_TRUE(json_get_string(&v) == text);
+    s = json_take_string(&v, &len);
+    EXPECT_TRUE(s != text);
+    EXPECT_EQ_STRING("borrowed", s, len);
+    free(s);
+    json_set_string_borrowed(&v, text, 8);
+    json_free(&v);
+
+    // A child moved into its own parent, then copied and moved around
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "{\"a\":[1,\"x\",{\"b\":null}],\"c\":2}"));
+    json_move(&v, json_find_object_value(&v, "a", 1));
+    EXPECT_EQ_INT(JSON_ARRAY, json_get_type(&v));
+    EXPECT_EQ_SIZE_T(3, json_get_array_size(&v));
+    json_copy(&w, &v);
+    json_copy(&v, json_get_array_element(&v, 2));
+    EXPECT_EQ_INT(JSON_OBJECT, json_get_type(&v));
+    EXPECT_TRUE(json_find_object_value(&v, "b", 1) != NULL);
+    json_move(&v, json_get_array_element(&w, 1));
+    EXPECT_EQ_STRING("x", json_get_string(&v), json_get_string_length(&v));
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(json_get_array_element(&w, 1)));
+    json_move(&v, &v);
+    EXPECT_EQ_INT(JSON_STRING, json_get_type(&v));
+    json_free(&v);
+    json_free(&w);
+
+    // A copy out of a document owns its storage
+    d = json_document_create();
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_document_parse(d, "{\"k\":[\"v\"]}"));
+    json_copy(&v, json_document_root(d));
+    json_document_destroy(d);
+    EXPECT_EQ_STRING("v", json_get_string(json_get_array_element(json_find_object_value(&v, "k", 1), 0)), 1);
+    json_free(&v);
+}
+
 static void test_access_boolean() {
     json_value v;
     json_init(&v);
@@ -197,6 +413,180 @@ static void test_access_number() {
     json_free(&v);
 }
 
+#define TEST_STRINGIFY_VALUE(json, v)\
+    do {\
+        size_t length;\
+        char* actual = json_stringify(v, &length);\
+        EXPECT_EQ_STRING(json, actual, length);\
+        free(actual);\
+    } while(0)
+
+static void test_access_array() {
+    json_counting_allocator a;
+    json_document* d;
+    json_value v, e, items[2];
+    size_t i;
+
+    json_init(&v);
+    json_init(&e);
+    json_set_array(&v, 0);
+    EXPECT_EQ_SIZE_T(0, json_get_array_capacity(&v));
+    // Appends grow geometrically, elements are moved in
+    json_counting_allocator_init(&a, NULL);
+    json_set_allocator(&a.allocator);
+    for (i = 0; i < 100000; i++) {
+        json_set_int64(&e, (int64_t)i);
+        json_array_push_back(&v, &e);
+    }
+    EXPECT_TRUE(json_get_int64(json_get_array_element(&v, 99999)) == 99999);
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&e));
+    EXPECT_EQ_SIZE_T(100000, json_get_array_size(&v));
+    EXPECT_TRUE(json_get_array_capacity(&v) >= 100000);
+    EXPECT_TRUE(a.count < 40);
+    json_array_shrink_to_fit(&v);
+    EXPECT_EQ_SIZE_T(100000, json_get_array_capacity(&v));
+    json_array_clear(&v);
+    EXPECT_EQ_SIZE_T(0, json_get_array_size(&v));
+    EXPECT_EQ_SIZE_T(100000, json_get_array_capacity(&v));
+    json_array_shrink_to_fit(&v);
+    EXPECT_EQ_SIZE_T(0, json_get_array_capacity(&v));
+    EXPECT_EQ_SIZE_T(0, a.current);
+    json_set_allocator(NULL);
+
+    json_set_array(&v, 2);
+    EXPECT_EQ_SIZE_T(2, json_get_array_capacity(&v));
+    json_array_reserve(&v, 8);
+    EXPECT_EQ_SIZE_T(8, json_get_array_capacity(&v));
+    json_array_reserve(&v, 4);
+    EXPECT_EQ_SIZE_T(8, json_get_array_capacity(&v));
+    for (i = 0; i < 5; i++)
+        json_set_int64(json_array_push_back(&v, NULL), (int64_t)i);
+    json_set_string(json_array_insert(&v, 0, NULL), "a", 1);
+    json_array_insert(&v, 6, NULL);
+    json_array_insert(&v, 3, json_get_array_element(&v, 0));
+    TEST_STRINGIFY_VALUE("[null,0,1,\"a\",2,3,4,null]", &v);
+    json_array_erase(&v, 1, 2);
+    json_array_erase(&v, 5, 1);
+    json_array_erase(&v, 0, 0);
+    json_array_pop_back(&v);
+    TEST_STRINGIFY_VALUE("[null,\"a\",2,3]", &v);
+    // A value inside the array may be pushed back onto it
+    json_array_push_back(&v, json_get_array_element(&v, 1));
+    TEST_STRINGIFY_VALUE("[null,null,2,3,\"a\"]", &v);
+    json_free(&v);
+
+    // Document arrays grow inside the document's arena, the default
+    // allocator is never asked and the root needs no json_free()
+    d = json_document_create();
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_document_parse(d, "[1,[2,3]]"));
+    json_counting_allocator_init(&a, NULL);
+    json_set_allocator(&a.allocator);
+    json_array_pop_back(json_get_array_element(json_document_root(d), 1));
+    json_array_shrink_to_fit(json_get_array_element(json_document_root(d), 1));
+    for (i = 0; i < 100; i++)
+        json_array_push_back(json_document_root(d), NULL);
+    json_array_erase(json_document_root(d), 3, 99);
+    EXPECT_EQ_SIZE_T(0, a.count);
+    json_set_allocator(NULL);
+    EXPECT_TRUE(json_document_root(d)->flags & JSON_FLAG_ARENA);
+    EXPECT_EQ_SIZE_T(1, json_get_array_capacity(json_get_array_element(json_document_root(d), 1)));
+    TEST_STRINGIFY_VALUE("[1,[2],null]", json_document_root(d));
+    json_document_destroy(d);
+
+    // Other borrowed storage is copied out when it grows
+    json_init(&items[0]);
+    json_init(&items[1]);
+    json_set_int64(&items[0], 1);
+    json_set_int64(&items[1], 2);
+    v.type = JSON_ARRAY;
+    v.flags = JSON_FLAG_BORROWED;
+    v.u.a.e = items;
+    v.u.a.size = v.u.a.capacity = 2;
+    json_set_int64(json_array_push_back(&v, NULL), 3);
+    EXPECT_TRUE(v.u.a.e != items && !(v.flags & JSON_FLAG_BORROWED));
+    EXPECT_TRUE(json_get_int64(&items[1]) == 2);
+    TEST_STRINGIFY_VALUE("[1,2,3]", &v);
+    json_free(&v);
+}
+
+static void test_access_object() {
+    json_counting_allocator a;
+    json_document* d;
+    json_value v, e;
+    char key[16], buf[] = "{\"x\":1,\"y\":2}";
+    size_t i;
+
+    json_init(&v);
+    json_init(&e);
+    json_set_object(&v, 0);
+    EXPECT_EQ_SIZE_T(0, json_get_object_size(&v));
+    for (i = 0; i < 1000; i++) {
+        json_set_int64(&e, (int64_t)i);
+        json_object_set(&v, key, (size_t)sprintf(key, "k%d", (int)i), &e);
+    }
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&e));
+    EXPECT_EQ_SIZE_T(1000, json_get_object_size(&v));
+    EXPECT_TRUE(json_get_object_capacity(&v) >= 1000);
+    for (i = 0; i < 1000; i += 37)
+        EXPECT_TRUE(json_get_int64(json_find_object_value(&v, key, (size_t)sprintf(key, "k%d", (int)i))) == (int64_t)i);
+    // Setting an existing key replaces its value in place
+    json_set_string(json_object_set(&v, "k5", 2, NULL), "five", 4);
+    EXPECT_EQ_SIZE_T(1000, json_get_object_size(&v));
+    EXPECT_EQ_SIZE_T(5, json_find_object_index(&v, "k5", 2));
+    EXPECT_EQ_STRING("five", json_get_string(json_get_object_value(&v, 5)), 4);
+    // Removing shifts the members after it
+    EXPECT_EQ_INT(1, json_object_remove(&v, "k5", 2));
+    EXPECT_EQ_INT(0, json_object_remove(&v, "k5", 2));
+    EXPECT_EQ_SIZE_T(999, json_get_object_size(&v));
+    EXPECT_EQ_SIZE_T(5, json_find_object_index(&v, "k6", 2));
+    EXPECT_EQ_SIZE_T(998, json_find_object_index(&v, "k999", 4));
+    json_object_erase(&v, 0, 990);
+    EXPECT_EQ_SIZE_T(9, json_get_object_size(&v));
+    EXPECT_EQ_SIZE_T(0, json_find_object_index(&v, "k991", 4));
+    json_object_shrink_to_fit(&v);
+    EXPECT_EQ_SIZE_T(9, json_get_object_capacity(&v));
+    json_object_clear(&v);
+    EXPECT_EQ_SIZE_T(0, json_get_object_size(&v));
+    json_object_reserve(&v, 3);
+    EXPECT_EQ_SIZE_T(9, json_get_object_capacity(&v));
+    json_object_shrink_to_fit(&v);
+    json_object_reserve(&v, 3);
+    EXPECT_EQ_SIZE_T(3, json_get_object_capacity(&v));
+
+    // A member value moved under a new key of the same object
+    json_set_array(json_object_set(&v, "a", 1, NULL), 0);
+    json_set_boolean(json_array_push_back(json_find_object_value(&v, "a", 1), NULL), 1);
+    json_object_set(&v, json_get_object_key(&v, 0), 1, json_find_object_value(&v, "a", 1));
+    json_object_set(&v, "b", 1, json_get_array_element(json_find_object_value(&v, "a", 1), 0));
+    TEST_STRINGIFY_VALUE("{\"a\":[null],\"b\":true}", &v);
+    json_free(&v);
+
+    // Document objects take new keys and storage from the document's arena
+    d = json_document_create();
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_document_parse(d, "{\"x\":{\"y\":1,\"z\":2}}"));
+    json_counting_allocator_init(&a, NULL);
+    json_set_allocator(&a.allocator);
+    EXPECT_EQ_INT(1, json_object_remove(json_find_object_value(json_document_root(d), "x", 1), "y", 1));
+    json_set_int64(json_object_set(json_document_root(d), "w", 1, NULL), 3);
+    for (i = 0; i < 40; i++)
+        json_object_set(json_document_root(d), key, (size_t)sprintf(key, "k%d", (int)i), NULL);
+    EXPECT_EQ_SIZE_T(41, json_find_object_index(json_document_root(d), "k39", 3));
+    json_object_erase(json_document_root(d), 2, 40);
+    EXPECT_EQ_SIZE_T(0, a.count);
+    json_set_allocator(NULL);
+    EXPECT_TRUE(json_document_root(d)->flags & JSON_FLAG_ARENA);
+    TEST_STRINGIFY_VALUE("{\"x\":{\"z\":2},\"w\":3}", json_document_root(d));
+    json_document_destroy(d);
+
+    // Keys borrowed from an in situ buffer are copied out on the first append
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_insitu(&v, buf));
+    json_set_int64(json_object_set(&v, "w", 1, NULL), 3);
+    EXPECT_FALSE(v.flags & JSON_FLAG_KEYS_BORROWED);
+    memset(buf, 0, sizeof(buf));
+    TEST_STRINGIFY_VALUE("{\"x\":1,\"y\":2,\"w\":3}", &v);
+    json_free(&v);
+}
+
 static void test_parse_object() {
     json_value v;
     size_t i;
@@ -279,6 +669,1187 @@ static void test_parse_miss_comma_or_curly_bracket() {
     TEST_ERROR(JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{}");
 }
 
+static void test_parse_document() {
+    json_document* d = json_document_create();
+    json_value* v;
+    int i;
+
+    // Reparse a few times to go through the reset-and-reuse path
+    for (i = 0; i < 3; i++) {
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_document_parse(d, "{ \"a\" : [ 1, \"xyz\", { } ], \"b\" : \"c\" }"));
+        v = json_document_root(d);
+        EXPECT_EQ_INT(JSON_OBJECT, json_get_type(v));
+        EXPECT_EQ_SIZE_T(2, json_get_object_size(v));
+        EXPECT_EQ_STRING("a", json_get_object_key(v, 0), json_get_object_key_length(v, 0));
+        EXPECT_EQ_SIZE_T(3, json_get_array_size(json_get_object_value(v, 0)));
+        EXPECT_EQ_STRING("xyz", json_get_string(json_get_array_element(json_get_object_value(v, 0), 1)),
+            json_get_string_length(json_get_array_element(json_get_object_value(v, 0), 1)));
+        EXPECT_EQ_STRING("c", json_get_string(json_get_object_value(v, 1)), json_get_string_length(json_get_object_value(v, 1)));
+    }
+
+    // Setters on document nodes must not free arena storage
+    json_set_number(json_get_object_value(json_document_root(d), 1), 2.0);
+    EXPECT_EQ_DOUBLE(2.0, json_get_number(json_get_object_value(json_document_root(d), 1)));
+
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_document_parse(d, "[ \"a\", 1 }"));
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(json_document_root(d)));
+
+    json_document_reset(d);
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(json_document_root(d)));
+    json_document_destroy(d);
+}
+
+static void test_parse_insitu() {
+    char buf[] = "{ \"name\" : \"abc\", \"list\" : [ \"x\", \"\", 1 ] }";
+    char bad[] = "[ \"abc\", \"de";
+    char escaped[] = "{\"a\\nb\":\"\\\"x\\u20AC\\uD834\\uDD1E\\/\"}";
+    char longbuf[] = "[\"\", \"0123456789abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ\"]";
+    json_value v;
+    json_value* e;
+
+    json_init(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_insitu(&v, buf));
+    EXPECT_EQ_INT(JSON_OBJECT, json_get_type(&v));
+    EXPECT_EQ_SIZE_T(2, json_get_object_size(&v));
+    EXPECT_EQ_STRING("name", json_get_object_key(&v, 0), json_get_object_key_length(&v, 0));
+    EXPECT_TRUE(json_get_object_key(&v, 0) > buf && json_get_object_key(&v, 0) < buf + sizeof(buf));
+    e = json_get_object_value(&v, 0);
+    EXPECT_EQ_STRING("abc", json_get_string(e), json_get_string_length(e));
+    EXPECT_TRUE(json_get_string(e) > buf && json_get_string(e) < buf + sizeof(buf));
+    EXPECT_EQ_INT('\0', json_get_string(e)[3]);
+    e = json_get_object_value(&v, 1);
+    EXPECT_EQ_SIZE_T(3, json_get_array_size(e));
+    EXPECT_EQ_STRING("x", json_get_string(json_get_array_element(e, 0)), json_get_string_length(json_get_array_element(e, 0)));
+    EXPECT_EQ_STRING("", json_get_string(json_get_array_element(e, 1)), json_get_string_length(json_get_array_element(e, 1)));
+    json_free(&v);
+
+    json_init(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_insitu(&v, longbuf));
+    EXPECT_EQ_SIZE_T(2, json_get_array_size(&v));
+    EXPECT_EQ_STRING("0123456789abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+        json_get_string(json_get_array_element(&v, 1)), json_get_string_length(json_get_array_element(&v, 1)));
+    json_free(&v);
+
+    // Escapes are decoded in place, the result is never longer
+    json_init(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_insitu(&v, escaped));
+    EXPECT_EQ_STRING("a\nb", json_get_object_key(&v, 0), json_get_object_key_length(&v, 0));
+    e = json_get_object_value(&v, 0);
+    EXPECT_EQ_STRING("\"x\xE2\x82\xAC\xF0\x9D\x84\x9E/", json_get_string(e), json_get_string_length(e));
+    EXPECT_EQ_INT('\0', json_get_string(e)[json_get_string_length(e)]);
+    json_free(&v);
+
+    json_init(&v);
+    EXPECT_EQ_INT(JSON_PARSE_MISS_QUOTATION_MARK, json_parse_insitu(&v, bad));
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));
+}
+
+// Also through CBOR, which must give back the same tree.
+#define TEST_ROUNDTRIP(json)\
+    do {\
+        json_value v;\
+        char* json2;\
+        char* cbor;\
+        size_t length;\
+        json_init(&v);\
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, json));\
+        json2 = json_stringify(&v, &length);\
+        EXPECT_EQ_STRING(json, json2, length);\
+        free(json2);\
+        cbor = json_cbor_encode(&v, &length);\
+        json_free(&v);\
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_cbor_decode(&v, cbor, length));\
+        json2 = json_stringify(&v, &length);\
+        EXPECT_EQ_STRING(json, json2, length);\
+        json_free(&v);\
+        free(json2);\
+        free(cbor);\
+    } while(0)
+
+static void test_stringify_number() {
+    TEST_ROUNDTRIP("0");
+    TEST_ROUNDTRIP("-0.0");
+    TEST_ROUNDTRIP("1");
+    TEST_ROUNDTRIP("-1");
+    TEST_ROUNDTRIP("1.5");
+    TEST_ROUNDTRIP("-1.5");
+    TEST_ROUNDTRIP("3.25");
+    TEST_ROUNDTRIP("0.1");
+    TEST_ROUNDTRIP("1e25");
+    TEST_ROUNDTRIP("1.234e25");
+    TEST_ROUNDTRIP("1.234e-20");
+    TEST_ROUNDTRIP("9223372036854775807");
+    TEST_ROUNDTRIP("-9223372036854775808");
+    TEST_ROUNDTRIP("18446744073709551615");
+
+    TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
+    TEST_ROUNDTRIP("5e-324"); /* minimum denormal */
+    TEST_ROUNDTRIP("-5e-324");
+    TEST_ROUNDTRIP("2.225073858507201e-308");  /* Max subnormal double */
+    TEST_ROUNDTRIP("2.2250738585072014e-308");  /* Min normal positive double */
+    TEST_ROUNDTRIP("1.7976931348623157e308");  /* Max double */
+    TEST_ROUNDTRIP("-1.7976931348623157e308");
+}
+
+static void test_stringify_string() {
+    json_value v;
+    char* json;
+    size_t length;
+
+    TEST_ROUNDTRIP("\"\"");
+    TEST_ROUNDTRIP("\"Hello\"");
+    TEST_ROUNDTRIP("\"Hello\\nWorld\"");
+    TEST_ROUNDTRIP("\"\\\" \\\\ / \\b \\f \\n \\r \\t\"");
+    TEST_ROUNDTRIP("\"Hello\\u0000World\"");
+    TEST_ROUNDTRIP("\"\xE2\x82\xAC \xF0\x9D\x84\x9E\"");
+
+    json_init(&v);
+    json_set_string(&v, "\" \\ / \b \f \n \r \t \x01 \x1f", 19);
+    json = json_stringify(&v, &length);
+    EXPECT_EQ_STRING("\"\\\" \\\\ / \\b \\f \\n \\r \\t \\u0001 \\u001F\"", json, length);
+    free(json);
+    json_set_string(&v, "Hello\0World", 11);
+    json = json_stringify(&v, &length);
+    EXPECT_EQ_STRING("\"Hello\\u0000World\"", json, length);
+    free(json);
+    json_free(&v);
+}
+
+#define TEST_CBOR(bytes, json)\
+    do {\
+        json_value v;\
+        char* cbor;\
+        size_t length;\
+        json_init(&v);\
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, json));\
+        cbor = json_cbor_encode(&v, &length);\
+        EXPECT_EQ_SIZE_T(sizeof(bytes) - 1, length);\
+        EXPECT_TRUE(memcmp(bytes, cbor, length) == 0);\
+        json_free(&v);\
+        free(cbor);\
+    } while(0)
+
+#define TEST_CBOR_ERROR(error, bytes)\
+    do {\
+        json_value v;\
+        json_init(&v);\
+        v.type = JSON_FALSE;\
+        EXPECT_EQ_INT(error, json_cbor_decode(&v, bytes, sizeof(bytes) - 1));\
+        EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));\
+    } while(0)
+
+static void test_cbor() {
+    json_value v;
+    char* buf = NULL;
+    size_t size = 0, length;
+
+    // Examples of RFC 8949 Appendix A
+    TEST_CBOR("\x00", "0");
+    TEST_CBOR("\x17", "23");
+    TEST_CBOR("\x18\x18", "24");
+    TEST_CBOR("\x19\x03\xe8", "1000");
+    TEST_CBOR("\x1a\x00\x0f\x42\x40", "1000000");
+    TEST_CBOR("\x1b\xff\xff\xff\xff\xff\xff\xff\xff", "18446744073709551615");
+    TEST_CBOR("\x20", "-1");
+    TEST_CBOR("\x38\x63", "-100");
+    TEST_CBOR("\x3b\x7f\xff\xff\xff\xff\xff\xff\xff", "-9223372036854775808");
+    TEST_CBOR("\xfa\x3f\xc0\x00\x00", "1.5");
+    TEST_CBOR("\xfb\x3f\xf1\x99\x99\x99\x99\x99\x9a", "1.1");
+    TEST_CBOR("\xf4", "false");
+    TEST_CBOR("\xf5", "true");
+    TEST_CBOR("\xf6", "null");
+    TEST_CBOR("\x60", "\"\"");
+    TEST_CBOR("\x64\x49\x45\x54\x46", "\"IETF\"");
+    TEST_CBOR("\x80", "[]");
+    TEST_CBOR("\x83\x01\x82\x02\x03\x82\x04\x05", "[1,[2,3],[4,5]]");
+    TEST_CBOR("\xa2\x61\x61\x01\x61\x62\x82\x02\x03", "{\"a\":1,\"b\":[2,3]}");
+
+    // Number types come back as json_parse() makes them
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_cbor_decode(&v, "\x3b\x80\x00\x00\x00\x00\x00\x00\x00", 9));
+    EXPECT_EQ_INT(JSON_NUMBER_DOUBLE, json_get_number_type(&v));
+    EXPECT_EQ_DOUBLE(-9223372036854775809.0, json_get_number(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_cbor_decode(&v, "\x1b\x80\x00\x00\x00\x00\x00\x00\x00", 9));
+    EXPECT_EQ_INT(JSON_NUMBER_UINT64, json_get_number_type(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_cbor_decode(&v, "\xf9\x3c\x00", 3));
+    EXPECT_EQ_INT(JSON_NUMBER_DOUBLE, json_get_number_type(&v));
+    EXPECT_EQ_DOUBLE(1.0, json_get_number(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_cbor_decode(&v, "\xf9\x00\x01", 3));
+    EXPECT_EQ_DOUBLE(5.960464477539063e-8, json_get_number(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_cbor_decode(&v, "\xf9\xc4\x00", 3));
+    EXPECT_EQ_DOUBLE(-4.0, json_get_number(&v));
+
+    // Strings may hold any byte
+    json_set_string(&v, "a\0b", 3);
+    length = json_cbor_encode_to(&v, &buf, &size);
+    json_free(&v);
+    EXPECT_EQ_SIZE_T(4, length);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_cbor_decode(&v, buf, length));
+    EXPECT_EQ_STRING("a\0b", json_get_string(&v), 3);
+    json_free(&v);
+    free(buf);
+
+    TEST_CBOR_ERROR(JSON_PARSE_EXPECT_VALUE, "");
+    TEST_CBOR_ERROR(JSON_PARSE_ROOT_NOT_SINGULAR, "\x01\x02");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_VALUE, "\x18");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_VALUE, "\x1c");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_VALUE, "\x63\x61\x62");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_VALUE, "\x42\x61\x62");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_VALUE, "\x9f\x01\xff");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_VALUE, "\xc1\x01");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_VALUE, "\xf7");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_VALUE, "\x9b\xff\xff\xff\xff\xff\xff\xff\xff\x01");
+    TEST_CBOR_ERROR(JSON_PARSE_EXPECT_VALUE, "\x83\x61\x61\x81\x01");
+    TEST_CBOR_ERROR(JSON_PARSE_EXPECT_VALUE, "\x82\x82\x61\x61\x61\x62");
+    TEST_CBOR_ERROR(JSON_PARSE_MISS_KEY, "\xa1\x01\x02");
+    TEST_CBOR_ERROR(JSON_PARSE_EXPECT_VALUE, "\xa2\x61\x61\x80\x61\x62");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_STRING_CHAR, "\x62\xc3\x28");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_STRING_CHAR, "\x81\x61\xff");
+    TEST_CBOR_ERROR(JSON_PARSE_INVALID_STRING_CHAR, "\xa1\x61\x80\x01");
+}
+
+static void test_stringify() {
+    json_value v;
+    char* buf = NULL;
+    size_t size = 0, length;
+
+    TEST_ROUNDTRIP("null");
+    TEST_ROUNDTRIP("false");
+    TEST_ROUNDTRIP("true");
+    test_stringify_number();
+    test_stringify_string();
+    TEST_ROUNDTRIP("[]");
+    TEST_ROUNDTRIP("[null,false,true,123,\"abc\",[1,2,3]]");
+    TEST_ROUNDTRIP("{}");
+    TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
+
+    // Pretty output, into a buffer reused across calls
+    json_init(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "{\"a\":[1,{}],\"b\":[],\"c\":\"d\"}"));
+    length = json_stringify_to(&v, &buf, &size, JSON_STRINGIFY_PRETTY);
+    EXPECT_EQ_STRING("{\n    \"a\": [\n        1,\n        {}\n    ],\n    \"b\": [],\n    \"c\": \"d\"\n}", buf, length);
+    length = json_stringify_to(&v, &buf, &size, 0);
+    EXPECT_EQ_STRING("{\"a\":[1,{}],\"b\":[],\"c\":\"d\"}", buf, length);
+    EXPECT_TRUE(size > length);
+    free(buf);
+    json_free(&v);
+
+    test_cbor();
+}
+
+// Records SAX events as text, stops after "stop" events when non-zero.
+typedef struct {
+    char log[256];
+    size_t len;
+    int stop;
+} sax_log;
+
+static int sax_put(sax_log* l, const char* s, size_t len) {
+    memcpy(l->log + l->len, s, len);
+    l->log[l->len += len] = '\0';
+    return l->stop != 0 && --l->stop == 0;
+}
+
+static int sax_on_null(void* u) { return sax_put((sax_log*)u, "n", 1); }
+static int sax_on_bool(void* u, int b) { return sax_put((sax_log*)u, b ? "t" : "f", 1); }
+static int sax_on_number(void* u, const json_value* n) {
+    char buf[32];
+    return sax_put((sax_log*)u, buf, sprintf(buf, "%g", json_get_number(n)));
+}
+static int sax_on_string(void* u, const char* s, size_t len) {
+    return sax_put((sax_log*)u, "s", 1) || sax_put((sax_log*)u, s, len);
+}
+static int sax_on_key(void* u, const char* k, size_t klen) {
+    return sax_put((sax_log*)u, k, klen) || sax_put((sax_log*)u, ":", 1);
+}
+static int sax_on_start_object(void* u) { return sax_put((sax_log*)u, "{", 1); }
+static int sax_on_end_object(void* u, size_t size) { return sax_put((sax_log*)u, size == 2 ? "}" : "?", 1); }
+static int sax_on_start_array(void* u) { return sax_put((sax_log*)u, "[", 1); }
+static int sax_on_end_array(void* u, size_t size) { return sax_put((sax_log*)u, size == 5 ? "]" : "?", 1); }
+
+static void test_parse_sax() {
+    json_handler h = {
+        sax_on_null, sax_on_bool, sax_on_number, sax_on_string, sax_on_key,
+        sax_on_start_object, sax_on_end_object, sax_on_start_array, sax_on_end_array
+    };
+    json_handler empty = { 0 };
+    const char* json = " { \"a\" : [ null , true , false , -1.5 , \"xyz\" ] , \"\" : \"\" } ";
+    sax_log l = { "", 0, 0 };
+
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_sax(json, &h, &l));
+    EXPECT_EQ_STRING("{a:[ntf-1.5sxyz]:s}", l.log, l.len);
+
+    // Stop at the first number
+    l.len = 0;
+    l.stop = 8;
+    EXPECT_EQ_INT(JSON_PARSE_ABORTED, json_parse_sax(json, &h, &l));
+    EXPECT_EQ_STRING("{a:[ntf-1.5", l.log, l.len);
+
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_sax(json, &empty, NULL));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_parse_sax("[1 2]", &empty, NULL));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_KEY, json_parse_sax("{1:1}", &empty, NULL));
+    EXPECT_EQ_INT(JSON_PARSE_ROOT_NOT_SINGULAR, json_parse_sax("[] x", &empty, NULL));
+    // Only len bytes are read, the rest of the buffer is never looked at
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_sax_n("[1,2] x", 5, &empty, NULL));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_sax_n("123", 2, &empty, NULL));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_parse_sax_n("[1,2]", 4, &empty, NULL));
+    EXPECT_EQ_INT(JSON_PARSE_EXPECT_VALUE, json_parse_sax_n("1", 0, &empty, NULL));
+}
+
+// Feed json split at every position and byte by byte, compare with json_parse().
+static void test_parser_splits(const char* json) {
+    json_parser* p = json_parser_create();
+    json_value v, expect;
+    char* s1;
+    char* s2;
+    size_t n = strlen(json), i, l1, l2;
+
+    json_init(&expect);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&expect, json));
+    s1 = json_stringify(&expect, &l1);
+    for (i = 0; i <= n + 1; i++) {
+        if (i <= n) {
+            EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, json, i));
+            EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, json + i, n - i));
+        }
+        else {
+            size_t j;
+            for (j = 0; j < n; j++)
+                EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, json + j, 1));
+        }
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_finish(p, &v));
+        s2 = json_stringify(&v, &l2);
+        EXPECT_TRUE(l1 == l2 && memcmp(s1, s2, l1) == 0);
+        free(s2);
+        json_free(&v);
+    }
+    free(s1);
+    json_free(&expect);
+    json_parser_destroy(p);
+}
+
+#define TEST_PARSER_ERROR(error, json)\
+    do {\
+        json_parser* p = json_parser_create();\
+        json_value v;\
+        json_parser_feed(p, json, strlen(json));\
+        EXPECT_EQ_INT(error, json_parser_finish(p, &v));\
+        EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));\
+        json_parser_destroy(p);\
+    } while(0)
+
+static void test_parse_incremental() {
+    json_parser* p;
+    json_value v;
+
+    test_parser_splits("null");
+    test_parser_splits(" -12.5e-3 ");
+    test_parser_splits("18446744073709551615");
+    test_parser_splits("\"0123456789abcdefghijklmnopqrstuvwxyz\"");
+    test_parser_splits("[\"a\\\"b\\\\\", \"\\u00e9\\uD834\\uDD1E\xC3\xA9\"]");
+    test_parser_splits(" [ null , false , true , 123 , \"abc\" , [ ] , { } ] ");
+    test_parser_splits(
+        " { "
+        "\"n\" : null , "
+        "\"f\" : false , "
+        "\"t\" : true , "
+        "\"i\" : -0.5e10 , "
+        "\"s\" : \"abc\", "
+        "\"a\" : [ 1, 2, [ 3 ] ],"
+        "\"o\" : { \"1\" : 1, \"2\" : 2, \"3\" : 3 }"
+        " } ");
+
+    TEST_PARSER_ERROR(JSON_PARSE_EXPECT_VALUE, "");
+    TEST_PARSER_ERROR(JSON_PARSE_EXPECT_VALUE, "[1,");
+    TEST_PARSER_ERROR(JSON_PARSE_INVALID_VALUE, "nul");
+    TEST_PARSER_ERROR(JSON_PARSE_INVALID_VALUE, "[nulx]");
+    TEST_PARSER_ERROR(JSON_PARSE_INVALID_VALUE, "1.");
+    TEST_PARSER_ERROR(JSON_PARSE_INVALID_VALUE, "[1.e1]");
+    TEST_PARSER_ERROR(JSON_PARSE_INVALID_VALUE, "?");
+    TEST_PARSER_ERROR(JSON_PARSE_ROOT_NOT_SINGULAR, "null x");
+    TEST_PARSER_ERROR(JSON_PARSE_ROOT_NOT_SINGULAR, "0123");
+    TEST_PARSER_ERROR(JSON_PARSE_MISS_QUOTATION_MARK, "[\"abc");
+    TEST_PARSER_ERROR(JSON_PARSE_INVALID_UNICODE_SURROGATE, "[\"\\uD800\"]");
+    TEST_PARSER_ERROR(JSON_PARSE_INVALID_STRING_CHAR, "[\"\xE4\xB8\"]");
+    TEST_PARSER_ERROR(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[\"a\", {\"b\":[1 2]}]");
+    TEST_PARSER_ERROR(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[[1]");
+    TEST_PARSER_ERROR(JSON_PARSE_MISS_KEY, "{\"a\":1,");
+    TEST_PARSER_ERROR(JSON_PARSE_MISS_KEY, "{1:1}");
+    TEST_PARSER_ERROR(JSON_PARSE_MISS_COLON, "{\"a\",\"b\"}");
+    TEST_PARSER_ERROR(JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{}");
+    TEST_PARSER_ERROR(JSON_PARSE_NUMBER_TOO_BIG, "[{\"a\":1e309}]");
+
+    // The error sticks until finish, then the parser is reusable
+    p = json_parser_create();
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COLON, json_parser_feed(p, "{\"a\" 1", 7));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COLON, json_parser_feed(p, "}", 1));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COLON, json_parser_finish(p, &v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, "[1,", 3));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, "2]", 2));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_finish(p, &v));
+    EXPECT_EQ_SIZE_T(2, json_get_array_size(&v));
+    json_free(&v);
+    json_parser_destroy(p);
+}
+
+static void test_parse_reuse() {
+    json_parser* p = json_parser_create();
+    json_value v;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_parse(p, &v, "{\"a\":[1,2,{\"b\":\"c\"}]} trailing", 21));
+        EXPECT_EQ_SIZE_T(3, json_get_array_size(json_find_object_value(&v, "a", 1)));
+        json_free(&v);
+    }
+    EXPECT_EQ_INT(JSON_PARSE_ROOT_NOT_SINGULAR, json_parser_parse(p, &v, "1 2", 3));
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));
+
+    // A pending feed is dropped by a one-shot parse
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, "[1,", 3));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_parse(p, &v, "true", 4));
+    EXPECT_EQ_INT(JSON_TRUE, json_get_type(&v));
+    EXPECT_EQ_INT(JSON_PARSE_EXPECT_VALUE, json_parser_finish(p, &v));
+
+    json_parser_set_limits(p, 2, 8);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_parse(p, &v, "[[1],[]]", 8));
+    json_free(&v);
+    EXPECT_EQ_INT(JSON_PARSE_DEPTH_EXCEEDED, json_parser_parse(p, &v, "[[[]]]", 6));
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));
+    EXPECT_EQ_INT(JSON_PARSE_DEPTH_EXCEEDED, json_parser_parse(p, &v, "[{\"\":{}}]", 8));
+    EXPECT_EQ_INT(JSON_PARSE_SIZE_EXCEEDED, json_parser_parse(p, &v, "[1,2,3,4]", 9));
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));
+    EXPECT_EQ_INT(JSON_PARSE_DEPTH_EXCEEDED, json_parser_feed(p, "[[[", 3));
+    EXPECT_EQ_INT(JSON_PARSE_DEPTH_EXCEEDED, json_parser_finish(p, &v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, "[1,2,", 5));
+    EXPECT_EQ_INT(JSON_PARSE_SIZE_EXCEEDED, json_parser_feed(p, "3,4]", 4));
+    EXPECT_EQ_INT(JSON_PARSE_SIZE_EXCEEDED, json_parser_finish(p, &v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, "[1,2,", 5));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, "3]", 2));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_finish(p, &v));
+    json_free(&v);
+
+    json_parser_set_limits(p, 0, 0);
+    json_parser_use_arena(p, 1);
+    for (i = 0; i < 3; i++) {
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_parse(p, &v, "[\"abc\",{\"k\":[]}]", 16));
+        EXPECT_EQ_STRING("abc", json_get_string(json_get_array_element(&v, 0)), 3);
+        EXPECT_EQ_STRING("k", json_get_object_key(json_get_array_element(&v, 1), 0), 1);
+    }
+    json_parser_destroy(p);
+}
+
+// Large pretty-printed text goes through the structural index.
+static void test_parse_pretty() {
+    json_value v, w;
+    char* compact, *pretty = NULL, *out;
+    size_t i, len, size = 0;
+    json_set_array(&v, 0);
+    for (i = 0; i < 3000; i++) {
+        json_value e, m;
+        json_set_object(&e, 0);
+        json_set_int64(&m, (int64_t)i);
+        json_object_set(&e, "id", 2, &m);
+        json_set_string(&m, "a \"b\"\n \xC3\xA9", 9);
+        json_object_set(&e, "text", 4, &m);
+        json_set_array(&m, 0);
+        json_array_push_back(&m, NULL);
+        json_object_set(&e, "list", 4, &m);
+        json_array_push_back(&v, &e);
+    }
+    compact = json_stringify(&v, NULL);
+    len = json_stringify_to(&v, &pretty, &size, JSON_STRINGIFY_PRETTY);
+    EXPECT_TRUE(len > 65536);
+    json_free(&v);
+
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_n(&w, pretty, len));
+    out = json_stringify(&w, NULL);
+    EXPECT_TRUE(strcmp(compact, out) == 0);
+    free(out);
+    json_free(&w);
+
+    // Errors are those of the descent engine
+    pretty[len - 1] = '}';
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_parse_n(&w, pretty, len));
+    pretty[len - 1] = ']';
+    pretty[len / 2] = '\x01';
+    EXPECT_TRUE(json_parse_n(&w, pretty, len) != JSON_PARSE_OK);
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&w));
+    free(compact);
+    free(pretty);
+}
+
+static void test_parse_length() {
+    const char* json = "[1,\"abc\",{\"k\":true}] trailing";
+    char* exact;
+    json_value v;
+    size_t i, n = strlen("[1,\"abc\",{\"k\":true}]");
+    FILE* f;
+
+    json_init(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_n(&v, json, n));
+    EXPECT_EQ_SIZE_T(3, json_get_array_size(&v));
+    json_free(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_n(&v, "123456", 3));
+    EXPECT_EQ_DOUBLE(123.0, json_get_number(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_n(&v, "\"ab\"\0", 4));
+    EXPECT_EQ_STRING("ab", json_get_string(&v), json_get_string_length(&v));
+    json_free(&v);
+    EXPECT_EQ_INT(JSON_PARSE_ROOT_NOT_SINGULAR, json_parse_n(&v, "null\0", 5));
+    EXPECT_EQ_INT(JSON_PARSE_EXPECT_VALUE, json_parse_n(&v, NULL, 0));
+
+    // Every prefix of an unterminated buffer, nothing may be read past it
+    for (i = 0; i < n; i++) {
+        exact = (char*)malloc(i + 1);
+        memcpy(exact, json, i);
+        EXPECT_TRUE(json_parse_n(&v, exact, i) != JSON_PARSE_OK);
+        EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));
+        free(exact);
+    }
+    exact = (char*)malloc(n);
+    memcpy(exact, json, n);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_n(&v, exact, n));
+    json_free(&v);
+    free(exact);
+
+    f = fopen("test_parse_file.json", "wb");
+    fwrite(json, 1, n, f);
+    fclose(f);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_file(&v, "test_parse_file.json"));
+    EXPECT_EQ_SIZE_T(3, json_get_array_size(&v));
+    json_free(&v);
+    remove("test_parse_file.json");
+    EXPECT_EQ_INT(JSON_PARSE_IO_ERROR, json_parse_file(&v, "test_parse_file.json"));
+}
+
+static void test_find_object() {
+    json_value v, w, *e;
+    json_document* d;
+    json_counting_allocator a;
+    char* json, key[16];
+    size_t i, len, count, n = 1500;
+
+    json_init(&v);
+    json_init(&w);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "{\"a\":1,\"b\":2,\"\":3,\"a\":4}"));
+    EXPECT_EQ_SIZE_T(0, json_find_object_index(&v, "a", 1));
+    EXPECT_EQ_SIZE_T(1, json_find_object_index(&v, "b", 1));
+    EXPECT_EQ_SIZE_T(2, json_find_object_index(&v, "", 0));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_find_object_index(&v, "ab", 2));
+    EXPECT_TRUE(json_find_object_value(&v, "c", 1) == NULL);
+    EXPECT_EQ_DOUBLE(2.0, json_get_number(json_find_object_value(&v, "b", 1)));
+    json_free(&v);
+
+    // Wide enough to take the hashed path, with a duplicate at the end
+    json = (char*)malloc(n * 24 + 32);
+    len = 0;
+    json[len++] = '{';
+    for (i = 0; i < n; i++)
+        len += sprintf(json + len, "%s\"k%u\":%u", i ? "," : "", (unsigned)i, (unsigned)i);
+    len += sprintf(json + len, ",\"k7\":-1}");
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, json));
+    EXPECT_EQ_SIZE_T(n + 1, json_get_object_size(&v));
+    for (i = 0; i < n; i++) {
+        sprintf(key, "k%u", (unsigned)i);
+        EXPECT_EQ_SIZE_T(i, json_find_object_index(&v, key, strlen(key)));
+    }
+    EXPECT_EQ_DOUBLE(7.0, json_get_number(json_find_object_value(&v, "k7", 2)));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_find_object_index(&v, "k1500", 5));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_find_object_index(&v, "k", 1));
+
+    // Mutation keeps the index in step: erasing shifts the later members,
+    // appending adds a slot and clearing empties it
+    EXPECT_TRUE(v.u.o.index != NULL);
+    EXPECT_TRUE(json_object_remove(&v, "k0", 2));
+    EXPECT_EQ_SIZE_T(41, json_find_object_index(&v, "k42", 3));
+    EXPECT_EQ_SIZE_T(6, json_find_object_index(&v, "k7", 2));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_find_object_index(&v, "k0", 2));
+    json_set_boolean(&w, 1);
+    json_object_set(&v, "k0", 2, &w);
+    EXPECT_EQ_SIZE_T(n, json_find_object_index(&v, "k0", 2));
+    EXPECT_EQ_SIZE_T(0, json_find_object_index(&v, "k1", 2));
+    e = json_find_object_value(&v, "k42", 3);
+    json_set_string(e, "x", 1);
+    EXPECT_EQ_STRING("x", json_get_string(json_find_object_value(&v, "k42", 3)), 1);
+    json_object_clear(&v);
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_find_object_index(&v, "k42", 3));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_find_object_index(&v, "k0", 2));
+    json_free(&v);
+    // A new parse into the value starts without the old table
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, "{\"k42\":true}"));
+    EXPECT_EQ_SIZE_T(0, json_find_object_index(&v, "k42", 3));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_find_object_index(&v, "k7", 2));
+    json_free(&v);
+
+    // Document objects get their index from the arena during the parse, so
+    // lookups neither allocate nor leave anything for json_free()
+    json_counting_allocator_init(&a, NULL);
+    d = json_document_create_with(&a.allocator);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_document_parse(d, json));
+    e = json_document_root(d);
+    EXPECT_TRUE(e->u.o.index != NULL);
+    count = a.count;
+    EXPECT_EQ_SIZE_T(999, json_find_object_index(e, "k999", 4));
+    EXPECT_EQ_SIZE_T(7, json_find_object_index(e, "k7", 2));
+    EXPECT_EQ_SIZE_T(count, a.count);
+    // Erase and append keep it in step
+    EXPECT_TRUE(json_object_remove(e, "k0", 2));
+    EXPECT_EQ_SIZE_T(998, json_find_object_index(e, "k999", 4));
+    json_set_boolean(&w, 1);
+    json_object_set(e, "new", 3, &w);
+    EXPECT_EQ_SIZE_T(n, json_find_object_index(e, "new", 3));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_find_object_index(e, "k0", 2));
+    json_free(e);
+    json_document_destroy(d);
+    EXPECT_EQ_SIZE_T(0, a.current);
+    free(json);
+}
+
+static void test_parse_interned() {
+    const char* json = "[{\"id\":1,\"name\":\"a\"},{\"name\":\"b\",\"id\":2},{\"id\":{\"id\":3}}]";
+    json_symbols* y = json_symbols_create();
+    json_document* d;
+    json_value v, w, *e;
+    const char* id;
+
+    json_init(&v);
+    json_init(&w);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_interned(&v, json, y));
+    EXPECT_EQ_SIZE_T(2, json_symbols_size(y));
+    id = json_get_object_key(json_get_array_element(&v, 0), 0);
+    EXPECT_EQ_STRING("id", id, 2);
+    EXPECT_TRUE(id == json_get_object_key(json_get_array_element(&v, 1), 1));
+    e = json_get_array_element(&v, 2);
+    EXPECT_TRUE(id == json_get_object_key(e, 0));
+    EXPECT_TRUE(id == json_get_object_key(json_get_object_value(e, 0), 0));
+    EXPECT_TRUE(id == json_symbols_intern(y, "id", 2));
+
+    // A second parse with the same table shares the same keys
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_interned(&w, "{\"name\":null,\"x\":[]}", y));
+    EXPECT_EQ_SIZE_T(3, json_symbols_size(y));
+    EXPECT_TRUE(json_get_object_key(&w, 0) == json_get_object_key(json_get_array_element(&v, 1), 0));
+    EXPECT_EQ_SIZE_T(1, json_find_object_index(&w, json_symbols_intern(y, "x", 1), 1));
+    json_free(&w);
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COLON, json_parse_interned(&w, "{\"y\":1,\"z\"}", y));
+    json_free(&v);
+    EXPECT_EQ_STRING("id", id, 2);
+    json_symbols_destroy(y);
+
+    d = json_document_create();
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_document_parse(d, json));
+    e = json_document_root(d);
+    EXPECT_TRUE(json_get_object_key(json_get_array_element(e, 0), 1) == json_get_object_key(json_get_array_element(e, 1), 0));
+    json_document_destroy(d);
+}
+
+static void test_parse_tape() {
+    json_tape* t = json_tape_create();
+    size_t root, e, k;
+
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_tape_parse(t,
+        " { "
+        "\"n\" : null , "
+        "\"f\" : false , "
+        "\"t\" : true , "
+        "\"i\" : -123 , "
+        "\"d\" : 1.5 , "
+        "\"s\" : \"abc\", "
+        "\"a\" : [ 1, [ [ ] , { } ], \"x\" ],"
+        "\"o\" : { \"1\" : 1, \"2\" : 2, \"3\" : 3 }"
+        " } "
+    ));
+    root = json_tape_root(t);
+    EXPECT_EQ_INT(JSON_OBJECT, json_tape_get_type(t, root));
+    EXPECT_EQ_SIZE_T(8, json_tape_get_object_size(t, root));
+    EXPECT_EQ_STRING("n", json_tape_get_object_key(t, root, 0), json_tape_get_object_key_length(t, root, 0));
+    EXPECT_EQ_INT(JSON_NULL, json_tape_get_type(t, json_tape_get_object_value(t, root, 0)));
+    EXPECT_FALSE(json_tape_get_boolean(t, json_tape_get_object_value(t, root, 1)));
+    EXPECT_TRUE(json_tape_get_boolean(t, json_tape_get_object_value(t, root, 2)));
+    e = json_tape_get_object_value(t, root, 3);
+    EXPECT_EQ_INT(JSON_NUMBER_INT64, json_tape_get_number_type(t, e));
+    EXPECT_TRUE(json_tape_get_int64(t, e) == -123);
+    EXPECT_EQ_DOUBLE(-123.0, json_tape_get_number(t, e));
+    EXPECT_EQ_DOUBLE(1.5, json_tape_get_number(t, json_tape_get_object_value(t, root, 4)));
+    e = json_tape_get_object_value(t, root, 5);
+    EXPECT_EQ_STRING("abc", json_tape_get_string(t, e), json_tape_get_string_length(t, e));
+
+    e = json_tape_get_object_value(t, root, 6);
+    EXPECT_EQ_SIZE_T(3, json_tape_get_array_size(t, e));
+    EXPECT_EQ_DOUBLE(1.0, json_tape_get_number(t, json_tape_get_array_element(t, e, 0)));
+    k = json_tape_get_array_element(t, e, 1);
+    EXPECT_EQ_SIZE_T(2, json_tape_get_array_size(t, k));
+    EXPECT_EQ_SIZE_T(0, json_tape_get_array_size(t, json_tape_get_array_element(t, k, 0)));
+    EXPECT_EQ_SIZE_T(0, json_tape_get_object_size(t, json_tape_get_array_element(t, k, 1)));
+    // The nested array is stepped over in one hop
+    EXPECT_EQ_SIZE_T(json_tape_get_array_element(t, e, 2), json_tape_next(t, k));
+    EXPECT_EQ_STRING("x", json_tape_get_string(t, json_tape_next(t, k)), 1);
+
+    e = json_tape_get_object_value(t, root, 7);
+    for (k = json_tape_child(t, e); k != json_tape_next(t, e); k = json_tape_next(t, k + 2))
+        EXPECT_EQ_DOUBLE((double)(json_tape_get_string(t, k)[0] - '0'), json_tape_get_number(t, k + 2));
+    EXPECT_EQ_SIZE_T(json_tape_next(t, root), json_tape_next(t, e));
+
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_tape_parse(t, "18446744073709551615"));
+    EXPECT_TRUE(json_tape_get_uint64(t, json_tape_root(t)) == UINT64_MAX);
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_tape_parse(t, "[1 2]"));
+    EXPECT_EQ_INT(JSON_PARSE_ROOT_NOT_SINGULAR, json_tape_parse(t, "[] x"));
+    json_tape_destroy(t);
+}
+
+static void test_parse_snapshot() {
+    json_value v;
+    json_snapshot* s;
+    char* image;
+    char* json;
+    char key[16];
+    size_t len, root, e, k, i, sizes[17];
+
+    json_init(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v,
+        "{\"n\":null,\"f\":false,\"t\":true,\"i\":-123,\"u\":18446744073709551615,\"d\":1.5,"
+        "\"s\":\"abc\",\"a\":[1,[[],{}],\"\"],\"o\":{\"1\":1,\"2\":2,\"1\":3}}"));
+    image = json_snapshot_encode(&v, &len);
+    EXPECT_TRUE(len % 8 == 0);
+    s = json_snapshot_open_buffer(image, len);
+    EXPECT_TRUE(s != NULL);
+    root = json_snapshot_root(s);
+    EXPECT_EQ_INT(JSON_OBJECT, json_snapshot_get_type(s, root));
+    EXPECT_EQ_SIZE_T(9, json_snapshot_get_object_size(s, root));
+    EXPECT_EQ_STRING("n", json_snapshot_get_object_key(s, root, 0), json_snapshot_get_object_key_length(s, root, 0));
+    EXPECT_EQ_INT(JSON_NULL, json_snapshot_get_type(s, json_snapshot_get_object_value(s, root, 0)));
+    EXPECT_FALSE(json_snapshot_get_boolean(s, json_snapshot_get_object_value(s, root, 1)));
+    EXPECT_TRUE(json_snapshot_get_boolean(s, json_snapshot_get_object_value(s, root, 2)));
+    e = json_snapshot_get_object_value(s, root, 3);
+    EXPECT_EQ_INT(JSON_NUMBER_INT64, json_snapshot_get_number_type(s, e));
+    EXPECT_TRUE(json_snapshot_get_int64(s, e) == -123);
+    EXPECT_TRUE(json_snapshot_get_uint64(s, json_snapshot_get_object_value(s, root, 4)) == UINT64_MAX);
+    EXPECT_EQ_DOUBLE(1.5, json_snapshot_get_number(s, json_snapshot_get_object_value(s, root, 5)));
+    e = json_snapshot_get_object_value(s, root, 6);
+    EXPECT_EQ_STRING("abc", json_snapshot_get_string(s, e), json_snapshot_get_string_length(s, e));
+    EXPECT_EQ_INT('\0', json_snapshot_get_string(s, e)[3]);
+
+    e = json_snapshot_get_object_value(s, root, json_snapshot_find_object_index(s, root, "a", 1));
+    EXPECT_EQ_SIZE_T(3, json_snapshot_get_array_size(s, e));
+    EXPECT_EQ_DOUBLE(1.0, json_snapshot_get_number(s, json_snapshot_get_array_element(s, e, 0)));
+    k = json_snapshot_get_array_element(s, e, 1);
+    EXPECT_EQ_SIZE_T(0, json_snapshot_get_array_size(s, json_snapshot_get_array_element(s, k, 0)));
+    EXPECT_EQ_SIZE_T(0, json_snapshot_get_object_size(s, json_snapshot_get_array_element(s, k, 1)));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_snapshot_find_object_index(s, json_snapshot_get_array_element(s, k, 1), "a", 1));
+    EXPECT_EQ_STRING("", json_snapshot_get_string(s, json_snapshot_get_array_element(s, e, 2)), 0);
+
+    // Duplicate keys resolve to the first one, as json_find_object_index()
+    e = json_snapshot_get_object_value(s, root, 8);
+    EXPECT_EQ_SIZE_T(0, json_snapshot_find_object_index(s, e, "1", 1));
+    EXPECT_EQ_SIZE_T(1, json_snapshot_find_object_index(s, e, "2", 1));
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_snapshot_find_object_index(s, e, "3", 1));
+    json_snapshot_close(s);
+
+    // A corrupt or truncated header is refused
+    image[0] = 'X';
+    EXPECT_TRUE(json_snapshot_open_buffer(image, len) == NULL);
+    image[0] = 'M';
+    EXPECT_TRUE(json_snapshot_open_buffer(image, len - 8) == NULL);
+    free(image);
+    json_free(&v);
+
+    // Large objects are looked up through the hash index stored in the image
+    json = (char*)malloc(2000);
+    len = 0;
+    for (i = 0; i < 100; i++)
+        len += sprintf(json + len, "%c\"k%zu\":%zu", i == 0 ? '{' : ',', i, i);
+    json[len++] = '}';
+    json[len] = '\0';
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, json));
+    free(json);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_snapshot_write(&v, "test_parse_snapshot.bin"));
+    json_free(&v);
+    s = json_snapshot_open("test_parse_snapshot.bin");
+    EXPECT_TRUE(s != NULL);
+    root = json_snapshot_root(s);
+    EXPECT_EQ_SIZE_T(100, json_snapshot_get_object_size(s, root));
+    for (i = 0; i < 100; i++) {
+        k = json_snapshot_find_object_index(s, root, key, (size_t)sprintf(key, "k%zu", i));
+        EXPECT_EQ_SIZE_T(i, k);
+        EXPECT_EQ_DOUBLE((double)i, json_snapshot_get_number(s, json_snapshot_get_object_value(s, root, k)));
+    }
+    EXPECT_EQ_SIZE_T(JSON_KEY_NOT_EXIST, json_snapshot_find_object_index(s, root, "k100", 4));
+    json_snapshot_close(s);
+    remove("test_parse_snapshot.bin");
+    EXPECT_TRUE(json_snapshot_open("test_parse_snapshot.bin") == NULL);
+
+    // The table starts at the same size as the in-memory index: up to 16 keys
+    // each member costs the same, the 17th brings the table along
+    json_set_object(&v, 0);
+    for (i = 0; i < 17; i++) {
+        json_object_set(&v, key, (size_t)sprintf(key, "k%zu", i + 10), NULL);
+        image = json_snapshot_encode(&v, &sizes[i]);
+        free(image);
+    }
+    EXPECT_EQ_SIZE_T(sizes[14] - sizes[13], sizes[15] - sizes[14]);
+    EXPECT_TRUE(sizes[16] - sizes[15] > sizes[15] - sizes[14]);
+    json_free(&v);
+}
+
+static void test_parse_lazy() {
+    const char* json =
+        "{ \"id\" : 7, \"skip\" : [ { \"a\" : \"]}\" }, [ [ ] ], \"[\" ],"
+        " \"name\" : \"abc\", \"list\" : [ 1, 2, 3 ], \"bad\" : [ 1 2 ] }";
+    json_lazy root, e, k;
+    json_lazy_iter it;
+    json_value v;
+    size_t n;
+
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_parse(&root, json, strlen(json)));
+    EXPECT_EQ_INT(JSON_OBJECT, json_lazy_get_type(&root));
+    EXPECT_TRUE(json_lazy_find(&root, "name", 4, &e));
+    EXPECT_EQ_INT(JSON_STRING, json_lazy_get_type(&e));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_get_value(&e, &v));
+    EXPECT_EQ_STRING("abc", json_get_string(&v), json_get_string_length(&v));
+    json_free(&v);
+    EXPECT_TRUE(json_lazy_find(&root, "id", 2, &e));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_get_value(&e, &v));
+    EXPECT_EQ_DOUBLE(7.0, json_get_number(&v));
+    EXPECT_FALSE(json_lazy_find(&root, "a", 1, &e));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_parse(&k, "{\"t\\u0061b\":\"\\t\"}", 17));
+    EXPECT_TRUE(json_lazy_find(&k, "tab", 3, &e));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_get_value(&e, &v));
+    EXPECT_EQ_STRING("\t", json_get_string(&v), json_get_string_length(&v));
+    json_free(&v);
+
+    EXPECT_TRUE(json_lazy_find(&root, "list", 4, &e));
+    EXPECT_TRUE(json_lazy_index(&e, 2, &k));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_get_value(&k, &v));
+    EXPECT_EQ_DOUBLE(3.0, json_get_number(&v));
+    EXPECT_FALSE(json_lazy_index(&e, 3, &k));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_get_value(&e, &v));
+    EXPECT_EQ_SIZE_T(3, json_get_array_size(&v));
+    json_free(&v);
+
+    // Brackets inside strings do not count
+    EXPECT_TRUE(json_lazy_find(&root, "skip", 4, &e));
+    json_lazy_iterate(&e, &it);
+    for (n = 0; json_lazy_next(&it, NULL, &k); n++)
+        ;
+    EXPECT_EQ_SIZE_T(3, n);
+    EXPECT_EQ_INT(JSON_PARSE_OK, it.error);
+
+    // Malformed parts are only reported once they are walked
+    EXPECT_TRUE(json_lazy_find(&root, "bad", 3, &e));
+    json_lazy_iterate(&e, &it);
+    EXPECT_TRUE(json_lazy_next(&it, NULL, &k));
+    EXPECT_FALSE(json_lazy_next(&it, NULL, &k));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, it.error);
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_lazy_get_value(&e, &v));
+
+    json_lazy_iterate(&root, &it);
+    EXPECT_TRUE(json_lazy_next(&it, &k, &e));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_get_value(&k, &v));
+    EXPECT_EQ_STRING("id", json_get_string(&v), json_get_string_length(&v));
+    json_free(&v);
+
+    EXPECT_EQ_INT(JSON_PARSE_EXPECT_VALUE, json_lazy_parse(&root, " ", 1));
+    EXPECT_EQ_INT(JSON_PARSE_ROOT_NOT_SINGULAR, json_lazy_parse(&root, "[] 1", 4));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_lazy_parse(&root, "[[1]", 4));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_QUOTATION_MARK, json_lazy_parse(&root, "\"abc", 4));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_lazy_parse(&root, "{}", 2));
+    EXPECT_FALSE(json_lazy_find(&root, "", 0, &e));
+}
+
+#define TEST_NDJSON_LINES 20000
+
+typedef struct {
+    int ret[TEST_NDJSON_LINES];
+    double n[TEST_NDJSON_LINES];
+    size_t calls, stop_at, late;
+    int stopped, waiting;
+} ndjson_log;
+
+// Called concurrently, only touches the slot of its own line.
+static int ndjson_record(void* user, size_t line, int ret, json_value* v) {
+    ndjson_log* log = (ndjson_log*)user;
+    log->ret[line] = ret;
+    if (ret == JSON_PARSE_OK)
+        log->n[line] = json_get_number(json_find_object_value(v, "n", 1));
+    return 0;
+}
+
+// Single-threaded runs only.
+static int ndjson_count(void* user, size_t line, int ret, json_value* v) {
+    ndjson_log* log = (ndjson_log*)user;
+    log->calls++;
+    return line == log->stop_at;
+}
+
+#if defined(__GNUC__)
+// Stops at stop_at while another worker waits in the middle of a later
+// batch, and counts the calls made after that.
+static int ndjson_late(void* user, size_t line, int ret, json_value* v) {
+    ndjson_log* log = (ndjson_log*)user;
+    long spin;
+    if (__atomic_load_n(&log->stopped, __ATOMIC_ACQUIRE))
+        __atomic_fetch_add(&log->late, 1, __ATOMIC_RELAXED);
+    if (line == log->stop_at) {
+        for (spin = 0; spin < 1000000000 && !__atomic_load_n(&log->waiting, __ATOMIC_ACQUIRE); spin++)
+            ;
+        __atomic_store_n(&log->stopped, 1, __ATOMIC_RELEASE);
+        return 1;
+    }
+    if (line > log->stop_at + TEST_NDJSON_LINES / 4 && !__atomic_exchange_n(&log->waiting, 1, __ATOMIC_ACQ_REL))
+        for (spin = 0; spin < 1000000000 && !__atomic_load_n(&log->stopped, __ATOMIC_ACQUIRE); spin++)
+            ;
+    return 0;
+}
+#endif
+
+#define TEST_PROJECTED(expect, json, ...)\
+    do {\
+        const char* paths[] = { __VA_ARGS__ };\
+        json_projection* p = json_projection_create(paths, sizeof(paths) / sizeof(paths[0]));\
+        json_value v;\
+        char* json2;\
+        size_t length;\
+        EXPECT_TRUE(p != NULL);\
+        EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_projected(&v, json, strlen(json), p));\
+        json2 = json_stringify(&v, &length);\
+        EXPECT_EQ_STRING(expect, json2, length);\
+        free(json2);\
+        json_free(&v);\
+        json_projection_destroy(p);\
+    } while(0)
+
+#define TEST_PROJECTED_ERROR(error, json, path)\
+    do {\
+        const char* paths[] = { path };\
+        json_projection* p = json_projection_create(paths, 1);\
+        json_value v;\
+        EXPECT_EQ_INT(error, json_parse_projected(&v, json, strlen(json), p));\
+        EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));\
+        json_projection_destroy(p);\
+    } while(0)
+
+static void test_parse_projected() {
+    const char* json =
+        "{\"user\":{\"id\":7,\"name\":\"x\",\"tags\":[\"a\",{\"b\":[]}]},"
+        "\"items\":[{\"price\":1.5,\"qty\":2},{\"qty\":1},3,{\"price\":[4]}],"
+        "\"a/b\":{\"m~n\":true},\"*\":null}";
+    const char* bad[] = { "/a", "a" };
+
+    TEST_PROJECTED("{\"user\":{\"id\":7},\"items\":[{\"price\":1.5},{},{\"price\":[4]}]}", json,
+        "/user/id", "/items/*/price");
+    TEST_PROJECTED("{\"user\":{\"name\":\"x\"}}", json, "/user/name", "/missing/path");
+    TEST_PROJECTED("{\"a/b\":{\"m~n\":true}}", json, "/a~1b/m~0n");
+    TEST_PROJECTED("{\"items\":[{\"qty\":1}]}", json, "/items/1");
+    TEST_PROJECTED("{\"user\":{\"tags\":[{\"b\":[]}]}}", json, "/user/tags/1/b/0", "/user/tags/1/b");
+    // A path ending higher up keeps everything under it
+    TEST_PROJECTED("{\"user\":{\"id\":7,\"name\":\"x\",\"tags\":[\"a\",{\"b\":[]}]}}", json,
+        "/user/id", "/user", "/user/tags/*");
+    // Specific tokens also get what the wildcard asks for
+    TEST_PROJECTED("[{\"x\":1,\"y\":2},{\"x\":3}]", "[{\"x\":1,\"y\":2},{\"x\":3,\"y\":4}]", "/*/x", "/0/y");
+    TEST_PROJECTED("[{\"x\":1,\"y\":2},{\"x\":3}]", "[{\"x\":1,\"y\":2},{\"x\":3,\"y\":4}]", "/0/y", "/*/x");
+    TEST_PROJECTED("{\"0\":1}", "{\"0\":1,\"1\":2}", "/0");
+    TEST_PROJECTED("{\"user\":{\"tags\":[\"a\",{\"b\":[]}]},\"items\":[{\"price\":1.5,\"qty\":2},{\"qty\":1},{\"price\":[4]}],"
+        "\"a/b\":{}}", json, "/*/*/*");
+    TEST_PROJECTED("[1,{\"a\":2}]", " [1,{\"a\":2}] ", "");
+    TEST_PROJECTED("[]", "[1,2]", "/a");
+    TEST_PROJECTED("null", "5", "/a");
+
+    EXPECT_TRUE(json_projection_create(bad, 2) == NULL);
+    bad[0] = "/a~2";
+    EXPECT_TRUE(json_projection_create(bad, 1) == NULL);
+
+    // Errors come from kept and skipped parts alike
+    TEST_PROJECTED_ERROR(JSON_PARSE_ROOT_NOT_SINGULAR, "{\"a\":1} x", "/a");
+    TEST_PROJECTED_ERROR(JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1 \"b\":2}", "/a");
+    TEST_PROJECTED_ERROR(JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{\"c\":1}", "/b");
+    TEST_PROJECTED_ERROR(JSON_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "{\"b\":[1,2", "/a");
+    TEST_PROJECTED_ERROR(JSON_PARSE_MISS_QUOTATION_MARK, "{\"b\":\"abc}", "/a");
+    TEST_PROJECTED_ERROR(JSON_PARSE_INVALID_VALUE, "{\"b\":tru,\"a\":1}", "/a");
+    TEST_PROJECTED_ERROR(JSON_PARSE_INVALID_VALUE, "[{\"a\":[1,2]},{\"a\":[1,?]}]", "/*/a");
+    TEST_PROJECTED_ERROR(JSON_PARSE_MISS_KEY, "{\"a\":{1:2}}", "/a/b");
+    TEST_PROJECTED_ERROR(JSON_PARSE_MISS_COLON, "{\"a\":{\"b\",2}}", "/a/b");
+    TEST_PROJECTED_ERROR(JSON_PARSE_EXPECT_VALUE, "{\"a\":", "/a");
+    TEST_PROJECTED_ERROR(JSON_PARSE_EXPECT_VALUE, "", "/a");
+}
+
+static void test_parse_ndjson() {
+    ndjson_log* log = (ndjson_log*)malloc(sizeof(ndjson_log));
+    char* buf = (char*)malloc(TEST_NDJSON_LINES * 32);
+    size_t i, len = 0, ok = 1;
+
+    // Enough lines for several batches, with a blank line, a CRLF line and
+    // a bad line, and no newline at the very end
+    for (i = 0; i < TEST_NDJSON_LINES; i++) {
+        if (i == 10)
+            len += sprintf(buf + len, "  \n");
+        else if (i == 11)
+            len += sprintf(buf + len, "{\"n\":%u,\"s\":\"x\"}\r\n", (unsigned)i);
+        else if (i == 12345)
+            len += sprintf(buf + len, "{\"n\":}\n");
+        else
+            len += sprintf(buf + len, "{\"n\":%u,\"s\":\"x\"}%s", (unsigned)i, i + 1 < TEST_NDJSON_LINES ? "\n" : "");
+    }
+
+    memset(log, 0, sizeof(ndjson_log));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_ndjson(buf, len, 4, ndjson_record, log));
+    for (i = 0; i < TEST_NDJSON_LINES; i++) {
+        if (i == 10)
+            ok &= log->ret[i] == 0 && log->n[i] == 0.0;
+        else if (i == 12345)
+            ok &= log->ret[i] == JSON_PARSE_INVALID_VALUE;
+        else
+            ok &= log->ret[i] == JSON_PARSE_OK && log->n[i] == (double)i;
+    }
+    EXPECT_TRUE(ok);
+
+    log->calls = 0;
+    log->stop_at = 5;
+    EXPECT_EQ_INT(JSON_PARSE_ABORTED, json_parse_ndjson(buf, len, 1, ndjson_count, log));
+    EXPECT_EQ_SIZE_T(6, log->calls);
+
+#if defined(__GNUC__)
+    // Other workers stop within the line they are on, not at their batch end:
+    // at most the one call each of them had already started
+    log->stop_at = 100;
+    log->stopped = 0;
+    log->waiting = 0;
+    log->late = 0;
+    EXPECT_EQ_INT(JSON_PARSE_ABORTED, json_parse_ndjson(buf, len, 4, ndjson_late, log));
+    EXPECT_TRUE(log->stopped);
+    EXPECT_TRUE(log->late <= 3);
+#endif
+
+    log->calls = 0;
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_ndjson("\n \n", 3, 1, ndjson_count, log));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_ndjson(NULL, 0, 1, ndjson_count, log));
+    EXPECT_EQ_SIZE_T(0, log->calls);
+    free(buf);
+    free(log);
+}
+
+static void test_parse_parallel() {
+    size_t i, len, n = 200000, ok = 1;
+    char* json = (char*)malloc(n * 32);
+    json_value v, w;
+
+    // Past the serial threshold, with strings that look like separators
+    len = sprintf(json, " [ ");
+    for (i = 0; i < n; i++)
+        len += sprintf(json + len, i % 3 ? "%u ,\n" : "[\"],[\",%u], ", (unsigned)i);
+    len += sprintf(json + len, "{} ] ");
+    json_init(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_parallel(&v, json, len, 4));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_n(&w, json, len));
+    EXPECT_EQ_SIZE_T(n + 1, json_get_array_size(&v));
+    for (i = 0; i < n; i++) {
+        json_value* e = json_get_array_element(&v, i);
+        if (i % 3)
+            ok &= json_get_number(e) == (double)i;
+        else
+            ok &= json_get_number(json_get_array_element(e, 1)) == (double)i;
+    }
+    EXPECT_TRUE(ok);
+    EXPECT_EQ_INT(JSON_OBJECT, json_get_type(json_get_array_element(&v, n)));
+    json_free(&v);
+    json_free(&w);
+
+    // Errors anywhere are reported as by the serial parser
+    json[len - 2] = ',';
+    EXPECT_EQ_INT(JSON_PARSE_EXPECT_VALUE, json_parse_parallel(&v, json, len, 4));
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));
+    json[len - 2] = ']';
+    json[len / 2] = '?';
+    EXPECT_EQ_INT(json_parse_n(&w, json, len), json_parse_parallel(&v, json, len, 4));
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&v));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse_parallel(&v, "[1,2]", 5, 4));
+    EXPECT_EQ_SIZE_T(2, json_get_array_size(&v));
+    json_free(&v);
+    free(json);
+}
+
+static void test_allocator() {
+    json_counting_allocator a, g;
+    json_parser* p;
+    json_document* d;
+    json_value v, w, *e;
+    char json[1024];
+    size_t i;
+
+    json_init(&v);
+    json_init(&w);
+    // A wide array grows the scratch stack with realloc()
+    json[0] = '[';
+    for (i = 1; i < 1000; i += 2) {
+        json[i] = '0';
+        json[i + 1] = ',';
+    }
+    json[1000] = ']';
+    json[1001] = '\0';
+
+    json_counting_allocator_init(&a, NULL);
+    json_set_allocator(&a.allocator);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parse(&v, json));
+    EXPECT_TRUE(a.count > 0);
+    EXPECT_TRUE(a.reallocs > 0);
+    EXPECT_TRUE(a.peak >= a.current && a.current > 0);
+    json_free(&v);
+    EXPECT_EQ_SIZE_T(0, a.current);
+    json_set_allocator(NULL);
+
+    json_counting_allocator_init(&a, NULL);
+    p = json_parser_create_with(&a.allocator);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_parse(p, &v, json, 1001));
+    EXPECT_TRUE(a.reallocs > 0);
+    json_free(&v);
+    json_parser_use_arena(p, 1);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_parse(p, &v, "{\"a\":[1,2]}", 11));
+    EXPECT_EQ_SIZE_T(2, json_get_array_size(json_find_object_value(&v, "a", 1)));
+    json_parser_destroy(p);
+    EXPECT_EQ_SIZE_T(0, a.current);
+
+    // Parse, growth and free of a parser's tree stay on its allocator, the
+    // default one is never asked
+    json_counting_allocator_init(&a, NULL);
+    json_counting_allocator_init(&g, NULL);
+    p = json_parser_create_with(&a.allocator);
+    json_set_allocator(&g.allocator);
+    json_parser_use_arena(p, 0);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_parse(p, &v, "{\"a\":[1,2],\"b\":\"x\",\"c\":{}}", 26));
+    e = json_find_object_value(&v, "a", 1);
+    for (i = 0; i < 100; i++) {
+        json_set_int64(&w, (int64_t)i);
+        json_array_push_back(e, &w);
+    }
+    EXPECT_EQ_SIZE_T(102, json_get_array_size(e));
+    for (i = 0; i < 40; i++) {
+        char k[8];
+        json_set_boolean(&w, 1);
+        json_object_set(&v, k, sprintf(k, "k%u", (unsigned)i), &w);
+    }
+    EXPECT_EQ_SIZE_T(42, json_find_object_index(&v, "k39", 3));
+    EXPECT_EQ_SIZE_T(1, json_find_object_index(&v, "b", 1));
+    json_set_null(&w);
+    json_object_set(json_find_object_value(&v, "c", 1), "z", 1, &w);
+    json_free(&v);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, "[{\"k\":\"v\"},", 11));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_feed(p, "[]]", 3));
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_parser_finish(p, &v));
+    json_array_push_back(json_get_array_element(&v, 1), &w);
+    EXPECT_EQ_SIZE_T(1, json_get_array_size(json_get_array_element(&v, 1)));
+    json_free(&v);
+    EXPECT_EQ_SIZE_T(0, g.count);
+    json_set_allocator(NULL);
+    EXPECT_TRUE(a.count > 0);
+    json_parser_destroy(p);
+    EXPECT_EQ_SIZE_T(0, a.current);
+
+    json_counting_allocator_init(&a, NULL);
+    d = json_document_create_with(&a.allocator);
+    EXPECT_EQ_INT(JSON_PARSE_OK, json_document_parse(d, "{\"a\":\"b\",\"c\":[true]}"));
+    EXPECT_EQ_INT(JSON_OBJECT, json_get_type(json_document_root(d)));
+    EXPECT_TRUE(a.bytes > 0 && a.peak > 0);
+    json_document_destroy(d);
+    EXPECT_EQ_SIZE_T(0, a.current);
+}
+
 static void test_parse() {
     test_parse_null();
     test_parse_expect_value();
@@ -289,12 +1860,22 @@ static void test_parse() {
     test_parse_false();
 
     test_parse_number();
+    test_parse_integer();
+    test_parse_number_too_big();
 
     test_access_string();
+    test_access_ownership();
     test_parse_string();
+    test_parse_invalid_string_escape();
+    test_parse_invalid_string_char();
+    test_parse_invalid_unicode_hex();
+    test_parse_invalid_unicode_surrogate();
+    test_parse_utf8();
 
     test_access_boolean();
     test_access_number();
+    test_access_array();
+    test_access_object();
 
     test_parse_array();
 
@@ -302,10 +1883,28 @@ static void test_parse() {
     test_parse_miss_key();
     test_parse_miss_colon();
     test_parse_miss_comma_or_curly_bracket();
+    test_find_object();
+
+    test_parse_document();
+    test_parse_insitu();
+    test_parse_interned();
+    test_parse_tape();
+    test_parse_snapshot();
+    test_parse_lazy();
+    test_parse_projected();
+    test_parse_ndjson();
+    test_parse_parallel();
+    test_allocator();
+    test_parse_sax();
+    test_parse_incremental();
+    test_parse_reuse();
+    test_parse_length();
+    test_parse_pretty();
 }
 
 int main() {
     test_parse();
+    test_stringify();
     printf("%d/%d (%3.2f%%) passed\n", test_pass, test_count, test_pass * 100.0 / test_count);
     return main_ret;
 }
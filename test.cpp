@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "myjson.hpp"
+
+static int main_ret = 0;
+static int test_count = 0;
+static int test_pass = 0;
+
+#define EXPECT_EQ_BASE(equality, expect, actual, format) \
+    do {\
+        test_count++;\
+        if (equality)\
+            test_pass++;\
+        else {\
+            fprintf(stderr, "%s:%d: expect: " format " actual: " format "\n", __FILE__, __LINE__, expect, actual);\
+            main_ret = 1;\
+        }\
+    } while(0)
+
+#define EXPECT_EQ_INT(expect, actual) EXPECT_EQ_BASE((expect) == (actual), expect, actual, "%d")
+#define EXPECT_EQ_DOUBLE(expect, actual) EXPECT_EQ_BASE((expect) == (actual), expect, actual, "%.17g")
+#define EXPECT_EQ_STRING(expect, actual) \
+    EXPECT_EQ_BASE(std::string(expect) == (actual), std::string(expect).c_str(), std::string(actual).c_str(), "%s")
+#define EXPECT_TRUE(actual) EXPECT_EQ_BASE((actual) != 0, "true", "false", "%s")
+#define EXPECT_FALSE(actual) EXPECT_EQ_BASE((actual) == 0, "false", "true", "%s")
+#define EXPECT_EQ_SIZE_T(expect, actual) EXPECT_EQ_BASE((expect) == (actual), (size_t)(expect), (size_t)(actual), "%zu")
+
+struct point {
+    double x, y;
+};
+
+template <>
+struct myjson::fields<point> {
+    static constexpr auto value = std::make_tuple(MYJSON_FIELD(point, x), MYJSON_FIELD(point, y));
+};
+
+struct request {
+    int64_t id = 0;
+    std::string method;
+    std::vector<point> path;
+    std::vector<std::vector<int>> grid;
+    std::optional<std::string> trace;
+    std::optional<point> origin;
+    bool urgent = false;
+    uint8_t priority = 0;
+};
+
+template <>
+struct myjson::fields<request> {
+    static constexpr auto value = std::make_tuple(
+        MYJSON_FIELD(request, id), MYJSON_FIELD(request, method), MYJSON_FIELD(request, path),
+        MYJSON_FIELD(request, grid), MYJSON_FIELD(request, trace), MYJSON_FIELD(request, origin),
+        myjson::field("is_urgent", &request::urgent), MYJSON_FIELD(request, priority));
+};
+
+struct empty {};
+
+template <>
+struct myjson::fields<empty> {
+    static constexpr auto value = std::make_tuple();
+};
+
+static void test_bind_struct() {
+    request r;
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse(
+        "{\"id\":42,\"method\":\"move\",\"unknown\":{\"a\":[1,{\"b\":null}]},"
+        "\"path\":[{\"x\":1,\"y\":2.5},{\"y\":-1,\"x\":0}],\"grid\":[[1,2],[],[3]],"
+        "\"trace\":\"t-1\",\"origin\":null,\"is_urgent\":true,\"priority\":255}", r));
+    EXPECT_TRUE(r.id == 42);
+    EXPECT_EQ_STRING("move", r.method);
+    EXPECT_EQ_SIZE_T(2, r.path.size());
+    EXPECT_EQ_DOUBLE(2.5, r.path[0].y);
+    EXPECT_EQ_DOUBLE(-1.0, r.path[1].y);
+    EXPECT_EQ_SIZE_T(3, r.grid.size());
+    EXPECT_EQ_SIZE_T(0, r.grid[1].size());
+    EXPECT_EQ_INT(3, r.grid[2][0]);
+    EXPECT_TRUE(r.trace.has_value());
+    EXPECT_EQ_STRING("t-1", *r.trace);
+    EXPECT_FALSE(r.origin.has_value());
+    EXPECT_TRUE(r.urgent);
+    EXPECT_EQ_INT(255, r.priority);
+
+    // Missing keys keep their member, present ones replace it
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse("{\"origin\":{\"x\":3,\"y\":4},\"trace\":null,\"path\":[]}", r));
+    EXPECT_TRUE(r.origin.has_value());
+    EXPECT_EQ_DOUBLE(4.0, r.origin->y);
+    EXPECT_FALSE(r.trace.has_value());
+    EXPECT_EQ_SIZE_T(0, r.path.size());
+    EXPECT_EQ_STRING("move", r.method);
+
+    empty e;
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse("{\"a\":1}", e));
+}
+
+static void test_bind_values() {
+    std::vector<std::optional<int>> v;
+    std::string s;
+    double d = 0;
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse("[1,null,-3]", v));
+    EXPECT_EQ_SIZE_T(3, v.size());
+    EXPECT_FALSE(v[1].has_value());
+    EXPECT_EQ_INT(-3, *v[2]);
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse("\"abc\"", s));
+    EXPECT_EQ_STRING("abc", s);
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse("\"a\\nb\\u00E9\\ud834\\udd1e\"", s));
+    EXPECT_EQ_STRING("a\nb\xC3\xA9\xF0\x9D\x84\x9E", s);
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse("1e3", d));
+    EXPECT_EQ_DOUBLE(1000.0, d);
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse("7", d));
+    EXPECT_EQ_DOUBLE(7.0, d);
+}
+
+static void test_bind_error() {
+    request r;
+    int i;
+    unsigned u;
+    EXPECT_EQ_INT(myjson::PARSE_TYPE_MISMATCH, myjson::parse("{\"id\":\"42\"}", r));
+    EXPECT_EQ_INT(myjson::PARSE_TYPE_MISMATCH, myjson::parse("{\"path\":[{\"x\":true}]}", r));
+    EXPECT_EQ_INT(myjson::PARSE_TYPE_MISMATCH, myjson::parse("{\"priority\":256}", r));
+    EXPECT_EQ_INT(myjson::PARSE_TYPE_MISMATCH, myjson::parse("{\"grid\":[1]}", r));
+    EXPECT_EQ_INT(myjson::PARSE_TYPE_MISMATCH, myjson::parse("[]", r));
+    EXPECT_EQ_INT(myjson::PARSE_TYPE_MISMATCH, myjson::parse("1.5", i));
+    EXPECT_EQ_INT(myjson::PARSE_TYPE_MISMATCH, myjson::parse("-1", u));
+    EXPECT_EQ_INT(myjson::PARSE_TYPE_MISMATCH, myjson::parse("2147483648", i));
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse("-2147483648", i));
+    EXPECT_EQ_INT(JSON_PARSE_MISS_COMMA_OR_CURLY_BRACKET, myjson::parse("{\"id\":1", r));
+    EXPECT_EQ_INT(JSON_PARSE_ROOT_NOT_SINGULAR, myjson::parse("{} x", r));
+}
+
+// Length-delimited buffers are bound in place, without a terminator.
+static void test_bind_view() {
+    request r;
+    std::vector<char> buf;
+    const std::string frame = "{\"id\":9,\"method\":\"ping\"}";
+    buf.assign(frame.begin(), frame.end());
+    buf.push_back('x');
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse(std::string_view(buf.data(), frame.size()), r));
+    EXPECT_TRUE(r.id == 9);
+    EXPECT_EQ_STRING("ping", r.method);
+    EXPECT_EQ_INT(JSON_PARSE_ROOT_NOT_SINGULAR, myjson::parse(std::string_view(buf.data(), buf.size()), r));
+    EXPECT_EQ_INT(JSON_PARSE_OK, myjson::parse(frame, r));
+}
+
+static myjson::value make_value(const char* json) {
+    myjson::value v;
+    EXPECT_EQ_INT(JSON_PARSE_OK, v.parse(json));
+    return v;
+}
+
+static void test_value() {
+    myjson::value v = make_value("{\"a\":[1,\"x\",true],\"b\":{\"c\":null},\"d\":-2}");
+    myjson::value w;
+    size_t n = 0;
+
+    EXPECT_EQ_INT(JSON_OBJECT, v.type());
+    EXPECT_EQ_SIZE_T(3, v.size());
+    EXPECT_TRUE(v.find("a").has_value());
+    EXPECT_FALSE(v.find("z").has_value());
+    EXPECT_TRUE(v.find("d")->get_int64() == -2);
+    myjson::view a = *v.find("a");
+    EXPECT_EQ_DOUBLE(1.0, a[0].get_number());
+    EXPECT_TRUE(a[1].get_string() == "x");
+    EXPECT_TRUE(a[2].get_bool());
+    for (myjson::view e : a.elements())
+        n += e.type() == JSON_ARRAY ? 100 : 1;
+    EXPECT_EQ_SIZE_T(3, n);
+    std::string keys;
+    for (myjson::member m : v.members())
+        keys += m.key;
+    EXPECT_EQ_STRING("abd", keys);
+    EXPECT_TRUE(myjson::view(v.find("b")->get()).find("c")->is_null());
+
+    // Moves leave the source null, clone() is a deep copy
+    w = std::move(v);
+    EXPECT_TRUE(v.is_null());
+    myjson::value c = w.clone();
+    EXPECT_EQ_STRING(w.stringify(), c.stringify());
+    myjson::value child(json_find_object_value(c.get(), "a", 1));
+    EXPECT_EQ_SIZE_T(3, child.size());
+    EXPECT_TRUE(c.find("a")->is_null());
+    EXPECT_EQ_SIZE_T(3, w.find("a")->size());
+    child = std::move(child);
+    EXPECT_EQ_SIZE_T(3, child.size());
+
+    // Strings handed over and borrowed without copies
+    char* s = static_cast<char*>(std::malloc(3));
+    std::memcpy(s, "hi", 3);
+    v.set_string_owned(s, 2);
+    EXPECT_TRUE(v.get_string().data() == s);
+    static const char text[] = "static";
+    v.set_string_borrowed(text, 6);
+    EXPECT_TRUE(v.get_string().data() == text);
+    v.set_string("copy");
+    EXPECT_TRUE(v.get_string() == "copy");
+    json_value raw = v.release();
+    EXPECT_TRUE(v.is_null());
+    myjson::value back(&raw);
+    EXPECT_TRUE(back.get_string() == "copy");
+    EXPECT_EQ_INT(JSON_NULL, json_get_type(&raw));
+    v.set_int64(5);
+    EXPECT_EQ_STRING("5", v.stringify());
+
+    EXPECT_EQ_INT(JSON_PARSE_ROOT_NOT_SINGULAR, v.parse("[] x"));
+    EXPECT_TRUE(v.is_null());
+}
+
+static void test_value_build() {
+    myjson::value o, a, e;
+    o.set_object();
+    a.set_array();
+    a.reserve(1000);
+    for (int i = 0; i < 1000; i++) {
+        e.set_int64(i);
+        a.push_back(std::move(e));
+    }
+    EXPECT_TRUE(e.is_null());
+    EXPECT_EQ_SIZE_T(1000, json_get_array_capacity(a.get()));
+    o.set("list", std::move(a));
+    e.set_string("v");
+    o.set("k", std::move(e));
+    EXPECT_EQ_SIZE_T(1000, o.find("list")->size());
+    EXPECT_TRUE(o.remove("list"));
+    EXPECT_FALSE(o.remove("list"));
+    EXPECT_EQ_STRING("{\"k\":\"v\"}", o.stringify());
+}
+
+// Buffers handed out go back through the installed allocator.
+static void test_value_allocator() {
+    json_counting_allocator a;
+    json_counting_allocator_init(&a, nullptr);
+    json_set_allocator(&a.allocator);
+    {
+        myjson::value v = make_value("{\"a\":[1,2],\"b\":\"x\"}");
+        EXPECT_EQ_STRING("{\"a\":[1,2],\"b\":\"x\"}", v.stringify());
+        size_t len;
+        json_value s;
+        json_init(&s);
+        json_set_string(&s, "abc", 3);
+        json_free_buffer(json_take_string(&s, &len));
+    }
+    EXPECT_TRUE(a.count > 0);
+    EXPECT_EQ_SIZE_T(0, a.current);
+    json_set_allocator(nullptr);
+}
+
+int main() {
+    test_bind_struct();
+    test_bind_values();
+    test_bind_error();
+    test_bind_view();
+    test_value();
+    test_value_build();
+    test_value_allocator();
+    printf("%d/%d (%3.2f%%) passed\n", test_pass, test_count, test_pass * 100.0 / test_count);
+    return main_ret;
+}